@@ -0,0 +1,96 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_bench_cold.c
+ *
+ * \brief a hot loop with logging statements, with and without
+ * ULOG_COLD_CALLS.  Build both and compare time and code size:
+ *
+ *     cc -O2 -Isrc bench/ulog_bench_cold.c src/ulog.c -o ulog_bench_cold
+ *     cc -O2 -DULOG_COLD_CALLS=0 -Isrc bench/ulog_bench_cold.c src/ulog.c \
+ *        -o ulog_bench_inline
+ *     ./ulog_bench_cold [rounds]; ./ulog_bench_inline [rounds]
+ *     nm -S ulog_bench_cold ulog_bench_inline | grep checksum
+ *
+ * With cold calls, checksum() keeps only the level tests and the logging
+ * calls move to checksum.cold.  perf stat -e L1-icache-load-misses shows the
+ * instruction cache effect.
+ */
+
+#include "ulog.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BLOCK_SIZE 4096
+
+static uint8_t block[BLOCK_SIZE];
+static volatile size_t sink;
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// stands in for a cheap subscriber such as a memory buffer
+static void null_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  sink += msg[0];
+}
+
+// Fletcher-16 over data, logging as real code tends to
+uint16_t checksum(const uint8_t *data, int len) {
+  uint16_t sum1 = 0;
+  uint16_t sum2 = 0;
+  for (int i=0; i<len; i++) {
+    sum1 = (sum1 + data[i]) % 255;
+    sum2 = (sum2 + sum1) % 255;
+    ULOG_TRACE("byte %d of %d: %02x sums %u %u", i, len, data[i], sum1, sum2);
+    if (data[i] == 0xff && sum1 == 0) {
+      ULOG_WARNING("sum wrapped at %d of %d (%u)", i, len, sum2);
+    }
+  }
+  ULOG_DEBUG("checksum of %d bytes at %p: %04x", len, (void *)data, (sum2 << 8) | sum1);
+  return (uint16_t)((sum2 << 8) | sum1);
+}
+
+int main(int argc, char **argv) {
+  int rounds = (argc > 1) ? atoi(argv[1]) : 10000;
+
+  for (int i=0; i<BLOCK_SIZE; i++) {
+    block[i] = (uint8_t)(i * 7);
+  }
+  ULOG_INIT();
+  ULOG_SUBSCRIBE(null_logger, ULOG_ERROR_LEVEL);
+
+  double start = seconds();
+  for (int i=0; i<rounds; i++) {
+    sink += checksum(block, BLOCK_SIZE);
+  }
+  double elapsed = seconds() - start;
+  printf("ULOG_COLD_CALLS=%d: %.3f ns/byte\n",
+         ULOG_COLD_CALLS, elapsed * 1e9 / ((double)rounds * BLOCK_SIZE));
+  return 0;
+}
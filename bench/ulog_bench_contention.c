@@ -0,0 +1,113 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_bench_contention.c
+ *
+ * \brief uLog throughput and lock contention with 1..N logging threads.
+ *
+ * Build and run on a POSIX host:
+ *
+ *     cc -O2 -DULOG_LOCK_STATS=1 -Isrc bench/ulog_bench_contention.c \
+ *        src/ulog.c -lpthread -o ulog_bench_contention
+ *     ./ulog_bench_contention [max_threads] [messages_per_thread]
+ *
+ * For every thread count the wait, hold, format and dispatch histograms are
+ * printed.  Bucket n counts durations from 2^(n-1) to 2^n microseconds.
+ */
+
+#include "ulog.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile size_t sink;
+static int messages_per_thread = 100000;
+
+static void mutex_lock(bool lock) {
+  if (lock) {
+    pthread_mutex_lock(&mutex);
+  } else {
+    pthread_mutex_unlock(&mutex);
+  }
+}
+
+static uint32_t clock_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000u + ts.tv_nsec / 1000);
+}
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// stands in for a cheap subscriber such as a memory buffer
+static void null_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  sink += msg[0];
+}
+
+static void print_line(const char *line) {
+  printf("  %s\n", line);
+}
+
+static void *worker(void *arg) {
+  long id = (long)arg;
+  for (int i=0; i<messages_per_thread; i++) {
+    ULOG_INFO("thread %ld message %d value %d", id, i, i * 7);
+  }
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  int max_threads = (argc > 1) ? atoi(argv[1]) : 8;
+  pthread_t threads[max_threads];
+
+  if (argc > 2) {
+    messages_per_thread = atoi(argv[2]);
+  }
+  ULOG_INIT();
+  ulog_set_lock(mutex_lock);
+  ulog_set_clock(clock_us);
+  ULOG_SUBSCRIBE(null_logger, ULOG_INFO_LEVEL);
+
+  for (int n=1; n<=max_threads; n *= 2) {
+    ulog_lock_stats_reset();
+    double start = seconds();
+    for (long i=0; i<n; i++) {
+      pthread_create(&threads[i], NULL, worker, (void *)i);
+    }
+    for (int i=0; i<n; i++) {
+      pthread_join(threads[i], NULL);
+    }
+    double elapsed = seconds() - start;
+    printf("%d thread(s): %.0f messages/s\n",
+           n, (double)n * messages_per_thread / elapsed);
+    ulog_lock_stats_dump(print_line);
+  }
+  return 0;
+}
@@ -0,0 +1,108 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_bench_deferred.c
+ *
+ * \brief the cost of capturing messages for ULOG_DEFERRED, with every %s
+ * copied and with string literals captured by reference:
+ *
+ *     cc -O2 -DULOG_DEFERRED=1 -Isrc bench/ulog_bench_deferred.c src/ulog.c \
+ *        src/ulog_capture.c -o ulog_bench_deferred
+ *     ./ulog_bench_deferred [rounds]
+ *
+ * The statements mix literals, names from a stack buffer and numbers, as a
+ * protocol driver's log does.  Reported are bytes per record on the ring and
+ * the time to capture and to flush one message.  Build again with
+ * -DULOG_FORMAT_CACHE=0 to see the flush parse every format.
+ */
+
+#include "ulog.h"
+#include "ulog_capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static volatile size_t sink;
+
+static const char *states[] = { "idle", "connecting", "connected", "closing" };
+static const char *errors[] = {
+  "connection reset by peer", "no route to host",
+  "operation timed out", "certificate has expired"
+};
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void null_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  sink += msg[0];
+}
+
+// one round of the statements of a connection's life, five messages
+static void connection(int i) {
+  char peer[24];
+  snprintf(peer, sizeof(peer), "node-%04d.local", i % 1000);
+  ULOG_INFO("state %s -> %s", states[i & 3], states[(i + 1) & 3]);
+  ULOG_INFO("connect to %s port %d", peer, 8000 + (i & 63));
+  ULOG_INFO("%s: sent %u bytes in %d ms", "tx", (unsigned)(i * 13), i & 255);
+  ULOG_WARNING("peer %s: %s, retry %d of %d", peer, errors[i & 3], i & 3, 3);
+  ULOG_INFO("rx window %d, rtt %ld us, %s", 4096, (long)i * 3, "ok");
+}
+
+static void run(const char *name, int rounds) {
+  ulog_deferred_stats_t stats;
+  double capture = 0;
+  double flush = 0;
+  int messages = 0;
+
+  for (int i=0; i<rounds; i++) {
+    double start = seconds();
+    connection(i);
+    double middle = seconds();
+    messages += ulog_deferred_flush();
+    capture += middle - start;
+    flush += seconds() - middle;
+  }
+  ulog_deferred_stats(&stats);
+  printf("%-22s %5.1f bytes/record  capture %5.1f ns  flush %6.1f ns  dropped %u\n",
+         name, (double)stats.bytes / stats.records,
+         capture * 1e9 / messages, flush * 1e9 / messages, stats.dropped);
+}
+
+int main(int argc, char **argv) {
+  int rounds = (argc > 1) ? atoi(argv[1]) : 100000;
+
+  ULOG_INIT();
+  ULOG_SUBSCRIBE(null_logger, ULOG_INFO_LEVEL);
+  ulog_static_range(NULL, NULL);
+  run("all strings copied:", rounds);
+
+  ULOG_INIT();                  // finds the read-only segments again
+  ULOG_SUBSCRIBE(null_logger, ULOG_INFO_LEVEL);
+  run("literals by reference:", rounds);
+  return 0;
+}
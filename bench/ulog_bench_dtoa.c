@@ -0,0 +1,106 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_bench_dtoa.c
+ *
+ * \brief ulog_dtoa() against snprintf("%.17g"), the usual way to print a
+ * double that reads back the same:
+ *
+ *     cc -O2 -Isrc bench/ulog_bench_dtoa.c src/ulog_dtoa.c -o ulog_bench_dtoa
+ *     ./ulog_bench_dtoa [count]
+ *
+ * Two sets of values: sensor readings with two decimals, and doubles with
+ * random bits over the whole range.  Reported are the time per value and
+ * the average length of the text.
+ */
+
+#include "ulog_dtoa.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static volatile size_t sink;
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t next(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+static int with_snprintf(double value, char *buf) {
+  return snprintf(buf, 32, "%.17g", value);
+}
+
+static void run(const char *name, const double *values, int count) {
+  char buf[32];
+  size_t length = 0;
+
+  double start = seconds();
+  for (int i=0; i<count; i++) {
+    length += ulog_dtoa(values[i], buf);
+  }
+  double shortest = seconds() - start;
+  sink += length;
+  printf("%-9s ulog_dtoa   %6.1f ns  %4.1f chars\n", name, shortest * 1e9 / count,
+         (double)length / count);
+
+  length = 0;
+  start = seconds();
+  for (int i=0; i<count; i++) {
+    length += with_snprintf(values[i], buf);
+  }
+  double printed = seconds() - start;
+  sink += length;
+  printf("%-9s %%.17g       %6.1f ns  %4.1f chars\n", name, printed * 1e9 / count,
+         (double)length / count);
+}
+
+int main(int argc, char **argv) {
+  int count = (argc > 1) ? atoi(argv[1]) : 1000000;
+  double *values = calloc(count, sizeof(double));
+  uint64_t state = 88172645463325252ULL;
+
+  for (int i=0; i<count; i++) {
+    values[i] = (double)(int)(next(&state) % 200000 - 100000) / 100.0;
+  }
+  run("readings", values, count);
+
+  for (int i=0; i<count; i++) {
+    uint64_t bits = next(&state) & ~(0x7ffULL << 52);
+    bits |= (next(&state) % 0x7ff) << 52;         // finite
+    memcpy(&values[i], &bits, sizeof(double));
+  }
+  run("any bits", values, count);
+  free(values);
+  return 0;
+}
@@ -0,0 +1,100 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_bench_format.cpp
+ *
+ * \brief time per message of the three ways to format a uLog message:
+ * ulog_message() with vsnprintf(), the checked printf-style ULOG_xxx() of
+ * ulog.hpp, and the {}-style ULOG_FMT_xxx() of ulog_format.hpp.
+ *
+ * Build and run:
+ *
+ *     c++ -std=c++20 -O2 -Isrc bench/ulog_bench_format.cpp -x c src/ulog.c \
+ *         -o ulog_bench_format
+ *     ./ulog_bench_format [messages]
+ */
+
+#include "ulog_format.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+static volatile std::size_t sink;
+
+// stands in for a cheap subscriber such as a memory buffer
+static void null_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  sink = sink + msg[0];
+}
+
+template <typename F>
+static void run(const char *name, int messages, F &&log) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < messages; i++) {
+    log(i);
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  std::printf("%-24s %8.1f ns/message\n", name, elapsed.count() / messages);
+}
+
+int main(int argc, char **argv) {
+  int messages = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+  const char *path = "/var/lib/service/data.bin";
+  std::string_view view = path;
+
+  ULOG_INIT();
+  ULOG_SUBSCRIBE(null_logger, ULOG_INFO_LEVEL);
+
+  std::printf("integers and a string:\n");
+  run("ulog_message()", messages, [&](int i) {
+    ulog_message(ULOG_INFO_LEVEL, __FILE__, __LINE__,
+                 "read %d bytes from %s at offset %u", i, path, i * 4096u);
+  });
+  run("ULOG_INFO() (ulog.hpp)", messages, [&](int i) {
+    ULOG_INFO("read %d bytes from %s at offset %u", i, path, i * 4096u);
+  });
+  run("ULOG_FMT_INFO()", messages, [&](int i) {
+    ULOG_FMT_INFO("read {} bytes from {} at offset {}", i, view, i * 4096u);
+  });
+
+  std::printf("floating point:\n");
+  run("ulog_message()", messages, [&](int i) {
+    ulog_message(ULOG_INFO_LEVEL, __FILE__, __LINE__, "took %.3f ms, load %g", i * 0.001, i / 7.0);
+  });
+  run("ULOG_INFO() (ulog.hpp)", messages, [&](int i) {
+    ULOG_INFO("took %.3f ms, load %g", i * 0.001, i / 7.0);
+  });
+  run("ULOG_FMT_INFO()", messages, [&](int i) {
+    ULOG_FMT_INFO("took {:.3f} ms, load {:g}", i * 0.001, i / 7.0);
+  });
+
+  std::printf("filtered out (below threshold):\n");
+  run("ulog_message()", messages, [&](int i) {
+    ulog_message(ULOG_DEBUG_LEVEL, __FILE__, __LINE__, "value %d", i);
+  });
+  run("ULOG_FMT_DEBUG()", messages, [&](int i) {
+    ULOG_FMT_DEBUG("value {}", i);
+  });
+  return 0;
+}
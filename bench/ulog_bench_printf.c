@@ -0,0 +1,128 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_bench_printf.c
+ *
+ * \brief ulog_vsnprintf() against the C library's vsnprintf(): time per
+ * message, and the stack ulog_vsnprintf() touches:
+ *
+ *     cc -O2 -DULOG_TINY_PRINTF=1 -Isrc bench/ulog_bench_printf.c \
+ *        src/ulog_printf.c -o ulog_bench_printf
+ *     ./ulog_bench_printf [count]
+ *
+ * Code size and static stack depth come from the compiler.  For a Cortex-M
+ * build against newlib:
+ *
+ *     arm-none-eabi-gcc -Os -mcpu=cortex-m0 -fstack-usage -DULOG_TINY_PRINTF=1 \
+ *        -Isrc -c src/ulog_printf.c
+ *     arm-none-eabi-size ulog_printf.o; cat ulog_printf.su
+ *
+ * and compare with the vsnprintf() members of newlib's libc.a (vfprintf.o,
+ * dtoa.o, mprec.o and their locale support).
+ */
+
+#include "ulog_printf.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PAINT_SIZE 4096
+
+static volatile size_t sink;
+
+typedef int (*vformat_fn)(char *buf, int size, const char *fmt, va_list ap);
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int libc_vsnprintf(char *buf, int size, const char *fmt, va_list ap) {
+  return vsnprintf(buf, size, fmt, ap);
+}
+
+__attribute__((noinline))
+static int format(vformat_fn fn, char *buf, int size, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = fn(buf, size, fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+// a message of the kind uLog formats most
+static int message(vformat_fn fn, char *buf, int i) {
+  return format(fn, buf, 120, "%-8s id=%5d len=%u crc=%08x peer %s",
+                "rx", i, (unsigned)(i * 7), (unsigned)i * 2654435761u, "node-17");
+}
+
+// the pattern is written and read back through different frames on purpose
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+
+// fill the stack below the caller with a pattern
+__attribute__((noinline))
+static void paint() {
+  volatile char area[PAINT_SIZE];
+  for (int i=0; i<PAINT_SIZE; i++) {
+    area[i] = (char)0xa5;
+  }
+}
+
+// bytes of the painted stack overwritten since paint()
+__attribute__((noinline))
+static int touched() {
+  volatile char area[PAINT_SIZE];
+  int i = 0;
+  while (i < PAINT_SIZE && area[i] == (char)0xa5) {
+    i++;
+  }
+  return PAINT_SIZE - i;
+}
+
+int main(int argc, char **argv) {
+  int count = (argc > 1) ? atoi(argv[1]) : 1000000;
+  char buf[128];
+
+  paint();
+  message(ulog_vsnprintf, buf, 1);
+  printf("ulog_vsnprintf: %d bytes of stack, caller included\n", touched());
+
+  double start = seconds();
+  for (int i=0; i<count; i++) {
+    sink += message(ulog_vsnprintf, buf, i);
+  }
+  double tiny = seconds() - start;
+  start = seconds();
+  for (int i=0; i<count; i++) {
+    sink += message(libc_vsnprintf, buf, i);
+  }
+  double libc = seconds() - start;
+  printf("ulog_vsnprintf %5.1f ns/message, vsnprintf %5.1f ns/message\n",
+         tiny * 1e9 / count, libc * 1e9 / count);
+  return 0;
+}
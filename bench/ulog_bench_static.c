@@ -0,0 +1,90 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_bench_static.c
+ *
+ * \brief cost of dispatch through the subscriber table against static
+ * subscribers.  Build the same benchmark both ways and compare:
+ *
+ *     cc -O2 -Isrc -Ibench bench/ulog_bench_static.c src/ulog.c \
+ *        -o ulog_bench_dynamic
+ *     cc -O2 -DULOG_STATIC_SUBSCRIBERS=1 -Isrc -Ibench \
+ *        bench/ulog_bench_static.c src/ulog.c -o ulog_bench_static
+ *     ./ulog_bench_dynamic [messages]; ./ulog_bench_static [messages]
+ *
+ * For code size, compile ulog.c and this file with -c in both modes and run
+ * size(1) on the objects: filtered statements leave no code behind with
+ * static subscribers.
+ */
+
+#include "ulog.h"
+#include "ulog_subscribers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+volatile size_t ulog_bench_sink;
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const char *name, int messages, double start) {
+  printf("%-32s %8.1f ns/message\n", name, (seconds() - start) * 1e9 / messages);
+}
+
+int main(int argc, char **argv) {
+  int messages = (argc > 1) ? atoi(argv[1]) : 1000000;
+  double start;
+
+  ULOG_INIT();
+#if (ULOG_STATIC_SUBSCRIBERS == 0)
+  ULOG_SUBSCRIBE(uart_logger, ULOG_WARNING_LEVEL);
+  ULOG_SUBSCRIBE(ram_logger, ULOG_DEBUG_LEVEL);
+  printf("subscriber table:\n");
+#else
+  printf("static subscribers:\n");
+#endif
+
+  start = seconds();
+  for (int i=0; i<messages; i++) {
+    ULOG_WARNING("w");
+  }
+  report("WARNING (two subscribers)", messages, start);
+
+  start = seconds();
+  for (int i=0; i<messages; i++) {
+    ULOG_INFO("i");
+  }
+  report("INFO (one subscriber)", messages, start);
+
+  start = seconds();
+  for (int i=0; i<messages; i++) {
+    ULOG_TRACE("t %d", i);
+  }
+  report("TRACE (no subscriber)", messages, start);
+  return 0;
+}
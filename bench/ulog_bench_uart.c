@@ -0,0 +1,157 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_bench_uart.c
+ *
+ * \brief sustained throughput of the double-buffered UART subscriber, with a
+ * thread standing in for the UART and its DMA channel:
+ *
+ *     cc -O2 -DULOG_UART_SINK=1 -Isrc bench/ulog_bench_uart.c src/ulog.c \
+ *        src/ulog_uart.c -lpthread -o ulog_bench_uart
+ *     ./ulog_bench_uart [baud] [seconds]
+ *
+ * The device thread takes a started transfer, sleeps for the time the bytes
+ * take on the wire at baud (10 bits a byte, 8N1) and calls
+ * ulog_uart_tx_done() as the transfer complete interrupt would.  The main
+ * thread logs at increasing rates and reports what got through, what was
+ * dropped, and the longest a ULOG_INFO() call took.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ulog.h"
+#include "ulog_uart.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t started;
+  int pending;              // bytes of the transfer to send, 0 if none
+  bool stop;
+  long baud;
+} device = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, false, 115200 };
+
+static pthread_mutex_t buffers_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void sleep_for(double s) {
+  struct timespec ts = { (time_t)s, (long)((s - (time_t)s) * 1e9) };
+  nanosleep(&ts, NULL);
+}
+
+// the start function: program the "DMA" and return
+static void dma_start(const uint8_t *data, int len) {
+  pthread_mutex_lock(&device.mutex);
+  device.pending = len;
+  pthread_cond_signal(&device.started);
+  pthread_mutex_unlock(&device.mutex);
+}
+
+// masks the "DMA interrupt"
+static void critical(bool enter) {
+  if (enter) {
+    pthread_mutex_lock(&buffers_mutex);
+  } else {
+    pthread_mutex_unlock(&buffers_mutex);
+  }
+}
+
+static void *uart_thread(void *arg) {
+  pthread_mutex_lock(&device.mutex);
+  for (;;) {
+    while (device.pending == 0 && !device.stop) {
+      pthread_cond_wait(&device.started, &device.mutex);
+    }
+    if (device.pending == 0) {
+      break;
+    }
+    int len = device.pending;
+    device.pending = 0;
+    pthread_mutex_unlock(&device.mutex);
+    sleep_for(len * 10.0 / device.baud);
+    ulog_uart_tx_done();
+    pthread_mutex_lock(&device.mutex);
+  }
+  pthread_mutex_unlock(&device.mutex);
+  return NULL;
+}
+
+// log rate messages a second for duration seconds
+static void run(int rate, double duration) {
+  ulog_uart_stats_t stats;
+  double longest = 0;
+  int count = (int)(rate * duration);
+
+  ulog_uart_init(dma_start, critical);
+  double start = seconds();
+  for (int i=0; i<count; i++) {
+    double due = start + (double)i / rate;
+    double now = seconds();
+    if (now < due) {
+      sleep_for(due - now);
+    }
+    now = seconds();
+    ULOG_INFO("sensor %d: t=%d.%02d C, p=%d hPa, seq %d", i & 7, 20 + (i & 15),
+              i % 100, 1000 + (i & 31), i);
+    double took = seconds() - now;
+    longest = (took > longest) ? took : longest;
+  }
+  sleep_for(2 * ULOG_UART_BUFFER_SIZE * 10.0 / device.baud);   // let it drain
+  ulog_uart_stats(&stats);
+  double offered = (stats.bytes + stats.dropped_bytes) / duration;
+  printf("%6d msg/s  offered %7.0f B/s  sent %7.0f B/s  dropped %5.1f%%  "
+         "%5u transfers  longest call %5.1f us\n",
+         rate, offered, stats.bytes / duration,
+         100.0 * stats.dropped_bytes / (stats.bytes + stats.dropped_bytes),
+         stats.transfers, longest * 1e6);
+}
+
+int main(int argc, char **argv) {
+  pthread_t uart;
+  device.baud = (argc > 1) ? atol(argv[1]) : 115200;
+  double duration = (argc > 2) ? atof(argv[2]) : 1.0;
+
+  ULOG_INIT();
+  ULOG_SUBSCRIBE(ulog_uart_logger, ULOG_INFO_LEVEL);
+  pthread_create(&uart, NULL, uart_thread, NULL);
+  printf("%ld baud, line capacity %ld B/s, buffers of %d bytes\n",
+         device.baud, device.baud / 10, ULOG_UART_BUFFER_SIZE);
+  for (int rate = 50; rate <= 800; rate *= 2) {
+    run(rate, duration);
+  }
+  pthread_mutex_lock(&device.mutex);
+  device.stop = true;
+  pthread_cond_signal(&device.started);
+  pthread_mutex_unlock(&device.mutex);
+  pthread_join(uart, NULL);
+  return 0;
+}
@@ -0,0 +1,51 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_subscribers.h
+ *
+ * \brief the static subscribers of bench/ulog_bench_static.c.  With
+ * ULOG_STATIC_SUBSCRIBERS, ulog.h includes this file from the include path.
+ */
+
+#ifndef ULOG_SUBSCRIBERS_H_
+#define ULOG_SUBSCRIBERS_H_
+
+#include <stddef.h>
+
+extern volatile size_t ulog_bench_sink;
+
+// stand in for a UART and a RAM buffer
+static inline void uart_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  ulog_bench_sink = ulog_bench_sink + msg[0];
+}
+
+static inline void ram_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  ulog_bench_sink = ulog_bench_sink + line;
+}
+
+#define ULOG_SUBSCRIBERS(X)              \
+  X(uart_logger, ULOG_WARNING_LEVEL)     \
+  X(ram_logger, ULOG_DEBUG_LEVEL)
+
+#endif /* ULOG_SUBSCRIBERS_H_ */
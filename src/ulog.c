@@ -29,8 +29,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  * See ulog.h for sparse documentation.
  */
 
+#define ULOG_LIBRARY_      // see ULOG_COLD
 #include "ulog.h"
 #include "ulog_config.h"
+#include "ulog_core.h"
 
 #if (ULOG_ENABLED == 1)  // whole file...
 
@@ -38,53 +40,306 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <string.h>
 #include <stdarg.h>
 
+#if (ULOG_STATIC_SUBSCRIBERS == 1) && (ULOG_SUBSCRIBER_TIMING == 1)
+#error "ULOG_SUBSCRIBER_TIMING needs the dynamic subscriber table"
+#endif
+
+#if (ULOG_SHM_STATS == 1)
+#include "ulog_shm.h"
+#endif
+
+#if (ULOG_DEFERRED == 1)
+#include "ulog_capture.h"
+#endif
+
+#if (ULOG_TINY_PRINTF == 1)
+#include "ulog_printf.h"
+#define VSNPRINTF ulog_vsnprintf
+#define SNPRINTF ulog_snprintf
+#else
+#define VSNPRINTF vsnprintf
+#define SNPRINTF snprintf
+#endif
+
 
 // =============================================================================
 // types and definitions
 
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+// messages waiting for a demoted subscriber, laid out as ulog_core.h says
+typedef ulog_core_message_t queued_message_t;
+typedef ulog_core_queue_t message_queue_t;
+#endif
+
 typedef struct {
   ulog_function_t fn;
   ulog_level_t threshold;
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+  ulog_subscriber_stats_t stats;
+  int window_calls;         // calls in the current ULOG_SLOW_WINDOW
+  int window_strikes;       // slow calls in the current ULOG_SLOW_WINDOW
+#if (ULOG_CORE_REGISTRY == 1)
+  ulog_core_header_t queue_header;
+#endif
+  message_queue_t queue;
+#endif
 } subscriber_t;
 
+#if (ULOG_DEFERRED == 1)
+typedef ulog_core_record_t record_t;      // see ulog_core.h
+#endif
+
 // =============================================================================
 // local storage
 
+// lowest threshold of any subscriber, read without the lock by ulog_wants()
+ulog_level_t ulog_min_level = ULOG_LEVEL_N;
+
 static struct {
   subscriber_t subscribers[ULOG_MAX_SUBSCRIBERS];
+#if (ULOG_CORE_REGISTRY == 1)
+  ulog_core_header_t msg_header;
+#endif
   char msg[ULOG_MAX_MESSAGE_LENGTH];
   bool quite;
   ulog_lock_t lock_fn;
+  ulog_clock_t clock_fn;
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+  ulog_demote_t demote_fn;
+#endif
+#if (ULOG_LOCK_STATS == 1)
+  ulog_lock_stats_t lock_stats;
+  uint32_t locked_at;          // clock when the lock was last acquired
+#endif
+#if (ULOG_STATS == 1)
+  uint32_t messages[ULOG_LEVEL_N];
+  uint32_t quieted;
+#endif
+#if (ULOG_HOT_RELOAD == 1)
+  ulog_update_t *pending;      // published, not yet applied
+  ulog_update_t *current;      // applied, its site rules still in use
+  ulog_update_t *retired;      // replaced by current, to be freed by publisher
+#endif
+#if (ULOG_SHM_STATS == 1)
+  uint32_t published_at;       // clock when the shared page was last updated
+#endif
+#if (ULOG_SITES == 1)
+  ulog_site_t *sites;          // registry of call sites, most recent first
+  const ulog_site_t *delivering; // site of the message being delivered
+  uint32_t site_count;
+  uint32_t rate_limit;         // default messages per second per site
+#endif
+#if (ULOG_DEFERRED == 1)
+#if (ULOG_CORE_REGISTRY == 1)
+  ulog_core_header_t ring_header;
+#endif
+  ulog_core_ring_t ring;
+  uint8_t record[ULOG_DEFERRED_RECORD_SIZE];  // the record being captured
+  ulog_deferred_stats_t deferred;
+#endif
 } ulog_config;
 
+#if (ULOG_CORE_REGISTRY == 1)
+// where tools/ulog-core.c finds the buffers above in a core file
+ulog_core_registry_t ulog_core_registry = {
+  ULOG_CORE_MAGIC, ULOG_CORE_VERSION, sizeof(void *), 0, { NULL }
+};
+#endif
+
 
 // =============================================================================
 // local functions
 
+#if (ULOG_LOCK_STATS == 1)
+static void record(ulog_histogram_t *histogram, uint32_t elapsed_us) {
+  int bucket = 0;
+  while (elapsed_us >> bucket && bucket < ULOG_HISTOGRAM_BUCKETS - 1) {
+    bucket++;
+  }
+  histogram->buckets[bucket]++;
+  histogram->count++;
+  histogram->total_us += elapsed_us;
+  if (elapsed_us > histogram->max_us) {
+    histogram->max_us = elapsed_us;
+  }
+}
+
+static uint32_t now() {
+  return (ulog_config.clock_fn != NULL) ? ulog_config.clock_fn() : 0;
+}
+#endif
+
+#if (ULOG_HOT_RELOAD == 1)
+static void apply_update();
+#endif
+
 static void lock(bool lock) {
   if(ulog_config.lock_fn != NULL) {
+#if (ULOG_LOCK_STATS == 1)
+    if (ulog_config.clock_fn != NULL) {
+      uint32_t start = ulog_config.clock_fn();
+      if (lock) {
+        ulog_config.lock_fn(true);
+        ulog_config.locked_at = ulog_config.clock_fn();
+        record(&ulog_config.lock_stats.wait, ulog_config.locked_at - start);
+      } else {
+        record(&ulog_config.lock_stats.hold, start - ulog_config.locked_at);
+        ulog_config.lock_fn(false);
+      }
+    } else {
+      ulog_config.lock_fn(lock);
+    }
+#else
     ulog_config.lock_fn(lock);
+#endif
   }
+#if (ULOG_HOT_RELOAD == 1)
+  if (lock && __atomic_load_n(&ulog_config.pending, __ATOMIC_ACQUIRE) != NULL) {
+    apply_update();
+  }
+#endif
 }
 
+static void ulog_vmessage(ulog_site_t *site,
+                          ulog_level_t severity,
+                          const char *file,
+                          int line,
+                          const char *fmt,
+                          va_list ap);
+
+static void emit(ulog_site_t *site,
+                 ulog_level_t severity,
+                 const char *file,
+                 int line,
+                 const char *fmt,
+                 ulog_render_t render,
+                 void *ctx);
+
+#if (ULOG_STATIC_SUBSCRIBERS == 0)
+static void deliver(subscriber_t *subscriber,
+                    ulog_level_t severity,
+                    const char *file,
+                    int line);
+#endif
+
+static void update_min_level();
+static bool wanted(ulog_level_t severity);
+#if (ULOG_LEVEL_PARSE == 1)
+static bool same_name(const char *a, const char *b);
+#endif
+
+#if (ULOG_DEFERRED == 1)
+static void defer(ulog_site_t *site,
+                  ulog_level_t severity,
+                  const char *file,
+                  int line,
+                  const char *fmt,
+                  int len,
+                  bool text);
+static bool ring_put(const uint8_t *record, uint32_t size);
+static bool ring_get(uint8_t *record);
+static int render_record(char *buf, int size, void *ctx);
+#endif
+
+#if (ULOG_SITES == 1)
+static bool site_matches(const ulog_site_t *site, const char *file, int line);
+static bool rate_limited(ulog_site_t *site);
+#endif
+#if (ULOG_SITES == 1) && (ULOG_HOT_RELOAD == 1)
+static void site_setting(const ulog_update_t *update,
+                         const ulog_site_t *site,
+                         ulog_site_setting_t *setting);
+#endif
+
+#if (ULOG_STATS == 1)
+static void collect_stats(ulog_stats_t *stats);
+#endif
+#if (ULOG_SHM_STATS == 1)
+static void publish_stats();
+#endif
+
+#if (ULOG_CORE_REGISTRY == 1)
+static void register_buffer(ulog_core_header_t *header,
+                            ulog_core_kind_t kind,
+                            int index,
+                            const volatile void *data,
+                            uint32_t size);
+#endif
+
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+static subscriber_t *find_subscriber(ulog_function_t fn);
+static void reset_timing(subscriber_t *subscriber);
+#endif
+
 // =============================================================================
 // user-visible code
 
 void ulog_init() {
   memset(ulog_config.subscribers, 0, sizeof(ulog_config.subscribers));
+#if (ULOG_STATIC_SUBSCRIBERS == 1)
+  // listed for ulog_subscriber_get(), but dispatched by emit() directly
+  int slot = 0;
+  #define ULOG_LIST_(fn_, threshold_)                                         \
+    if (slot < ULOG_MAX_SUBSCRIBERS) {                                        \
+      ulog_config.subscribers[slot].fn = fn_;                                 \
+      ulog_config.subscribers[slot++].threshold = threshold_;                 \
+    }
+  ULOG_SUBSCRIBERS(ULOG_LIST_)
+  #undef ULOG_LIST_
+#endif
+  update_min_level();
   memset(ulog_config.msg, 0, ULOG_MAX_MESSAGE_LENGTH);
   ulog_config.quite = false;
   ulog_config.lock_fn = NULL;
+  ulog_config.clock_fn = NULL;
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+  ulog_config.demote_fn = NULL;
+#endif
+#if (ULOG_SITES == 1)
+  ulog_config.rate_limit = ULOG_SITE_RATE_LIMIT;
+#endif
+#if (ULOG_STATS == 1)
+  memset(ulog_config.messages, 0, sizeof(ulog_config.messages));
+  ulog_config.quieted = 0;
+#endif
+#if (ULOG_DEFERRED == 1)
+  ulog_config.ring.used = 0;
+  memset(&ulog_config.deferred, 0, sizeof(ulog_config.deferred));
+  ulog_static_range(NULL, NULL);
+  ulog_static_ranges_detect();
+#endif
+#if (ULOG_CORE_REGISTRY == 1)
+  ulog_core_registry.count = 0;
+  register_buffer(&ulog_config.msg_header, ULOG_CORE_MESSAGE, 0,
+                  ulog_config.msg, sizeof(ulog_config.msg));
+#if (ULOG_DEFERRED == 1)
+  register_buffer(&ulog_config.ring_header, ULOG_CORE_DEFERRED, 0,
+                  &ulog_config.ring, sizeof(ulog_config.ring));
+#endif
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+  for (int i=0; i<ULOG_MAX_SUBSCRIBERS; i++) {
+    subscriber_t *subscriber = &ulog_config.subscribers[i];
+    register_buffer(&subscriber->queue_header, ULOG_CORE_QUEUE, i,
+                    &subscriber->queue, sizeof(subscriber->queue));
+  }
+#endif
+#endif
 }
 
 // search the subscribers table to install or update fn
 ulog_err_t ulog_subscribe(ulog_function_t fn, ulog_level_t threshold) {
+#if (ULOG_STATIC_SUBSCRIBERS == 1)
+  (void)fn;
+  (void)threshold;
+  return ULOG_ERR_STATIC_SUBSCRIBERS;
+#endif
   int available_slot = -1;
   lock(true);
   for (int i=0; i<ULOG_MAX_SUBSCRIBERS; i++) {
     if (ulog_config.subscribers[i].fn == fn) {
       // already subscribed: update threshold and return immediately.
       ulog_config.subscribers[i].threshold = threshold;
+      update_min_level();
       lock(false);
       return ULOG_ERR_NONE;
 
@@ -100,12 +355,20 @@ ulog_err_t ulog_subscribe(ulog_function_t fn, ulog_level_t threshold) {
   }
   ulog_config.subscribers[available_slot].fn = fn;
   ulog_config.subscribers[available_slot].threshold = threshold;
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+  reset_timing(&ulog_config.subscribers[available_slot]);
+#endif
+  update_min_level();
   lock(false);
   return ULOG_ERR_NONE;
 }
 
 // search the subscribers table to remove
 ulog_err_t ulog_unsubscribe(ulog_function_t fn) {
+#if (ULOG_STATIC_SUBSCRIBERS == 1)
+  (void)fn;
+  return ULOG_ERR_STATIC_SUBSCRIBERS;
+#endif
   ulog_err_t ret = ULOG_ERR_NOT_SUBSCRIBED;
   lock(true);
   for (int i=0; i<ULOG_MAX_SUBSCRIBERS; i++) {
@@ -115,6 +378,7 @@ ulog_err_t ulog_unsubscribe(ulog_function_t fn) {
       break;
     }
   }
+  update_min_level();
   lock(false);
   return ret;
 }
@@ -123,6 +387,10 @@ void ulog_set_lock(ulog_lock_t lock_fn) {
   ulog_config.lock_fn = lock_fn;
 }
 
+void ulog_set_clock(ulog_clock_t clock_fn) {
+  ulog_config.clock_fn = clock_fn;
+}
+
 const char *ulog_level_name(ulog_level_t severity) {
   switch(severity) {
    case ULOG_TRACE_LEVEL: return "TRACE";
@@ -135,31 +403,903 @@ const char *ulog_level_name(ulog_level_t severity) {
   }
 }
 
+#if (ULOG_LEVEL_PARSE == 1)
+ulog_level_t ulog_level_parse(const char *name) {
+  static const char *const long_names[ULOG_LEVEL_N] = {
+    "TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "CRITICAL"
+  };
+  for (int level=0; level<ULOG_LEVEL_N; level++) {
+    if (same_name(name, ulog_level_name(level)) ||
+        same_name(name, long_names[level])) {
+      return level;
+    }
+  }
+  return ULOG_LEVEL_N;
+}
+#endif
+
+#if (ULOG_CTL == 1)
+ulog_err_t ulog_subscriber_get(int slot, ulog_function_t *fn, ulog_level_t *threshold) {
+  ulog_err_t ret = ULOG_ERR_NOT_SUBSCRIBED;
+  if (slot < 0 || slot >= ULOG_MAX_SUBSCRIBERS) {
+    return ret;
+  }
+  lock(true);
+  if (ulog_config.subscribers[slot].fn != NULL) {
+    *fn = ulog_config.subscribers[slot].fn;
+    *threshold = ulog_config.subscribers[slot].threshold;
+    ret = ULOG_ERR_NONE;
+  }
+  lock(false);
+  return ret;
+}
+#endif
+
 void ulog_set_quite(bool set) {
   ulog_config.quite = set;
 }
 
 void ulog_message(ulog_level_t severity, const char *file, int line, const char *fmt, ...) {
-  if(ulog_config.quite) {
+  va_list ap;
+  va_start(ap, fmt);
+  ulog_vmessage(NULL, severity, file, line, fmt, ap);
+  va_end(ap);
+}
+
+uint32_t ulog_module_hash(const char *file) {
+  uint32_t hash = 2166136261u;
+  for (; *file; file++) {
+    hash = (hash ^ (uint8_t)*file) * 16777619u;
+  }
+  return hash;
+}
+
+void ulog_render_message(ulog_site_t *site,
+                         ulog_level_t severity,
+                         const char *file,
+                         int line,
+                         const char *fmt,
+                         ulog_render_t render,
+                         void *ctx) {
+#if (ULOG_DEFERRED == 1)
+  // the arguments are gone by flush time: keep the rendered message
+  if (ulog_config.quite || !wanted(severity)) {
     return;
   }
   lock(true);
+  int room = ULOG_DEFERRED_RECORD_SIZE - (int)sizeof(record_t);
+  int len = render((char *)&ulog_config.record[sizeof(record_t)], room, ctx);
+  defer(site, severity, file, line, fmt, len < room ? len : room - 1, true);
+  lock(false);
+#else
+  emit(site, severity, file, line, fmt, render, ctx);
+#endif
+}
+
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+
+void ulog_set_demote_handler(ulog_demote_t demote_fn) {
+  ulog_config.demote_fn = demote_fn;
+}
+
+ulog_err_t ulog_subscriber_stats(ulog_function_t fn, ulog_subscriber_stats_t *stats) {
+  ulog_err_t ret = ULOG_ERR_NOT_SUBSCRIBED;
+  lock(true);
+  subscriber_t *subscriber = find_subscriber(fn);
+  if (subscriber != NULL) {
+    *stats = subscriber->stats;
+    stats->queued = subscriber->queue.count;
+    ret = ULOG_ERR_NONE;
+  }
+  lock(false);
+  return ret;
+}
+
+int ulog_drain() {
+  static queued_message_t message;   // too big for small stacks
+  int delivered = 0;
+  bool found;
+
+  // Take one message at a time so the lock is never held while the slow
+  // subscriber runs.
+  do {
+    ulog_function_t fn = NULL;
+    found = false;
+    lock(true);
+    for (int i=0; i<ULOG_MAX_SUBSCRIBERS && !found; i++) {
+      subscriber_t *subscriber = &ulog_config.subscribers[i];
+      message_queue_t *queue = &subscriber->queue;
+      if (subscriber->fn != NULL && queue->count > 0) {
+        message = queue->entries[queue->head];
+        queue->head = (queue->head + 1) % ULOG_ASYNC_QUEUE_DEPTH;
+        queue->count--;
+        fn = subscriber->fn;
+        found = true;
+      }
+    }
+    lock(false);
+    if (found) {
+      fn(message.severity, message.file, message.line, message.msg);
+      delivered++;
+    }
+  } while (found);
+  return delivered;
+}
+
+#endif
+
+#if (ULOG_HOT_RELOAD == 1)
+
+ulog_update_t *ulog_update_publish(ulog_update_t *update) {
+  ulog_update_t *retired = __atomic_exchange_n(&ulog_config.retired, NULL, __ATOMIC_ACQ_REL);
+  // let the next message of any level through to take the lock and apply it
+  __atomic_store_n(&ulog_min_level, ULOG_TRACE_LEVEL, __ATOMIC_RELEASE);
+  ulog_update_t *unapplied = __atomic_exchange_n(&ulog_config.pending, update, __ATOMIC_ACQ_REL);
+  // at most one of them is set: an update is retired only once the next one
+  // has been applied, and only one is published at a time.
+  return (unapplied != NULL) ? unapplied : retired;
+}
+
+int ulog_update_settle(ulog_update_t *update, ulog_site_setting_t *settings, int capacity) {
+  int count = 0;
+#if (ULOG_SITES == 1)
+  // sites are only ever added in front of the head, so the list behind the
+  // head read under the lock does not change
+  for (const ulog_site_t *site = ulog_site_first(); site != NULL; site = site->next) {
+    if (count < capacity) {
+      site_setting(update, site, &settings[count]);
+    }
+    count++;
+  }
+#endif
+  if (count <= capacity) {
+    update->settings = settings;
+    update->setting_count = count;
+  }
+  return count;
+}
+
+#endif
+
+#if (ULOG_STATS == 1)
+
+void ulog_stats(ulog_stats_t *stats) {
+  lock(true);
+  collect_stats(stats);
+  lock(false);
+}
+
+#endif
+
+#if (ULOG_LOCK_STATS == 1)
+
+void ulog_lock_stats(ulog_lock_stats_t *stats) {
+  lock(true);
+  *stats = ulog_config.lock_stats;
+  lock(false);
+}
+
+static void dump_histogram(ulog_print_t print,
+                           const char *name,
+                           const ulog_histogram_t *histogram) {
+  char line[32 + ULOG_HISTOGRAM_BUCKETS * 11];
+  int n = SNPRINTF(line, sizeof(line), "%-8s n=%lu avg=%luus max=%luus |",
+                   name,
+                   (unsigned long)histogram->count,
+                   (unsigned long)(histogram->count ?
+                                   histogram->total_us / histogram->count : 0),
+                   (unsigned long)histogram->max_us);
+  for (int i=0; i<ULOG_HISTOGRAM_BUCKETS && n < (int)sizeof(line); i++) {
+    n += SNPRINTF(&line[n], sizeof(line) - n, " %lu",
+                  (unsigned long)histogram->buckets[i]);
+  }
+  print(line);
+}
+
+void ulog_lock_stats_dump(ulog_print_t print) {
+  ulog_lock_stats_t stats;
+  ulog_lock_stats(&stats);
+  dump_histogram(print, "wait", &stats.wait);
+  dump_histogram(print, "hold", &stats.hold);
+  dump_histogram(print, "format", &stats.format);
+  dump_histogram(print, "dispatch", &stats.dispatch);
+}
+
+void ulog_lock_stats_reset() {
+  lock(true);
+  memset(&ulog_config.lock_stats, 0, sizeof(ulog_config.lock_stats));
+  lock(false);
+}
+
+#endif
+
+#if (ULOG_SITES == 1)
+
+void ulog_site_message(ulog_site_t *site, const char *fmt, ...) {
   va_list ap;
   va_start(ap, fmt);
-  vsnprintf(ulog_config.msg, ULOG_MAX_MESSAGE_LENGTH, fmt, ap);
+  ulog_vmessage(site, site->level, site->file, site->line, fmt, ap);
   va_end(ap);
+}
 
-  for (int i=0; i<ULOG_MAX_SUBSCRIBERS; i++) {
-    if (ulog_config.subscribers[i].fn != NULL) {
-      if (severity >= ulog_config.subscribers[i].threshold) {
-        ulog_config.subscribers[i].fn(severity, file, line, ulog_config.msg);
+int ulog_site_top(const ulog_site_t **sites, int k) {
+  int n = 0;
+  lock(true);
+  // insertion into a k-element array kept sorted by bytes, descending
+  for (ulog_site_t *site = ulog_config.sites; site != NULL; site = site->next) {
+    int i = (n < k) ? n++ : k;
+    while (i > 0 && sites[i-1]->bytes < site->bytes) {
+      if (i < k) {
+        sites[i] = sites[i-1];
       }
+      i--;
+    }
+    if (i < k) {
+      sites[i] = site;
+    }
+  }
+  lock(false);
+  return n;
+}
+
+void ulog_site_dump(ulog_print_t print, int k) {
+  const ulog_site_t *sites[ULOG_SITE_DUMP_MAX];
+  char line[ULOG_MAX_MESSAGE_LENGTH + 64];
+  int n = ulog_site_top(sites, (k < ULOG_SITE_DUMP_MAX) ? k : ULOG_SITE_DUMP_MAX);
+
+  SNPRINTF(line, sizeof(line), "%10s %10s %10s  %s", "hits", "emitted", "bytes", "site");
+  print(line);
+  for (int i=0; i<n; i++) {
+    SNPRINTF(line, sizeof(line), "%10lu %10lu %10lu  %s:%d \"%s\"",
+             (unsigned long)sites[i]->hits,
+             (unsigned long)sites[i]->emitted,
+             (unsigned long)sites[i]->bytes,
+             sites[i]->file,
+             sites[i]->line,
+             sites[i]->fmt);
+    print(line);
+  }
+}
+
+void ulog_site_reset() {
+  lock(true);
+  for (ulog_site_t *site = ulog_config.sites; site != NULL; site = site->next) {
+    site->hits = 0;
+    site->emitted = 0;
+    site->bytes = 0;
+    site->suppressed = 0;
+  }
+  lock(false);
+}
+
+const ulog_site_t *ulog_current_site() {
+  return ulog_config.delivering;
+}
+
+const ulog_site_t *ulog_site_first() {
+  lock(true);
+  const ulog_site_t *site = ulog_config.sites;
+  lock(false);
+  return site;
+}
+
+ulog_err_t ulog_site_enable(const char *file, int line, bool enable) {
+  ulog_err_t ret = ULOG_ERR_NO_SUCH_SITE;
+  lock(true);
+  for (ulog_site_t *site = ulog_config.sites; site != NULL; site = site->next) {
+    if (site_matches(site, file, line)) {
+      site->disabled = !enable;
+      ret = ULOG_ERR_NONE;
+    }
+  }
+  lock(false);
+  return ret;
+}
+
+ulog_err_t ulog_site_set_rate_limit(const char *file, int line, uint32_t per_second) {
+  ulog_err_t ret = ULOG_ERR_NO_SUCH_SITE;
+  lock(true);
+  if (file == NULL) {
+    ulog_config.rate_limit = per_second;
+    ret = ULOG_ERR_NONE;
+  } else {
+    for (ulog_site_t *site = ulog_config.sites; site != NULL; site = site->next) {
+      if (site_matches(site, file, line)) {
+        site->rate_limit = per_second;
+        ret = ULOG_ERR_NONE;
+      }
+    }
+  }
+  lock(false);
+  return ret;
+}
+
+#endif
+
+#if (ULOG_DEFERRED == 1)
+
+int ulog_deferred_flush() {
+  static uint8_t record[ULOG_DEFERRED_RECORD_SIZE];   // kept off the stack
+  record_t header;
+  int taken = 0;
+
+  for (;;) {
+    lock(true);
+    bool found = ring_get(record);
+    lock(false);
+    if (!found) {
+      return taken;
     }
+    memcpy(&header, record, sizeof(header));
+    emit(header.site, (ulog_level_t)header.severity, header.file, header.line,
+         header.fmt, render_record, record);
+    taken++;
   }
+}
+
+void ulog_deferred_stats(ulog_deferred_stats_t *stats) {
+  lock(true);
+  *stats = ulog_config.deferred;
   lock(false);
 }
 
+#endif
+
 // =============================================================================
 // private code
 
+#if (ULOG_STATS == 1)
+
+// gather all counters.  Called with the lock held.
+static void collect_stats(ulog_stats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+  memcpy(stats->messages, ulog_config.messages, sizeof(stats->messages));
+  stats->quieted = ulog_config.quieted;
+  for (int i=0; i<ULOG_MAX_SUBSCRIBERS; i++) {
+    subscriber_t *subscriber = &ulog_config.subscribers[i];
+    ulog_subscriber_info_t *info = &stats->subscribers[i];
+    if (subscriber->fn == NULL) {
+      continue;
+    }
+    info->fn = subscriber->fn;
+    info->threshold = subscriber->threshold;
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+    info->timing = subscriber->stats;
+    info->timing.queued = subscriber->queue.count;
+    stats->queued += subscriber->queue.count;
+    stats->dropped += subscriber->stats.dropped;
+#endif
+  }
+#if (ULOG_LOCK_STATS == 1)
+  stats->lock = ulog_config.lock_stats;
+#endif
+}
+
+#endif
+
+#if (ULOG_SHM_STATS == 1)
+
+// refresh the shared memory page if ULOG_SHM_INTERVAL_US has passed.  Called
+// with the lock held.
+static void publish_stats() {
+  static ulog_stats_t stats;    // too big for small stacks
+  uint32_t now_us = 0;
+  if (ulog_config.clock_fn != NULL) {
+    now_us = ulog_config.clock_fn();
+    if (now_us - ulog_config.published_at < ULOG_SHM_INTERVAL_US) {
+      return;
+    }
+    ulog_config.published_at = now_us;
+  }
+  collect_stats(&stats);
+  ulog_shm_write(&stats, now_us);
+}
+
+#endif
+
+#if (ULOG_CORE_REGISTRY == 1)
+
+// mark a buffer with its header and list it in ulog_core_registry
+static void register_buffer(ulog_core_header_t *header,
+                            ulog_core_kind_t kind,
+                            int index,
+                            const volatile void *data,
+                            uint32_t size) {
+  header->magic = ULOG_CORE_HEADER_MAGIC;
+  header->kind = (uint16_t)kind;
+  header->index = (uint16_t)index;
+  header->size = size;
+  header->data = data;
+  if (ulog_core_registry.count < ULOG_CORE_BUFFERS) {
+    ulog_core_registry.headers[ulog_core_registry.count++] = header;
+  }
+}
+
+#endif
+
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+
+static subscriber_t *find_subscriber(ulog_function_t fn) {
+  for (int i=0; i<ULOG_MAX_SUBSCRIBERS; i++) {
+    if (ulog_config.subscribers[i].fn == fn) {
+      return &ulog_config.subscribers[i];
+    }
+  }
+  return NULL;
+}
+
+static void reset_timing(subscriber_t *subscriber) {
+  memset(&subscriber->stats, 0, sizeof(subscriber->stats));
+  subscriber->window_calls = 0;
+  subscriber->window_strikes = 0;
+  subscriber->queue.head = 0;
+  subscriber->queue.count = 0;
+}
+
+static void enqueue(subscriber_t *subscriber,
+                    ulog_level_t severity,
+                    const char *file,
+                    int line) {
+  message_queue_t *queue = &subscriber->queue;
+  if (queue->count == ULOG_ASYNC_QUEUE_DEPTH) {
+    subscriber->stats.dropped++;
+    return;
+  }
+  queued_message_t *entry =
+    &queue->entries[(queue->head + queue->count) % ULOG_ASYNC_QUEUE_DEPTH];
+  entry->severity = severity;
+  entry->file = file;
+  entry->line = line;
+  memcpy(entry->msg, ulog_config.msg, ULOG_MAX_MESSAGE_LENGTH);
+  queue->count++;
+}
+
+// account for one timed call and demote the subscriber if it was slow too
+// often within the current window.
+static void account(subscriber_t *subscriber, uint32_t elapsed_us) {
+  ulog_subscriber_stats_t *stats = &subscriber->stats;
+  stats->calls++;
+  stats->total_us += elapsed_us;
+  if (elapsed_us > stats->max_us) {
+    stats->max_us = elapsed_us;
+  }
+  if (elapsed_us > ULOG_SLOW_BUDGET_US) {
+    stats->slow_calls++;
+    subscriber->window_strikes++;
+  }
+  if (subscriber->window_strikes >= ULOG_SLOW_STRIKES) {
+    stats->demoted = true;
+    if (ulog_config.demote_fn != NULL) {
+      ulog_config.demote_fn(subscriber->fn);
+    }
+  }
+  if (++subscriber->window_calls >= ULOG_SLOW_WINDOW) {
+    subscriber->window_calls = 0;
+    subscriber->window_strikes = 0;
+  }
+}
+
+#endif
+
+#if (ULOG_STATIC_SUBSCRIBERS == 0)
+// hand the formatted message in ulog_config.msg to one subscriber.  Called
+// with the lock held.
+static void deliver(subscriber_t *subscriber,
+                    ulog_level_t severity,
+                    const char *file,
+                    int line) {
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+  if (subscriber->stats.demoted) {
+    enqueue(subscriber, severity, file, line);
+    return;
+  }
+  if (ulog_config.clock_fn != NULL) {
+    uint32_t start = ulog_config.clock_fn();
+    subscriber->fn(severity, file, line, ulog_config.msg);
+    account(subscriber, ulog_config.clock_fn() - start);
+    return;
+  }
+#endif
+  subscriber->fn(severity, file, line, ulog_config.msg);
+}
+#endif
+
+// recompute ulog_min_level after a threshold changed.  Called with the lock
+// held.
+static void update_min_level() {
+  ulog_level_t min_level = ULOG_LEVEL_N;
+  for (int i=0; i<ULOG_MAX_SUBSCRIBERS; i++) {
+    if (ulog_config.subscribers[i].fn != NULL &&
+        ulog_config.subscribers[i].threshold < min_level) {
+      min_level = ulog_config.subscribers[i].threshold;
+    }
+  }
+  ulog_min_level = min_level;
+}
+
+// true if some subscriber takes messages of severity
+static bool wanted(ulog_level_t severity) {
+#if (ULOG_STATIC_SUBSCRIBERS == 1)
+  return ulog_static_wants(severity);
+#else
+  return severity >= ulog_min_level;
+#endif
+}
+
+#if (ULOG_LEVEL_PARSE == 1)
+// case-insensitive comparison of two level names
+static bool same_name(const char *a, const char *b) {
+  for (; *a && *b; a++, b++) {
+    char ca = (*a >= 'a' && *a <= 'z') ? *a - 'a' + 'A' : *a;
+    if (ca != *b) {
+      return false;
+    }
+  }
+  return *a == *b;
+}
+#endif
+
+#if (ULOG_SITES == 1)
+
+static bool site_matches(const ulog_site_t *site, const char *file, int line) {
+  size_t site_len = strlen(site->file);
+  size_t file_len = strlen(file);
+  if (line != 0 && line != site->line) {
+    return false;
+  }
+  return file_len <= site_len &&
+         strcmp(&site->file[site_len - file_len], file) == 0;
+}
+
+// true if site has used up its messages for the current second.  Called with
+// the lock held.
+static bool rate_limited(ulog_site_t *site) {
+  uint32_t limit = site->rate_limit ? site->rate_limit : ulog_config.rate_limit;
+  if (limit == 0 || ulog_config.clock_fn == NULL) {
+    return false;
+  }
+  uint32_t now_us = ulog_config.clock_fn();
+  if (now_us - site->window_start >= 1000000) {
+    site->window_start = now_us;
+    site->window_count = 0;
+  }
+  if (site->window_count >= limit) {
+    site->suppressed++;
+    return true;
+  }
+  site->window_count++;
+  return false;
+}
+
+#if (ULOG_HOT_RELOAD == 1)
+// what the rules of update make of site
+static void site_setting(const ulog_update_t *update,
+                         const ulog_site_t *site,
+                         ulog_site_setting_t *setting) {
+  ulog_level_t min_level = ULOG_TRACE_LEVEL;
+  bool enabled = true;
+  setting->site = site;
+  setting->rate_limit = 0;
+  for (int i=0; update != NULL && i<update->rule_count; i++) {
+    const ulog_site_rule_t *rule = &update->rules[i];
+    if (!site_matches(site, rule->file, rule->line)) {
+      continue;
+    }
+    if (rule->min_level != ULOG_LEVEL_N) {
+      min_level = rule->min_level;
+    }
+    if (rule->enable != -1) {
+      enabled = rule->enable;
+    }
+    if (rule->rate_limit != -1) {
+      setting->rate_limit = (uint32_t)rule->rate_limit;
+    }
+  }
+  setting->disabled = !enabled || site->level < min_level;
+}
+
+// set site from the rules of the current update.  Called with the lock held.
+static void apply_rules(ulog_site_t *site) {
+  ulog_site_setting_t setting;
+  site_setting(ulog_config.current, site, &setting);
+  site->disabled = setting.disabled;
+  site->rate_limit = setting.rate_limit;
+}
+#endif
+
+// link a call site into the registry on its first hit.  Called with the lock
+// held.
+static void register_site(ulog_site_t *site, const char *fmt) {
+  site->fmt = fmt;
+  if (site->module == 0) {
+    site->module = ulog_module_hash(site->file);  // ulog.hpp fills it in
+  }
+  site->id = ++ulog_config.site_count;
+  site->next = ulog_config.sites;
+  ulog_config.sites = site;
+#if (ULOG_HOT_RELOAD == 1)
+  apply_rules(site);
+#endif
+}
+#endif
+
+#if (ULOG_HOT_RELOAD == 1)
+// take over the pending update.  Called with the lock held.
+static void apply_update() {
+  ulog_update_t *update = __atomic_exchange_n(&ulog_config.pending, NULL, __ATOMIC_ACQ_REL);
+  if (update == NULL) {
+    return;
+  }
+  for (int i=0; i<ULOG_MAX_SUBSCRIBERS; i++) {
+    if (ulog_config.subscribers[i].fn != NULL && update->thresholds[i] != ULOG_LEVEL_N) {
+      ulog_config.subscribers[i].threshold = update->thresholds[i];
+    }
+  }
+  update_min_level();
+  if (update->quiet != -1) {
+    ulog_config.quite = update->quiet;
+  }
+#if (ULOG_SITES == 1)
+  if (update->rate_limit != -1) {
+    ulog_config.rate_limit = (uint32_t)update->rate_limit;
+  }
+#endif
+  __atomic_store_n(&ulog_config.retired, ulog_config.current, __ATOMIC_RELEASE);
+  ulog_config.current = update;
+#if (ULOG_SITES == 1)
+  // settled sites are the oldest, in the same order as the list
+  int settled = 0;
+  for (ulog_site_t *site = ulog_config.sites; site != NULL; site = site->next) {
+    if (settled < update->setting_count && update->settings[settled].site == site) {
+      site->disabled = update->settings[settled].disabled;
+      site->rate_limit = update->settings[settled].rate_limit;
+      settled++;
+    } else {
+      apply_rules(site);    // registered since ulog_update_settle()
+    }
+  }
+#endif
+}
+#endif
+
+// ulog_vmessage() keeps its arguments here for render_vformat()
+typedef struct {
+  const char *fmt;
+  va_list ap;
+} vformat_t;
+
+static int render_vformat(char *buf, int size, void *ctx) {
+  vformat_t *vformat = (vformat_t *)ctx;
+  return VSNPRINTF(buf, size, vformat->fmt, vformat->ap);
+}
+
+static void ulog_vmessage(ulog_site_t *site,
+                          ulog_level_t severity,
+                          const char *file,
+                          int line,
+                          const char *fmt,
+                          va_list ap) {
+#if (ULOG_DEFERRED == 1)
+  if (ulog_config.quite || !wanted(severity)) {
+    return;
+  }
+  lock(true);
+  uint8_t *args = &ulog_config.record[sizeof(record_t)];
+  int room = ULOG_DEFERRED_RECORD_SIZE - (int)sizeof(record_t);
+  int len = ulog_capture_args(args, room, fmt, ap);
+  if (len >= 0) {
+    defer(site, severity, file, line, fmt, len, false);
+  } else {
+    // too many arguments to capture: keep what fits of the message instead
+    len = VSNPRINTF((char *)args, room, fmt, ap);
+    defer(site, severity, file, line, fmt, len < room ? len : room - 1, true);
+  }
+  lock(false);
+  return;
+#endif
+  vformat_t vformat;
+  vformat.fmt = fmt;
+  va_copy(vformat.ap, ap);
+  emit(site, severity, file, line, fmt, render_vformat, &vformat);
+  va_end(vformat.ap);
+}
+
+#if (ULOG_DEFERRED == 1)
+// put ulog_config.record, a header and len bytes, on the ring.  Called with the
+// lock held.
+static void defer(ulog_site_t *site,
+                  ulog_level_t severity,
+                  const char *file,
+                  int line,
+                  const char *fmt,
+                  int len,
+                  bool text) {
+  record_t header;
+  header.size = (uint16_t)(sizeof(record_t) + (len > 0 ? len : 0));
+  header.severity = (uint8_t)severity;
+  header.text = text;
+  header.line = line;
+  header.file = file;
+  header.fmt = fmt;
+  header.site = site;
+  memcpy(ulog_config.record, &header, sizeof(header));
+  if (ring_put(ulog_config.record, header.size)) {
+    ulog_config.deferred.records++;
+    ulog_config.deferred.bytes += header.size;
+    ulog_config.deferred.pending++;
+  } else {
+    ulog_config.deferred.dropped++;
+  }
+}
+
+// records are never split: one that does not fit before the end of the ring
+// starts again at 0, and ring.wrap marks where the reader must follow.
+// Called with the lock held.
+static bool ring_put(const uint8_t *record, uint32_t size) {
+  if (ulog_config.ring.used == 0) {
+    ulog_config.ring.head = 0;
+    ulog_config.ring.tail = 0;
+    ulog_config.ring.wrap = ULOG_DEFERRED_BUFFER_SIZE;
+  }
+  uint32_t head = ulog_config.ring.head;
+  uint32_t tail = ulog_config.ring.tail;
+  if (ulog_config.ring.used == 0 || head > tail) {
+    if (head + size > ULOG_DEFERRED_BUFFER_SIZE) {
+      if (size > tail) {
+        return false;
+      }
+      ulog_config.ring.wrap = head;
+      head = 0;
+    }
+  } else if (tail - head < size) {
+    return false;
+  }
+  memcpy(&ulog_config.ring.data[head], record, size);
+  ulog_config.ring.head = head + size;
+  ulog_config.ring.used += size;
+  return true;
+}
+
+// copy the oldest record into record.  Called with the lock held.
+static bool ring_get(uint8_t *record) {
+  uint16_t size;
+
+  if (ulog_config.ring.used == 0) {
+    return false;
+  }
+  if (ulog_config.ring.tail >= ulog_config.ring.wrap) {
+    ulog_config.ring.tail = 0;
+    ulog_config.ring.wrap = ULOG_DEFERRED_BUFFER_SIZE;
+  }
+  memcpy(&size, &ulog_config.ring.data[ulog_config.ring.tail], sizeof(size));
+  memcpy(record, &ulog_config.ring.data[ulog_config.ring.tail], size);
+  ulog_config.ring.tail += size;
+  ulog_config.ring.used -= size;
+  ulog_config.deferred.pending--;
+  return true;
+}
+
+// the render function of a record taken off the ring
+static int render_record(char *buf, int size, void *ctx) {
+  const uint8_t *record = (const uint8_t *)ctx;
+  record_t header;
+
+  memcpy(&header, record, sizeof(header));
+  int len = header.size - (int)sizeof(record_t);
+  if (header.text) {
+    if (len >= size) {
+      len = size - 1;
+    }
+    memcpy(buf, &record[sizeof(record_t)], len);
+    buf[len] = '\0';
+    return len;
+  }
+  return ulog_capture_render(buf, size, header.fmt, &record[sizeof(record_t)], len);
+}
+#endif
+
+// check, format and dispatch one message.  render fills ulog_config.msg.
+static void emit(ulog_site_t *site,
+                 ulog_level_t severity,
+                 const char *file,
+                 int line,
+                 const char *fmt,
+                 ulog_render_t render,
+                 void *ctx) {
+#if (ULOG_HOT_RELOAD == 1)
+  if (ulog_config.quite && __atomic_load_n(&ulog_config.pending, __ATOMIC_ACQUIRE) != NULL) {
+    lock(true);     // applies the update, which may end the quiet period
+    lock(false);
+  }
+#endif
+  if(ulog_config.quite) {
+#if (ULOG_STATS == 1)
+    ulog_config.quieted++;      // unlocked: may miss counts under contention
+#endif
+    return;
+  }
+  lock(true);
+#if (ULOG_STATS == 1)
+  if (severity < ULOG_LEVEL_N) {
+    ulog_config.messages[severity]++;
+  }
+#endif
+#if (ULOG_SITES == 1)
+  if (site != NULL) {
+    if (site->id == 0) {
+      register_site(site, fmt);
+    }
+    site->hits++;
+    if (site->disabled) {
+      lock(false);
+      return;
+    }
+  }
+#else
+  (void)site;
+  (void)fmt;
+#endif
+  if (!wanted(severity)) {
+    lock(false);          // nobody takes it: don't render
+    return;
+  }
+#if (ULOG_SITES == 1)
+  if (site != NULL && rate_limited(site)) {
+    lock(false);          // only messages that would be rendered count
+    return;
+  }
+#endif
+#if (ULOG_LOCK_STATS == 1)
+  uint32_t formatted_at = now();
+#endif
+  int len = render(ulog_config.msg, ULOG_MAX_MESSAGE_LENGTH, ctx);
+  int delivered = 0;
+#if (ULOG_LOCK_STATS == 1)
+  uint32_t dispatched_at = now();
+  record(&ulog_config.lock_stats.format, dispatched_at - formatted_at);
+#endif
+
+#if (ULOG_SITES == 1)
+  ulog_config.delivering = site;
+#endif
+#if (ULOG_STATIC_SUBSCRIBERS == 1)
+  #define ULOG_DISPATCH_(fn, threshold)                                       \
+    if (severity >= (threshold)) {                                            \
+      fn(severity, file, line, ulog_config.msg);                              \
+      delivered++;                                                            \
+    }
+  ULOG_SUBSCRIBERS(ULOG_DISPATCH_)
+  #undef ULOG_DISPATCH_
+#else
+  for (int i=0; i<ULOG_MAX_SUBSCRIBERS; i++) {
+    if (ulog_config.subscribers[i].fn != NULL) {
+      if (severity >= ulog_config.subscribers[i].threshold) {
+        deliver(&ulog_config.subscribers[i], severity, file, line);
+        delivered++;
+      }
+    }
+  }
+#endif
+#if (ULOG_SITES == 1)
+  ulog_config.delivering = NULL;
+  if (site != NULL && delivered > 0) {
+    if (len >= ULOG_MAX_MESSAGE_LENGTH) {
+      len = ULOG_MAX_MESSAGE_LENGTH - 1;    // render() truncated
+    }
+    site->emitted++;
+    site->bytes += (len > 0) ? len : 0;
+  }
+#else
+  (void)len;
+  (void)delivered;
+#endif
+#if (ULOG_LOCK_STATS == 1)
+  record(&ulog_config.lock_stats.dispatch, now() - dispatched_at);
+#endif
+#if (ULOG_SHM_STATS == 1)
+  publish_stats();
+#endif
+  lock(false);
+}
+
 #endif  // #ifdef ULOG_ENABLED
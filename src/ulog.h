@@ -64,6 +64,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define ULOG_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "ulog_config.h"
 
 #ifdef __cplusplus
@@ -80,6 +81,103 @@ typedef enum {
   ULOG_LEVEL_N
 } ulog_level_t;
 
+/**
+ * @brief: static record of one ULOG_xxx() statement.
+ *
+ * With ULOG_SITES enabled, every logging macro expands into a static
+ * ulog_site_t.  It is linked into the site registry the first time the
+ * statement executes.  The counters are only updated while the uLog lock is
+ * held.
+ */
+typedef struct ulog_site {
+  const char *file;
+  int line;
+  ulog_level_t level;
+  uint32_t module;          // ulog_module_hash(file), 0 until the first hit
+  const char *fmt;          // format string, captured on first hit
+  struct ulog_site *next;   // next site in the registry
+  uint32_t id;              // 1, 2, 3... in order of first hit.  0 = unseen.
+  uint32_t hits;            // times the statement executed
+  uint32_t emitted;         // times the message reached a subscriber
+  uint32_t bytes;           // formatted bytes delivered to subscribers
+  uint32_t suppressed;      // times dropped by the site's rate limit
+  bool disabled;            // set by ulog_site_enable(): statement is ignored
+  uint32_t rate_limit;      // messages per second, 0 = use the default
+  uint32_t window_start;    // clock at the start of the current second
+  uint32_t window_count;    // messages logged in the current second
+} ulog_site_t;
+
+#if defined(__GNUC__)
+  #define ULOG_SITE_ALIGN __attribute__((aligned(ULOG_CACHE_LINE_SIZE)))
+#else
+  #define ULOG_SITE_ALIGN
+#endif
+
+// the file name the ULOG_xxx() macros report.  See ULOG_FILE_NAME.
+#if (ULOG_FILE_NAME == 1) && defined(__FILE_NAME__)
+  #define ULOG_FILE __FILE_NAME__
+#else
+  #define ULOG_FILE __FILE__
+#endif
+
+// see ULOG_COLD_CALLS.  ULOG_COLD marks the logging functions as rarely
+// called, which makes the compiler move the calls into a separate cold
+// section of the caller.  ulog.c defines ULOG_LIBRARY_ so that the library
+// itself is still optimized for speed.
+#if (ULOG_COLD_CALLS == 1) && defined(__GNUC__)
+  #define ULOG_COLD __attribute__((cold, noinline))
+  #define ULOG_UNLIKELY_(level, x)                                            \
+    ((level) < ULOG_LIKELY_LEVEL ? __builtin_expect(!!(x), 0) : (x))
+#else
+  #define ULOG_COLD
+  #define ULOG_UNLIKELY_(level, x) (x)
+#endif
+#if defined(ULOG_LIBRARY_)
+  #define ULOG_COLD_API_
+#else
+  #define ULOG_COLD_API_ ULOG_COLD
+#endif
+
+// the call site record of a statement, or NULL without ULOG_SITES
+#if (ULOG_SITES == 1)
+  #define ULOG_SITE_(site_level)                                              \
+    static ULOG_SITE_ALIGN ulog_site_t ulog_site_ =                           \
+      { .file = ULOG_FILE, .line = __LINE__, .level = (site_level) };         \
+    ulog_site_t *ulog_site_ptr_ = &ulog_site_
+#else
+  #define ULOG_SITE_(level) ulog_site_t *ulog_site_ptr_ = NULL
+#endif
+
+#if (ULOG_ENABLED == 1)
+  // log what render(buf, size, ctx) writes, see ulog_render_t.  render is
+  // only called once the message passed the level, call site and rate limit
+  // checks, so it may do expensive work such as serializing a request.
+  #define ULOG_LAZY(level, render, ctx) do {                                  \
+    if (ULOG_UNLIKELY_(level, ulog_wants(level))) {                           \
+      ULOG_SITE_(level);                                                      \
+      ulog_render_message(ulog_site_ptr_, level, ULOG_FILE, __LINE__, #render, \
+                          render, ctx);                                       \
+    }                                                                         \
+  } while (0)
+#else
+  #define ULOG_LAZY(level, render, ctx)
+#endif
+
+#if (ULOG_ENABLED == 1) && (ULOG_SITES == 1)
+  #define ULOG_AT_(level, ...) do {                                             \
+    if (ULOG_UNLIKELY_(level, ulog_wants(level))) {                           \
+      ULOG_SITE_(level);                                                      \
+      ulog_site_message(ulog_site_ptr_, __VA_ARGS__);                         \
+    }                                                                         \
+  } while (0)
+#else
+  #define ULOG_AT_(level, ...) do {                                             \
+    if (ULOG_UNLIKELY_(level, ulog_wants(level))) {                           \
+      ulog_message(level, ULOG_FILE, __LINE__, __VA_ARGS__);                  \
+    }                                                                         \
+  } while (0)
+#endif
+
 #if (ULOG_ENABLED == 1)
   #define ULOG_INIT() ulog_init()
   #define ULOG_SUBSCRIBE(a, b) ulog_subscribe(a, b)
@@ -87,12 +185,21 @@ typedef enum {
   #define ulog_level_name(a) ulog_level_name(a)
   #define ulog_set_quite(a) ulog_set_quite(a)
   #define ulog_set_lock(a) ulog_set_lock(a)
-  #define ULOG_TRACE(...) ulog_message(ULOG_TRACE_LEVEL, __FILE__, __LINE__, __VA_ARGS__)
-  #define ULOG_DEBUG(...) ulog_message(ULOG_DEBUG_LEVEL, __FILE__, __LINE__, __VA_ARGS__)
-  #define ULOG_INFO(...) ulog_message(ULOG_INFO_LEVEL, __FILE__, __LINE__, __VA_ARGS__)
-  #define ULOG_WARNING(...) ulog_message(ULOG_WARNING_LEVEL, __FILE__, __LINE__, __VA_ARGS__)
-  #define ULOG_ERROR(...) ulog_message(ULOG_ERROR_LEVEL, __FILE__, __LINE__, __VA_ARGS__)
-  #define ULOG_CRITICAL(...) ulog_message(ULOG_CRITICAL_LEVEL, __FILE__, __LINE__, __VA_ARGS__)
+  #define ulog_site_dump(a, b) ulog_site_dump(a, b)
+  #define ulog_site_reset() ulog_site_reset()
+  #define ulog_set_clock(a) ulog_set_clock(a)
+  #define ulog_set_demote_handler(a) ulog_set_demote_handler(a)
+  #define ulog_drain() ulog_drain()
+  #define ulog_level_parse(a) ulog_level_parse(a)
+  #define ulog_module_hash(a) ulog_module_hash(a)
+  #define ulog_lock_stats_dump(a) ulog_lock_stats_dump(a)
+  #define ulog_lock_stats_reset() ulog_lock_stats_reset()
+  #define ULOG_TRACE(...) ULOG_AT_(ULOG_TRACE_LEVEL, __VA_ARGS__)
+  #define ULOG_DEBUG(...) ULOG_AT_(ULOG_DEBUG_LEVEL, __VA_ARGS__)
+  #define ULOG_INFO(...) ULOG_AT_(ULOG_INFO_LEVEL, __VA_ARGS__)
+  #define ULOG_WARNING(...) ULOG_AT_(ULOG_WARNING_LEVEL, __VA_ARGS__)
+  #define ULOG_ERROR(...) ULOG_AT_(ULOG_ERROR_LEVEL, __VA_ARGS__)
+  #define ULOG_CRITICAL(...) ULOG_AT_(ULOG_CRITICAL_LEVEL, __VA_ARGS__)
 #else
   // uLog vanishes when disabled at compile time...
   #define ULOG_INIT()
@@ -101,6 +208,15 @@ typedef enum {
   #define ulog_level_name(a)
   #define ulog_set_quite(a)
   #define ulog_set_lock(a)
+  #define ulog_site_dump(a, b)
+  #define ulog_site_reset()
+  #define ulog_set_clock(a)
+  #define ulog_set_demote_handler(a)
+  #define ulog_drain()
+  #define ulog_level_parse(a) ULOG_LEVEL_N
+  #define ulog_module_hash(a) 0
+  #define ulog_lock_stats_dump(a)
+  #define ulog_lock_stats_reset()
   #define ULOG_TRACE(f, ...)
   #define ULOG_DEBUG(f, ...)
   #define ULOG_INFO(f, ...)
@@ -113,6 +229,10 @@ typedef enum {
   ULOG_ERR_NONE = 0,
   ULOG_ERR_SUBSCRIBERS_EXCEEDED,
   ULOG_ERR_NOT_SUBSCRIBED,
+  ULOG_ERR_SYSTEM,          // an operating system call failed, see errno
+  ULOG_ERR_NO_SUCH_SITE,
+  ULOG_ERR_STATIC_SUBSCRIBERS,  // subscribers are fixed by ULOG_SUBSCRIBERS
+  ULOG_ERR_NO_ROOM,             // a fixed-size table is full
 } ulog_err_t;
 
 /**
@@ -125,6 +245,140 @@ typedef void (*ulog_function_t)(ulog_level_t severity, const char *file, int lin
  */
 typedef void (*ulog_lock_t)(bool lock);
 
+/**
+ * @brief: prototype for functions that format a message into buf.
+ *
+ * Like snprintf(), a render function writes at most size bytes including
+ * the terminating '\0' and returns the length the message would have had.
+ * It is called with the uLog lock held.
+ */
+typedef int (*ulog_render_t)(char *buf, int size, void *ctx);
+
+/**
+ * @brief: prototype for line printers used by the report functions.
+ */
+typedef void (*ulog_print_t)(const char *line);
+
+/**
+ * @brief: prototype for the clock function: a free-running microsecond
+ * counter.  Wrap-around is harmless since only differences are used.
+ */
+typedef uint32_t (*ulog_clock_t)(void);
+
+/**
+ * @brief: prototype for the function told that a subscriber was moved to its
+ * async queue.  It is called with the uLog lock held and must not log.
+ */
+typedef void (*ulog_demote_t)(ulog_function_t fn);
+
+/**
+ * @brief: timing of one subscriber, see ulog_subscriber_stats().
+ */
+typedef struct {
+  uint32_t calls;           // synchronous calls timed
+  uint32_t slow_calls;      // calls that took longer than ULOG_SLOW_BUDGET_US
+  uint32_t total_us;        // time spent in synchronous calls
+  uint32_t max_us;          // longest synchronous call
+  bool demoted;             // messages now go through the async queue
+  uint32_t queued;          // messages waiting for ulog_drain()
+  uint32_t dropped;         // messages lost because the queue was full
+} ulog_subscriber_stats_t;
+
+/**
+ * @brief: distribution of durations.  buckets[0] counts durations under 1
+ * microsecond, buckets[n] those from 2^(n-1) up to 2^n microseconds.  The
+ * last bucket also holds everything longer.
+ */
+typedef struct {
+  uint32_t count;
+  uint32_t total_us;
+  uint32_t max_us;
+  uint32_t buckets[ULOG_HISTOGRAM_BUCKETS];
+} ulog_histogram_t;
+
+/**
+ * @brief: lock contention, see ulog_lock_stats().
+ */
+typedef struct {
+  ulog_histogram_t wait;    // from asking for the lock to getting it
+  ulog_histogram_t hold;    // from getting the lock to releasing it
+  ulog_histogram_t format;  // ulog_message(): formatting, lock held
+  ulog_histogram_t dispatch;// ulog_message(): calling subscribers, lock held
+} ulog_lock_stats_t;
+
+/**
+ * @brief: one subscriber as seen by ulog_stats().
+ */
+typedef struct {
+  ulog_function_t fn;       // NULL for a free slot
+  ulog_level_t threshold;
+  ulog_subscriber_stats_t timing;
+} ulog_subscriber_info_t;
+
+/**
+ * @brief: settings for the call sites matching file:line, see ulog_update_t.
+ */
+typedef struct {
+  const char *file;         // matched against the end of the site's file name
+  int line;                 // 0 matches every line
+  ulog_level_t min_level;   // sites below this level are off.  ULOG_LEVEL_N: unchanged
+  int enable;               // 1: on, 0: off, -1: unchanged
+  int64_t rate_limit;       // messages per second, 0: default, -1: unchanged
+} ulog_site_rule_t;
+
+/**
+ * @brief: the rules of an update applied to one call site, see
+ * ulog_update_settle().
+ */
+typedef struct {
+  const ulog_site_t *site;
+  bool disabled;
+  uint32_t rate_limit;
+} ulog_site_setting_t;
+
+/**
+ * @brief: a complete logging configuration, see ulog_update_publish().
+ *
+ * Call sites not matched by any rule are on and use the default rate limit.
+ * Rules are applied in order, later ones win.  The rules also apply to sites
+ * that register after the update.  settings, filled in by
+ * ulog_update_settle(), hold the result for the sites registered by then, so
+ * that taking the update over only copies them; the rules are matched there
+ * against the other sites alone.
+ */
+typedef struct {
+  ulog_level_t thresholds[ULOG_MAX_SUBSCRIBERS];  // ULOG_LEVEL_N: unchanged
+  int quiet;                // 1: ulog_set_quite(true), 0: false, -1: unchanged
+  int64_t rate_limit;       // default per-site limit, -1: unchanged
+  int rule_count;
+  const ulog_site_rule_t *rules;
+  int setting_count;
+  const ulog_site_setting_t *settings;  // newest site first, may be NULL
+} ulog_update_t;
+
+/**
+ * @brief: every counter uLog keeps, see ulog_stats().  Counters of features
+ * that are compiled out read as zero.
+ */
+typedef struct {
+  uint32_t messages[ULOG_LEVEL_N];  // ulog_message() calls per level
+  uint32_t quieted;                 // calls ignored by ulog_set_quite()
+  uint32_t queued;                  // messages waiting in async queues
+  uint32_t dropped;                 // messages lost to full async queues
+  ulog_subscriber_info_t subscribers[ULOG_MAX_SUBSCRIBERS];
+  ulog_lock_stats_t lock;
+} ulog_stats_t;
+
+/**
+ * @brief: counters of the deferred ring, see ulog_deferred_stats().
+ */
+typedef struct {
+  uint32_t records;         // messages captured
+  uint32_t bytes;           // bytes captured, record headers included
+  uint32_t dropped;         // messages lost to a full ring
+  uint32_t pending;         // messages waiting for ulog_deferred_flush()
+} ulog_deferred_stats_t;
+
 
 #if (ULOG_ENABLED == 1)
 void ulog_init();
@@ -132,12 +386,228 @@ ulog_err_t ulog_subscribe(ulog_function_t fn, ulog_level_t threshold);
 ulog_err_t ulog_unsubscribe(ulog_function_t fn);
 void ulog_set_lock(ulog_lock_t lock_fn);
 const char *ulog_level_name(ulog_level_t level);
+
+/**
+ * @brief: the level called name, as returned by ulog_level_name() or spelled
+ * out in full ("WARNING", "CRITICAL"), in any case.  ULOG_LEVEL_N if unknown.
+ * Built when ULOG_LEVEL_PARSE is 1.
+ */
+ulog_level_t ulog_level_parse(const char *name);
+
+/**
+ * @brief: the subscriber in table slot 0..ULOG_MAX_SUBSCRIBERS-1.
+ *
+ * Returns ULOG_ERR_NOT_SUBSCRIBED for a free slot.  Built for ULOG_CTL.
+ */
+ulog_err_t ulog_subscriber_get(int slot, ulog_function_t *fn, ulog_level_t *threshold);
 void ulog_set_quite(bool set);
-void ulog_message(ulog_level_t severity, const char *file, int line, const char *fmt, ...);
+
+/**
+ * @brief: the lowest threshold of any subscriber, ULOG_LEVEL_N if there are
+ * none.  Read without the lock by ulog_wants(); kept up to date by uLog.
+ */
+extern ulog_level_t ulog_min_level;
+
+ULOG_COLD_API_ void ulog_message(ulog_level_t severity, const char *file, int line, const char *fmt, ...);
+void ulog_set_clock(ulog_clock_t clock_fn);
+
+/**
+ * @brief: 32 bit FNV-1a hash of file, a stable number that identifies the
+ * module a message came from.  ulog.hpp computes the same value at compile
+ * time with ulog::module_hash().
+ */
+uint32_t ulog_module_hash(const char *file);
+
+/**
+ * @brief: like ulog_message(), but the message is formatted by render(ctx)
+ * straight into uLog's message buffer, and only if some subscriber takes it.
+ * fmt is only recorded in the call site, site may be NULL.  Used by
+ * ULOG_LAZY() and by front ends that format without va_list, such as
+ * ulog.hpp.
+ */
+ULOG_COLD_API_ void ulog_render_message(ulog_site_t *site,
+                         ulog_level_t severity,
+                         const char *file,
+                         int line,
+                         const char *fmt,
+                         ulog_render_t render,
+                         void *ctx);
+#endif
+
+#if (ULOG_ENABLED == 1) && (ULOG_SUBSCRIBER_TIMING == 1)
+/**
+ * @brief: install the function told about demoted subscribers.
+ */
+void ulog_set_demote_handler(ulog_demote_t demote_fn);
+
+/**
+ * @brief: copy the timing of subscriber fn into stats.
+ */
+ulog_err_t ulog_subscriber_stats(ulog_function_t fn, ulog_subscriber_stats_t *stats);
+
+/**
+ * @brief: deliver the messages queued for demoted subscribers.
+ *
+ * Call from a single background task or idle loop.  The uLog lock is released
+ * while the slow subscriber runs, so ulog_message() never waits for it.
+ * Returns the number of messages delivered.
+ */
+int ulog_drain();
+#endif
+
+#if (ULOG_ENABLED == 1) && (ULOG_HOT_RELOAD == 1)
+/**
+ * @brief: hand a new configuration to uLog without taking the uLog lock.
+ *
+ * The update is stored with one atomic pointer exchange and applied by the
+ * next thread that takes the uLog lock, typically the next ulog_message().
+ * uLog keeps using the update until the next one is applied.  Returns an
+ * earlier update that uLog no longer references, which the caller may free,
+ * or NULL.  Only one thread may publish updates.
+ */
+ulog_update_t *ulog_update_publish(ulog_update_t *update);
+
+/**
+ * @brief: match the rules of update against every call site registered so
+ * far, in the publishing thread rather than in ulog_message().
+ *
+ * Writes one setting per site into settings, newest first, and returns the
+ * number of sites.  If that is more than capacity, nothing is kept: call
+ * again with room for them all.  Otherwise update->settings and
+ * update->setting_count are set.  Call before ulog_update_publish(); settings
+ * must live as long as the update.
+ */
+int ulog_update_settle(ulog_update_t *update, ulog_site_setting_t *settings, int capacity);
+#endif
+
+#if (ULOG_ENABLED == 1) && (ULOG_DEFERRED == 1)
+/**
+ * @brief: format and deliver the messages captured since the last call.
+ *
+ * Call from a single background task or idle loop.  The uLog lock is only
+ * held while a record is taken off the ring and while it is delivered.
+ * Returns the number of messages taken.
+ */
+int ulog_deferred_flush();
+
+/**
+ * @brief: copy the counters of the deferred ring into stats.
+ */
+void ulog_deferred_stats(ulog_deferred_stats_t *stats);
+#endif
+
+#if (ULOG_ENABLED == 1) && (ULOG_STATS == 1)
+/**
+ * @brief: take a consistent snapshot of all uLog counters.
+ */
+void ulog_stats(ulog_stats_t *stats);
+#endif
+
+#if (ULOG_ENABLED == 1) && (ULOG_LOCK_STATS == 1)
+/**
+ * @brief: copy the lock wait and hold time histograms into stats.
+ */
+void ulog_lock_stats(ulog_lock_stats_t *stats);
+
+/**
+ * @brief: print the lock histograms, one line per histogram.
+ */
+void ulog_lock_stats_dump(ulog_print_t print);
+
+/**
+ * @brief: zero the lock histograms.
+ */
+void ulog_lock_stats_reset();
+#endif
+
+#if (ULOG_ENABLED == 1) && (ULOG_SITES == 1)
+ULOG_COLD_API_ void ulog_site_message(ulog_site_t *site, const char *fmt, ...);
+
+/**
+ * @brief: the call site of the message being delivered, for subscribers that
+ * want its file name or module hash without scanning the file argument.
+ *
+ * Only valid inside a subscriber called from ULOG_xxx(); NULL for messages
+ * without a call site and for those delivered by ulog_drain().
+ */
+const ulog_site_t *ulog_current_site();
+
+/**
+ * @brief: fill sites[] with up to k call sites, most bytes first.
+ *
+ * Returns the number of entries written.  The pointers stay valid for the
+ * life of the program, the counters keep changing.
+ */
+int ulog_site_top(const ulog_site_t **sites, int k);
+
+/**
+ * @brief: print the k noisiest call sites, one line each, with their
+ * counters, file:line and format string.  At most ULOG_SITE_DUMP_MAX.
+ */
+void ulog_site_dump(ulog_print_t print, int k);
+
+/**
+ * @brief: zero the counters of every registered call site.
+ */
+void ulog_site_reset();
+
+/**
+ * @brief: the most recently registered call site.  Follow site->next for the
+ * others.  Sites are never unregistered.
+ */
+const ulog_site_t *ulog_site_first();
+
+/**
+ * @brief: enable or disable the call sites at file:line.
+ *
+ * file matches any site whose file name ends with it, line 0 matches every
+ * line.  Only sites that already executed once are known.
+ */
+ulog_err_t ulog_site_enable(const char *file, int line, bool enable);
+
+/**
+ * @brief: limit the call sites at file:line to per_second messages per
+ * second, 0 for the default.  A NULL file changes the default instead.
+ */
+ulog_err_t ulog_site_set_rate_limit(const char *file, int line, uint32_t per_second);
 #endif
 
 #ifdef __cplusplus
 }
 #endif
 
+#if (ULOG_STATIC_SUBSCRIBERS == 1)
+#include ULOG_SUBSCRIBERS_H
+
+/**
+ * @brief: true if any static subscriber takes messages of level.  A constant
+ * when level is.
+ */
+static inline bool ulog_static_wants(ulog_level_t level) {
+  #define ULOG_WANTS_(fn, threshold) || level >= (threshold)
+  return false ULOG_SUBSCRIBERS(ULOG_WANTS_);
+  #undef ULOG_WANTS_
+}
+#endif
+
+#if (ULOG_ENABLED == 1)
+/**
+ * @brief: false if no subscriber will take a message of level.  Inlined into
+ * every ULOG_xxx() statement, so a filtered statement costs one load and one
+ * compare and does not evaluate its arguments.  A constant with static
+ * subscribers.  Always true with ULOG_SITES or ULOG_STATS, which count every
+ * statement executed.
+ */
+static inline bool ulog_wants(ulog_level_t level) {
+#if (ULOG_STATIC_SUBSCRIBERS == 1)
+  return ulog_static_wants(level);
+#elif (ULOG_SITES == 0) && (ULOG_STATS == 0)
+  return level >= ulog_min_level;
+#else
+  (void)level;
+  return true;
+#endif
+}
+#endif
+
 #endif /* ULOG_H_ */
@@ -0,0 +1,704 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog.hpp
+ *
+ * \brief uLog: type-safe C++17 front end, header only
+ *
+ * Include ulog.hpp instead of ulog.h in C++ code.  The ULOG_xxx() macros keep
+ * their names and printf-style format strings, but:
+ *
+ * - the format string is checked against the argument types at compile time.
+ *   A wrong argument count or a conversion that does not fit its argument is
+ *   a compile error, not undefined behaviour at run time.
+ * - arguments are captured into an array of typed values, the encoding
+ *   chosen per type with if constexpr, and formatted from there straight into
+ *   uLog's message buffer.  No va_list is involved.
+ * - %s also accepts std::string and std::string_view, and signed values
+ *   printed with %x keep the width of their own type.
+ *
+ * Messages go through ulog_render_message(), so the subscribers, call sites
+ * and statistics of the C library see them like any other message.
+ *
+ *     #include "ulog.hpp"
+ *
+ *     std::string user = "ada";
+ *     ULOG_INFO("user %s logged in after %d tries", user, 3);
+ *     ULOG_INFO("user %d logged in", user);   // does not compile
+ */
+
+#ifndef ULOG_HPP_
+#define ULOG_HPP_
+
+#include "ulog.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace ulog {
+
+// =============================================================================
+// file names and module hashes, evaluated at compile time
+
+/**
+ * @brief: offset of the file name within path: past the last slash or backslash.
+ */
+constexpr std::size_t file_name_offset(const char *path) {
+  std::size_t offset = 0;
+  for (std::size_t i = 0; path[i] != '\0'; i++) {
+    if (path[i] == '/' || path[i] == '\\') {
+      offset = i + 1;
+    }
+  }
+  return offset;
+}
+
+/**
+ * @brief: same as ulog_module_hash(), usable in constant expressions.
+ */
+constexpr uint32_t module_hash(const char *file) {
+  uint32_t hash = 2166136261u;
+  for (; *file != '\0'; file++) {
+    hash = (hash ^ static_cast<uint8_t>(*file)) * 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * @brief: a call site with every field but its location and module zeroed.
+ */
+constexpr ulog_site_t make_site(const char *file, int line, ulog_level_t level) {
+  ulog_site_t site{};
+  site.file = file;
+  site.line = line;
+  site.level = level;
+  site.module = module_hash(file);
+  return site;
+}
+
+namespace detail {
+
+// =============================================================================
+// compile-time format checking
+
+enum class arg_kind : uint8_t {
+  signed_int,
+  unsigned_int,
+  floating,
+  string,
+  pointer,
+  invalid,
+};
+
+/**
+ * @brief: true for arguments computed on demand: objects callable without
+ * arguments, such as lambdas.  They are called only once uLog has decided to
+ * log the message, and their result is formatted instead.
+ */
+template <typename T>
+inline constexpr bool is_lazy_v =
+  std::is_class_v<std::decay_t<T>> && std::is_invocable_v<const std::decay_t<T> &>;
+
+template <typename T>
+constexpr arg_kind kind_of() {
+  using U = std::decay_t<T>;
+  if constexpr (is_lazy_v<U>) {
+    return kind_of<std::invoke_result_t<const U &>>();
+  } else if constexpr (std::is_enum_v<U>) {
+    return kind_of<std::underlying_type_t<U>>();
+  } else if constexpr (std::is_integral_v<U>) {
+    return std::is_signed_v<U> ? arg_kind::signed_int : arg_kind::unsigned_int;
+  } else if constexpr (std::is_floating_point_v<U>) {
+    return arg_kind::floating;
+  } else if constexpr (std::is_convertible_v<const U &, std::string_view>) {
+    return arg_kind::string;
+  } else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>) {
+    return arg_kind::pointer;
+  } else {
+    return arg_kind::invalid;
+  }
+}
+
+enum class format_error {
+  none,
+  too_few_arguments,
+  too_many_arguments,
+  type_mismatch,
+  bad_conversion,
+};
+
+constexpr bool is_integer(arg_kind kind) {
+  return kind == arg_kind::signed_int || kind == arg_kind::unsigned_int;
+}
+
+constexpr bool is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// check one printf conversion character against the kind of its argument
+constexpr format_error check_conversion(char conversion, arg_kind kind) {
+  switch (conversion) {
+  case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+    return is_integer(kind) ? format_error::none : format_error::type_mismatch;
+  case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+    return (kind == arg_kind::floating) ? format_error::none : format_error::type_mismatch;
+  case 's':
+    return (kind == arg_kind::string) ? format_error::none : format_error::type_mismatch;
+  case 'p':
+    return (kind == arg_kind::pointer || kind == arg_kind::string) ?
+      format_error::none : format_error::type_mismatch;
+  default:
+    return format_error::bad_conversion;      // including %n
+  }
+}
+
+template <typename... Args>
+constexpr format_error check_format(const char *fmt) {
+  constexpr arg_kind kinds[] = { kind_of<Args>()..., arg_kind::invalid };
+  constexpr std::size_t count = sizeof...(Args);
+  std::size_t next = 0;
+
+  for (const char *p = fmt; *p; p++) {
+    if (*p != '%') {
+      continue;
+    }
+    if (*++p == '%') {
+      continue;
+    }
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') {
+      p++;
+    }
+    for (int field = 0; field < 2; field++) {  // width, then precision
+      if (field == 1) {
+        if (*p != '.') {
+          break;
+        }
+        p++;
+      }
+      if (*p == '*') {
+        if (next == count) {
+          return format_error::too_few_arguments;
+        }
+        if (!is_integer(kinds[next++])) {
+          return format_error::type_mismatch;
+        }
+        p++;
+      }
+      while (is_digit(*p)) {
+        p++;
+      }
+    }
+    while (*p == 'h' || *p == 'l' || *p == 'L' || *p == 'j' || *p == 'z' || *p == 't') {
+      p++;                      // length modifiers: the type is known anyway
+    }
+    if (*p == '\0') {
+      return format_error::bad_conversion;
+    }
+    if (next == count) {
+      return format_error::too_few_arguments;
+    }
+    format_error error = check_conversion(*p, kinds[next++]);
+    if (error != format_error::none) {
+      return error;
+    }
+  }
+  return (next == count) ? format_error::none : format_error::too_many_arguments;
+}
+
+// Used by the macros: Tuple is std::tuple<format, arguments...>
+template <typename Tuple> struct format_checker;
+
+template <typename Format, typename... Args>
+struct format_checker<std::tuple<Format, Args...>> {
+  static_assert(std::is_convertible_v<Format, const char *>,
+                "uLog: the format must be a string literal");
+  static constexpr format_error check(const char *fmt) {
+    return check_format<Args...>(fmt);
+  }
+};
+
+template <format_error error>
+constexpr void assert_format() {
+  static_assert(error != format_error::too_few_arguments,
+                "uLog: the format string needs more arguments");
+  static_assert(error != format_error::too_many_arguments,
+                "uLog: more arguments than the format string uses");
+  static_assert(error != format_error::type_mismatch,
+                "uLog: an argument does not match its conversion");
+  static_assert(error != format_error::bad_conversion,
+                "uLog: unknown or unsupported conversion in the format string");
+}
+
+// =============================================================================
+// argument capture
+
+struct arg {
+  arg_kind kind;
+  uint8_t size;                 // sizeof the original integer
+  union {
+    long long i;
+    unsigned long long u;
+    double d;
+    const void *p;
+    struct {
+      const char *ptr;
+      std::size_t len;          // npos: NUL terminated
+    } s;
+  };
+};
+
+constexpr std::size_t npos = ~std::size_t(0);
+
+template <typename T>
+arg make_arg(const T &value) {
+  using U = std::decay_t<T>;
+  arg a{};
+  a.kind = kind_of<U>();
+  if constexpr (std::is_enum_v<U>) {
+    a = make_arg(static_cast<std::underlying_type_t<U>>(value));
+  } else if constexpr (std::is_integral_v<U>) {
+    a.size = sizeof(U);
+    if constexpr (std::is_signed_v<U>) {
+      a.i = value;
+    } else {
+      a.u = value;
+    }
+  } else if constexpr (std::is_floating_point_v<U>) {
+    a.d = static_cast<double>(value);
+  } else if constexpr (std::is_same_v<U, char *> || std::is_same_v<U, const char *>) {
+    a.s.ptr = value;            // length found while formatting, within %.Ns
+    a.s.len = npos;
+  } else if constexpr (std::is_convertible_v<const U &, std::string_view>) {
+    std::string_view view(value);
+    a.s.ptr = view.data();
+    a.s.len = view.size();
+  } else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>) {
+    a.p = reinterpret_cast<const void *>(value);
+  } else {
+    static_assert(sizeof(U) == 0, "uLog: this type cannot be logged");
+  }
+  return a;
+}
+
+// =============================================================================
+// formatting
+
+struct message {
+  const char *fmt;
+  const arg *args;
+  std::size_t count;
+};
+
+// snprintf()-like output: counts everything, stores what fits
+struct writer {
+  char *buf;
+  int size;
+  int pos;
+
+  void put(char c) {
+    if (pos < size - 1) {
+      buf[pos] = c;
+    }
+    pos++;
+  }
+  // room left for n more characters, keeping one for the '\0'
+  int room(int n) const {
+    int left = size - 1 - pos;
+    return (left <= 0) ? 0 : (n < left) ? n : left;
+  }
+  void put(const char *s, int n) {
+    if (room(n) > 0) {          // s may be the NULL of an empty string_view
+      std::memcpy(&buf[pos], s, room(n));
+    }
+    pos += n;
+  }
+  void pad(char c, int n) {
+    if (pos < size) {           // past the end, &buf[pos] is out of bounds
+      std::memset(&buf[pos], c, room(n));
+    }
+    pos += n;
+  }
+  int finish() {
+    if (size > 0) {
+      buf[(pos < size) ? pos : size - 1] = '\0';
+    }
+    return pos;
+  }
+};
+
+struct spec {
+  bool left, plus, space, alt, zero;
+  int width;
+  int precision;                // -1: none
+  char conversion;
+};
+
+inline long long int_value(const arg &a) {
+  return (a.kind == arg_kind::signed_int) ? a.i : static_cast<long long>(a.u);
+}
+
+// the value reinterpreted as unsigned in the width of its own type, as
+// printf("%x", -1) does for an int
+inline unsigned long long unsigned_value(const arg &a) {
+  if (a.kind != arg_kind::signed_int || a.size >= sizeof(unsigned long long)) {
+    return a.u;
+  }
+  return a.u & ((1ULL << (a.size * 8)) - 1);
+}
+
+inline void write_padded(writer &out, const spec &s, const char *prefix, int prefix_len,
+                         const char *body, int body_len, int zeros) {
+  int len = prefix_len + zeros + body_len;
+  int fill = (s.width > len) ? s.width - len : 0;
+  if (!s.left && !s.zero) {
+    out.pad(' ', fill);
+  }
+  out.put(prefix, prefix_len);
+  if (!s.left && s.zero) {
+    out.pad('0', fill);
+  }
+  out.pad('0', zeros);
+  out.put(body, body_len);
+  if (s.left) {
+    out.pad(' ', fill);
+  }
+}
+
+inline void write_integer(writer &out, spec s, const arg &a) {
+  char digits[24];
+  char prefix[3];
+  int prefix_len = 0;
+  int n = 0;
+  unsigned long long value;
+  unsigned base = 10;
+  const char *hex = (s.conversion == 'X') ? "0123456789ABCDEF" : "0123456789abcdef";
+
+  if (s.conversion == 'd' || s.conversion == 'i') {
+    long long v = int_value(a);
+    value = (v < 0) ? 0ULL - static_cast<unsigned long long>(v) : static_cast<unsigned long long>(v);
+    if (v < 0) {
+      prefix[prefix_len++] = '-';
+    } else if (s.plus) {
+      prefix[prefix_len++] = '+';
+    } else if (s.space) {
+      prefix[prefix_len++] = ' ';
+    }
+  } else {
+    value = unsigned_value(a);
+    base = (s.conversion == 'o') ? 8 : (s.conversion == 'u') ? 10 : 16;
+  }
+  while (value != 0) {
+    digits[n++] = hex[value % base];
+    value /= base;
+  }
+  if (n == 0 && s.precision != 0) {
+    digits[n++] = '0';
+  }
+  if (s.alt && base == 16 && n > 0 && !(n == 1 && digits[0] == '0')) {
+    prefix[prefix_len++] = '0';
+    prefix[prefix_len++] = s.conversion;
+  } else if (s.alt && base == 8 && (n == 0 || digits[n - 1] != '0')) {
+    digits[n++] = '0';
+  }
+  for (int i = 0; i < n / 2; i++) {
+    char c = digits[i];
+    digits[i] = digits[n - 1 - i];
+    digits[n - 1 - i] = c;
+  }
+  int zeros = (s.precision > n) ? s.precision - n : 0;
+  if (s.precision >= 0) {
+    s.zero = false;             // as in printf, a precision disables '0'
+  }
+  write_padded(out, s, prefix, prefix_len, digits, n, zeros);
+}
+
+inline void write_string(writer &out, spec s, const char *str, std::size_t len) {
+  if (str == nullptr) {
+    str = "(null)";
+    len = npos;
+  }
+  std::size_t limit = (s.precision >= 0) ? static_cast<std::size_t>(s.precision) : npos;
+  if (len == npos) {
+    len = 0;
+    while (len < limit && str[len] != '\0') {
+      len++;
+    }
+  } else if (len > limit) {
+    len = limit;
+  }
+  s.zero = false;
+  write_padded(out, s, "", 0, str, static_cast<int>(len), 0);
+}
+
+inline void write_floating(writer &out, const spec &s, double value) {
+  // rebuild the conversion for the C library, keeping the width small
+  // enough for the local buffer
+  char format[16];
+  char text[96];
+  int n = 0;
+  format[n++] = '%';
+  if (s.left) format[n++] = '-';
+  if (s.plus) format[n++] = '+';
+  if (s.space) format[n++] = ' ';
+  if (s.alt) format[n++] = '#';
+  if (s.zero) format[n++] = '0';
+  format[n++] = '*';
+  format[n++] = '.';
+  format[n++] = '*';
+  format[n++] = s.conversion;
+  format[n] = '\0';
+  int width = (s.width < 64) ? s.width : 64;
+  int precision = (s.precision < 0) ? 6 : (s.precision < 40) ? s.precision : 40;
+  int len = std::snprintf(text, sizeof(text), format, width, precision, value);
+  out.put(text, (len < static_cast<int>(sizeof(text))) ? len : static_cast<int>(sizeof(text)) - 1);
+}
+
+// ulog_render_t for messages captured by ulog::log()
+inline int render(char *buf, int size, void *ctx) {
+  const message &msg = *static_cast<const message *>(ctx);
+  writer out{buf, size, 0};
+  std::size_t next = 0;
+
+  for (const char *p = msg.fmt; *p; p++) {
+    if (*p != '%') {
+      out.put(*p);
+      continue;
+    }
+    if (*++p == '%') {
+      out.put('%');
+      continue;
+    }
+    spec s{};
+    s.precision = -1;
+    for (;; p++) {
+      if (*p == '-') s.left = true;
+      else if (*p == '+') s.plus = true;
+      else if (*p == ' ') s.space = true;
+      else if (*p == '#') s.alt = true;
+      else if (*p == '0') s.zero = true;
+      else break;
+    }
+    if (*p == '*') {
+      s.width = static_cast<int>(int_value(msg.args[next++]));
+      if (s.width < 0) {
+        s.left = true;
+        s.width = -s.width;
+      }
+      p++;
+    }
+    while (is_digit(*p)) {
+      s.width = s.width * 10 + (*p++ - '0');
+    }
+    if (*p == '.') {
+      s.precision = 0;
+      if (*++p == '*') {
+        s.precision = static_cast<int>(int_value(msg.args[next++]));
+        p++;
+      }
+      while (is_digit(*p)) {
+        s.precision = s.precision * 10 + (*p++ - '0');
+      }
+    }
+    while (*p == 'h' || *p == 'l' || *p == 'L' || *p == 'j' || *p == 'z' || *p == 't') {
+      p++;
+    }
+    s.conversion = *p;
+    const arg &a = msg.args[next++];
+
+    switch (s.conversion) {
+    case 'c': {
+      char c = static_cast<char>(int_value(a));
+      s.zero = false;
+      write_padded(out, s, "", 0, &c, 1, 0);
+      break;
+    }
+    case 's':
+      write_string(out, s, a.s.ptr, a.s.len);
+      break;
+    case 'p': {
+      arg address{};
+      address.kind = arg_kind::unsigned_int;
+      address.size = sizeof(void *);
+      address.u = reinterpret_cast<std::uintptr_t>((a.kind == arg_kind::string) ? a.s.ptr : a.p);
+      s.conversion = 'x';
+      s.alt = true;
+      write_integer(out, s, address);
+      break;
+    }
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+      write_floating(out, s, a.d);
+      break;
+    default:
+      write_integer(out, s, a);
+      break;
+    }
+  }
+  return out.finish();
+}
+
+// the value of an argument, calling it if it is lazy
+template <typename T>
+decltype(auto) evaluate(const T &value) {
+  if constexpr (is_lazy_v<T>) {
+    return value();
+  } else {
+    return (value);
+  }
+}
+
+template <typename... Values>
+int render_values(char *buf, int size, const char *fmt, const Values &... values) {
+  const arg captured[sizeof...(Values) + 1] = { make_arg(values)..., arg{} };
+  message msg{fmt, captured, sizeof...(Values)};
+  return render(buf, size, &msg);
+}
+
+// the arguments of one ulog::log() call, captured by reference
+template <typename... Args>
+struct deferred {
+  const char *fmt;
+  std::tuple<const Args &...> args;
+};
+
+// ulog_render_t for ulog::log().  uLog only calls it once the message passed
+// its level, call site and rate limit checks, so that is when lazy arguments
+// are evaluated.
+template <typename... Args>
+int render_deferred(char *buf, int size, void *ctx) {
+  const deferred<Args...> &d = *static_cast<const deferred<Args...> *>(ctx);
+  return std::apply([&](const Args &... args) {
+    return render_values(buf, size, d.fmt, evaluate(args)...);
+  }, d.args);
+}
+
+}  // namespace detail
+
+/**
+ * @brief: log a message whose format was checked by the ULOG_xxx() macros.
+ */
+template <typename... Args>
+void log(ulog_site_t *site, ulog_level_t level, const char *file, int line,
+         const char *fmt, const Args &... args) {
+  detail::deferred<Args...> deferred{fmt, {args...}};
+  ulog_render_message(site, level, file, line, fmt, detail::render_deferred<Args...>, &deferred);
+}
+
+// =============================================================================
+// static subscribers
+
+/**
+ * @brief: one subscriber fixed at build time.
+ */
+template <ulog_function_t Fn, ulog_level_t Threshold>
+struct subscriber {
+  static constexpr ulog_function_t fn = Fn;
+  static constexpr ulog_level_t threshold = Threshold;
+};
+
+/**
+ * @brief: a list of subscribers fixed at build time.
+ */
+template <typename... Subscribers>
+struct static_subscribers {
+  static constexpr bool wants(ulog_level_t level) {
+    return (false || ... || (level >= Subscribers::threshold));
+  }
+};
+
+#if (ULOG_STATIC_SUBSCRIBERS == 1)
+// the list given by ULOG_SUBSCRIBERS.  The last entry takes no messages and
+// only absorbs the trailing comma.
+#define ULOG_CXX_SUBSCRIBER_(fn, threshold) ::ulog::subscriber<fn, threshold>,
+using subscribers = static_subscribers<
+  ULOG_SUBSCRIBERS(ULOG_CXX_SUBSCRIBER_) subscriber<nullptr, ULOG_LEVEL_N>>;
+#undef ULOG_CXX_SUBSCRIBER_
+#endif
+
+}  // namespace ulog
+
+// =============================================================================
+// the ULOG_xxx() macros, checked
+
+// first macro argument, i.e. the format string
+#define ULOG_FORMAT_(...) ULOG_FORMAT_IMPL_(__VA_ARGS__, 0)
+#define ULOG_FORMAT_IMPL_(fmt, ...) fmt
+
+// The arguments are typed inside a lambda that is never called: C++17 does
+// not allow them in decltype() directly when one of them is itself a lambda.
+#define ULOG_CHECK_FORMAT_(...)                                               \
+  (void)[&]() {                                                               \
+    auto ulog_args_ = std::forward_as_tuple(__VA_ARGS__);                     \
+    ::ulog::detail::assert_format<                                            \
+      ::ulog::detail::format_checker<decltype(ulog_args_)>::check(            \
+        ULOG_FORMAT_(__VA_ARGS__))>();                                        \
+  }
+
+// compilers without __FILE_NAME__ get the file name from a constexpr scan.
+// The offset goes through a template argument so that it is folded even
+// without optimization.
+#if (ULOG_FILE_NAME == 1) && !defined(__FILE_NAME__)
+  #undef ULOG_FILE
+  #define ULOG_FILE                                                           \
+    (__FILE__ + std::integral_constant<std::size_t,                           \
+                                       ::ulog::file_name_offset(__FILE__)>::value)
+#endif
+
+#if (ULOG_SITES == 1)
+  #define ULOG_CXX_SITE_(level)                                               \
+    static ULOG_SITE_ALIGN ulog_site_t ulog_site_ =                           \
+      ::ulog::make_site(ULOG_FILE, __LINE__, level);                          \
+    ulog_site_t *ulog_site_ptr_ = &ulog_site_
+#else
+  #define ULOG_CXX_SITE_(level) ulog_site_t *ulog_site_ptr_ = nullptr
+#endif
+
+// statements no static subscriber wants are discarded at compile time, but
+// their formats are still checked.  The others capture their arguments by
+// reference into a cold lambda, so that the caller only keeps the level test.
+#if (ULOG_STATIC_SUBSCRIBERS == 1)
+  #define ULOG_CXX_WANTED_(level) ::ulog::subscribers::wants(level)
+#else
+  #define ULOG_CXX_WANTED_(level) true
+#endif
+
+#if (ULOG_ENABLED == 1)
+  #undef ULOG_AT_
+  #define ULOG_AT_(level, ...) do {                                             \
+    ULOG_CHECK_FORMAT_(__VA_ARGS__);                                          \
+    if constexpr (ULOG_CXX_WANTED_(level)) {                                  \
+      if (ULOG_UNLIKELY_(level, ulog_wants(level))) {                         \
+        [&]() ULOG_COLD {                                                     \
+          ULOG_CXX_SITE_(level);                                              \
+          ::ulog::log(ulog_site_ptr_, level, ULOG_FILE, __LINE__, __VA_ARGS__); \
+        }();                                                                  \
+      }                                                                       \
+    }                                                                         \
+  } while (0)
+#endif
+
+#endif /* ULOG_HPP_ */
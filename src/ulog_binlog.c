@@ -0,0 +1,265 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_binlog.c
+ *
+ * \brief a uLog subscriber that appends binary records to a file
+ *
+ * See ulog_binlog.h for the file format.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE               // syscall(SYS_gettid)
+#endif
+
+#include "ulog_binlog.h"
+#include "ulog_config.h"
+
+#if (ULOG_ENABLED == 1) && (ULOG_BINARY_LOG == 1)  // whole file...
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+// =============================================================================
+// local types and definitions
+
+// the longest record: type, time, site, thread, level, length, text
+#define RECORD_MAX (1 + 8 + 4 + 4 + 1 + 2 + ULOG_MAX_MESSAGE_LENGTH)
+#define SYNC_SIZE (sizeof(ULOG_BINLOG_SYNC) - 1)
+
+typedef struct {
+  const char *file;         // NULL: free
+  int line;
+  uint32_t id;
+} site_t;
+
+// =============================================================================
+// local storage
+
+static struct {
+  FILE *file;
+  uint64_t offset;          // bytes written
+  uint64_t chunk;           // offset of the current chunk
+  site_t sites[ULOG_BINLOG_SITES];   // open addressing on file and line
+  uint32_t site_count;
+  uint8_t in_chunk[(ULOG_BINLOG_SITES + 7) / 8];  // by id: site record written
+} ulog_binlog;
+
+static __thread uint32_t thread_id;
+
+// =============================================================================
+// local functions
+
+static int put(uint8_t *p, uint64_t value, int bytes) {
+  for (int i=0; i<bytes; i++) {
+    p[i] = (uint8_t)(value >> (8 * i));
+  }
+  return bytes;
+}
+
+static uint64_t get(const uint8_t *p, int bytes) {
+  uint64_t value = 0;
+  for (int i=0; i<bytes; i++) {
+    value |= (uint64_t)p[i] << (8 * i);
+  }
+  return value;
+}
+
+static uint32_t this_thread() {
+  if (thread_id == 0) {
+#if defined(__linux__)
+    thread_id = (uint32_t)syscall(SYS_gettid);
+#else
+    thread_id = (uint32_t)(uintptr_t)pthread_self();
+#endif
+  }
+  return thread_id;
+}
+
+static void write_bytes(const void *data, size_t len) {
+  fwrite(data, 1, len, ulog_binlog.file);
+  ulog_binlog.offset += len;
+}
+
+static void start_chunk() {
+  uint8_t record[1 + SYNC_SIZE + 8];
+  int n = put(record, ULOG_BINLOG_CHUNK, 1);
+  memcpy(&record[n], ULOG_BINLOG_SYNC, SYNC_SIZE);
+  n += SYNC_SIZE;
+  n += put(&record[n], ulog_binlog.offset, 8);
+  ulog_binlog.chunk = ulog_binlog.offset;
+  memset(ulog_binlog.in_chunk, 0, sizeof(ulog_binlog.in_chunk));
+  write_bytes(record, n);
+}
+
+// the call site at file and line, entered in the table the first time it is
+// seen.  NULL once the table is full.
+static site_t *find_site(const char *file, int line) {
+  uint32_t hash = (uint32_t)((uintptr_t)file >> 3) ^ ((uint32_t)line * 2654435761u);
+  for (int probe=0; probe<ULOG_BINLOG_SITES; probe++) {
+    site_t *site = &ulog_binlog.sites[(hash + probe) % ULOG_BINLOG_SITES];
+    if (site->file == file && site->line == line) {
+      return site;
+    }
+    if (site->file == NULL) {
+      site->file = file;
+      site->line = line;
+      site->id = ++ulog_binlog.site_count;
+      return site;
+    }
+  }
+  return NULL;
+}
+
+// the id of the call site at file and line, its site record written first
+// if the current chunk has none.  0 once the table is full.
+static uint32_t site_id(const char *file, int line) {
+  site_t *site = find_site(file, line);
+  if (site == NULL) {
+    return 0;
+  }
+  uint32_t bit = site->id - 1;
+  if ((ulog_binlog.in_chunk[bit / 8] & (1 << (bit % 8))) == 0) {
+    uint8_t header[1 + 4 + 4 + 2];
+    size_t length = strlen(file);
+    length = (length > UINT16_MAX) ? UINT16_MAX : length;
+    int n = put(header, ULOG_BINLOG_SITE, 1);
+    n += put(&header[n], site->id, 4);
+    n += put(&header[n], (uint32_t)line, 4);
+    n += put(&header[n], length, 2);
+    write_bytes(header, n);
+    write_bytes(file, length);
+    ulog_binlog.in_chunk[bit / 8] |= 1 << (bit % 8);
+  }
+  return site->id;
+}
+
+static bool read_bytes(FILE *file, void *data, size_t len) {
+  return fread(data, 1, len, file) == len;
+}
+
+// =============================================================================
+// user-visible code
+
+ulog_err_t ulog_binlog_open(const char *path) {
+  memset(&ulog_binlog, 0, sizeof(ulog_binlog));
+  ulog_binlog.file = fopen(path, "wb");
+  if (ulog_binlog.file == NULL) {
+    return ULOG_ERR_SYSTEM;
+  }
+  write_bytes(ULOG_BINLOG_MAGIC, strlen(ULOG_BINLOG_MAGIC));
+  start_chunk();
+  return ULOG_ERR_NONE;
+}
+
+void ulog_binlog_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  uint8_t record[RECORD_MAX];
+  struct timespec now;
+
+  if (ulog_binlog.file == NULL) {
+    return;
+  }
+  clock_gettime(CLOCK_REALTIME, &now);
+  if (ulog_binlog.offset - ulog_binlog.chunk >= ULOG_BINLOG_CHUNK_SIZE) {
+    start_chunk();
+  }
+  uint32_t site = site_id(file, line);
+  size_t length = strlen(msg);
+  length = (length > ULOG_MAX_MESSAGE_LENGTH) ? ULOG_MAX_MESSAGE_LENGTH : length;
+  int n = put(record, ULOG_BINLOG_MESSAGE, 1);
+  n += put(&record[n], (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000, 8);
+  n += put(&record[n], site, 4);
+  n += put(&record[n], this_thread(), 4);
+  n += put(&record[n], severity, 1);
+  n += put(&record[n], length, 2);
+  memcpy(&record[n], msg, length);
+  write_bytes(record, n + length);
+#if (ULOG_BINLOG_FLUSH == 1)
+  fflush(ulog_binlog.file);
+#endif
+}
+
+void ulog_binlog_close() {
+  if (ulog_binlog.file != NULL) {
+    fclose(ulog_binlog.file);
+    ulog_binlog.file = NULL;
+  }
+}
+
+bool ulog_binlog_check(FILE *file) {
+  char magic[sizeof(ULOG_BINLOG_MAGIC) - 1];
+  return read_bytes(file, magic, sizeof(magic)) &&
+         memcmp(magic, ULOG_BINLOG_MAGIC, sizeof(magic)) == 0;
+}
+
+int ulog_binlog_read(FILE *file, ulog_binlog_record_t *record) {
+  uint8_t fields[8 + 4 + 4 + 1 + 2];
+  int type = fgetc(file);
+
+  if (type == EOF) {
+    return 0;
+  }
+  record->type = (ulog_binlog_type_t)type;
+  if (type == ULOG_BINLOG_SITE) {
+    if (!read_bytes(file, fields, 4 + 4 + 2)) {
+      return -1;
+    }
+    record->site = (uint32_t)get(fields, 4);
+    record->line = (uint32_t)get(&fields[4], 4);
+    record->length = (int)get(&fields[8], 2);
+  } else if (type == ULOG_BINLOG_MESSAGE) {
+    if (!read_bytes(file, fields, sizeof(fields))) {
+      return -1;
+    }
+    record->time_us = get(fields, 8);
+    record->site = (uint32_t)get(&fields[8], 4);
+    record->thread = (uint32_t)get(&fields[12], 4);
+    record->level = (ulog_level_t)fields[16];
+    record->length = (int)get(&fields[17], 2);
+    if (record->level >= ULOG_LEVEL_N) {
+      return -1;
+    }
+  } else if (type == ULOG_BINLOG_CHUNK) {
+    if (!read_bytes(file, fields, SYNC_SIZE + 8) ||
+        memcmp(fields, ULOG_BINLOG_SYNC, SYNC_SIZE) != 0) {
+      return -1;
+    }
+    record->offset = get(&fields[SYNC_SIZE], 8);
+    record->length = 0;
+  } else {
+    return -1;
+  }
+  if (!read_bytes(file, record->text, record->length)) {
+    return -1;
+  }
+  record->text[record->length] = '\0';
+  return 1;
+}
+
+#endif  // #if (ULOG_ENABLED == 1) && (ULOG_BINARY_LOG == 1)
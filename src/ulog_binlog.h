@@ -0,0 +1,115 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_binlog.h
+ *
+ * \brief a uLog subscriber that appends binary records to a file (POSIX only)
+ *
+ * ulog_binlog_logger() writes each message with its time, level, thread and
+ * call site, for tools/ulog-columnar.c to turn into a columnar archive and
+ * tools/ulog-decode.c to print.  The file is the 8 bytes ULOG_BINLOG_MAGIC
+ * followed by records, all integers little-endian:
+ *
+ *     chunk:    u8 ULOG_BINLOG_CHUNK, the 8 bytes ULOG_BINLOG_SYNC, u64
+ *               offset of this record in the file
+ *     site:     u8 ULOG_BINLOG_SITE, u32 id, u32 line, u16 length, file name
+ *     message:  u8 ULOG_BINLOG_MESSAGE, u64 time (microseconds since the
+ *               epoch), u32 site id, u32 thread id, u8 level, u16 length,
+ *               text
+ *
+ * The records are grouped in chunks of about ULOG_BINLOG_CHUNK_SIZE bytes,
+ * each starting with a chunk record.  Within a chunk, a site record comes
+ * before the first message of its call site, so every chunk decodes on its
+ * own, and a reader can find the next chunk from any point of the file by
+ * looking for the sync bytes followed by their own offset.  Site ids count
+ * from 1, in the order the sites first appear in the file; 0 stands for a
+ * call site that did not fit in the table of ULOG_BINLOG_SITES.  When several
+ * threads log, install a lock with ulog_set_lock(): the logger keeps its
+ * table without one of its own.
+ */
+
+#ifndef ULOG_BINLOG_H_
+#define ULOG_BINLOG_H_
+
+#include "ulog.h"
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+#define ULOG_BINLOG_MAGIC "ULOGBIN2"
+#define ULOG_BINLOG_SYNC "\0ULOGCHK"   // no message text holds a NUL
+
+typedef enum {
+  ULOG_BINLOG_SITE = 1,
+  ULOG_BINLOG_MESSAGE,
+  ULOG_BINLOG_CHUNK,
+} ulog_binlog_type_t;
+
+// a record as ulog_binlog_read() returns it
+typedef struct {
+  ulog_binlog_type_t type;
+  uint64_t time_us;         // message
+  uint32_t site;            // both
+  uint32_t thread;          // message
+  ulog_level_t level;       // message
+  uint32_t line;            // site
+  uint64_t offset;          // chunk
+  int length;               // of text
+  char text[UINT16_MAX + 1];  // message, or file name of a site, NUL ended
+} ulog_binlog_record_t;
+
+/**
+ * @brief: create path, or truncate it, and write the messages of
+ * ulog_binlog_logger() there.
+ */
+ulog_err_t ulog_binlog_open(const char *path);
+
+/**
+ * @brief: the subscriber, for ULOG_SUBSCRIBE().
+ */
+void ulog_binlog_logger(ulog_level_t severity, const char *file, int line, char *msg);
+
+/**
+ * @brief: flush and close the file.  Unsubscribe the logger first.
+ */
+void ulog_binlog_close();
+
+/**
+ * @brief: check the magic at the start of a binary log opened for reading.
+ */
+bool ulog_binlog_check(FILE *file);
+
+/**
+ * @brief: read the next record of a binary log.  Returns 1, 0 at the end, or
+ * -1 if the file is cut short or damaged.
+ */
+int ulog_binlog_read(FILE *file, ulog_binlog_record_t *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_BINLOG_H_ */
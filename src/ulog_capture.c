@@ -0,0 +1,781 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_capture.c
+ *
+ * \brief binary capture of printf arguments, for formatting them later
+ *
+ * See ulog_capture.h.  A record is the arguments in the order the format
+ * consumes them, each in the size of its C type, with no padding.  A %s
+ * argument is a tag byte followed by either the pointer (STRING_STATIC) or a
+ * length byte and the characters (STRING_COPY).
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE               // dl_iterate_phdr()
+#endif
+
+#include "ulog_capture.h"
+#include "ulog_config.h"
+#include "ulog_dtoa.h"
+
+#if (ULOG_ENABLED == 1) && (ULOG_DEFERRED == 1)  // whole file...
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(__linux__)
+#include <link.h>
+#endif
+
+// =============================================================================
+// local types and definitions
+
+enum { STRING_STATIC, STRING_COPY };
+
+typedef enum {
+  LENGTH_NONE, LENGTH_HH, LENGTH_H, LENGTH_L, LENGTH_LL,
+  LENGTH_J, LENGTH_Z, LENGTH_T, LENGTH_LONG_DOUBLE
+} length_t;
+
+// one printf conversion, as found by parse()
+typedef struct {
+  const char *start;        // the '%'
+  const char *flags;        // first flag character
+  int flag_count;
+  bool width_star;
+  int width;                // -1: none
+  bool precision_star;
+  int precision;            // -1: none
+  length_t length;
+  char conversion;          // 0 at the end of the format
+} conversion_t;
+
+#if (ULOG_FORMAT_CACHE > 0)
+// a literal and the conversion after it, ready to render
+typedef struct {
+  const char *literal;      // text before the conversion
+  uint16_t literal_len;
+  bool escaped;             // literal holds %% to collapse
+  bool fast;                // no flags, width or precision: converted here
+  length_t length;
+  char conversion;          // 0 for the text after the last conversion
+  char spec[14];            // the conversion for snprintf() if not fast
+} step_t;
+
+// a format parsed once, for every record of its call site.  A format with *
+// or more than ULOG_FORMAT_STEPS conversions keeps step_count 0 and is
+// rendered by render_parsed().
+typedef struct {
+  const char *fmt;
+  int step_count;
+  step_t steps[ULOG_FORMAT_STEPS + 1];
+} compiled_t;
+#endif
+
+// =============================================================================
+// local storage
+
+static struct {
+  const void *start[ULOG_STATIC_RANGES];
+  const void *end[ULOG_STATIC_RANGES];
+  int count;
+} static_ranges;
+
+#if (ULOG_FORMAT_CACHE > 0)
+// direct mapped on the address of the format, which is fixed per call site
+static compiled_t compiled[ULOG_FORMAT_CACHE];
+#endif
+
+// =============================================================================
+// local functions
+
+static int digits(const char **p) {
+  int value = 0;
+  while (**p >= '0' && **p <= '9') {
+    value = value * 10 + (*(*p)++ - '0');
+  }
+  return value;
+}
+
+// find the next conversion in fmt.  c->start is where it begins, so the text
+// before is literal, with %% still doubled.  Returns the position after it.
+static const char *parse(const char *fmt, conversion_t *c) {
+  const char *p = fmt;
+  memset(c, 0, sizeof(*c));
+  c->width = -1;
+  c->precision = -1;
+  for (; *p; p++) {
+    if (p[0] == '%' && p[1] == '%') {
+      p++;
+    } else if (p[0] == '%') {
+      break;
+    }
+  }
+  c->start = p;
+  if (*p == '\0') {
+    return p;
+  }
+  c->flags = ++p;
+  while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') {
+    p++;
+  }
+  c->flag_count = (int)(p - c->flags);
+  if (*p == '*') {
+    c->width_star = true;
+    p++;
+  } else if (*p >= '0' && *p <= '9') {
+    c->width = digits(&p);
+  }
+  if (*p == '.') {
+    p++;
+    if (*p == '*') {
+      c->precision_star = true;
+      p++;
+    } else {
+      c->precision = digits(&p);
+    }
+  }
+  switch (*p) {
+  case 'h': c->length = (p[1] == 'h') ? LENGTH_HH : LENGTH_H; break;
+  case 'l': c->length = (p[1] == 'l') ? LENGTH_LL : LENGTH_L; break;
+  case 'j': c->length = LENGTH_J; break;
+  case 'z': c->length = LENGTH_Z; break;
+  case 't': c->length = LENGTH_T; break;
+  case 'L': c->length = LENGTH_LONG_DOUBLE; break;
+  default: break;
+  }
+  p += (c->length == LENGTH_HH || c->length == LENGTH_LL) ? 2 : (c->length != LENGTH_NONE);
+  c->conversion = *p;
+  return (*p) ? p + 1 : p;
+}
+
+// append value to the record, or give up if it does not fit
+#define PUT(value) do {                                                       \
+    if (pos + (int)sizeof(value) > size) {                                    \
+      return -1;                                                              \
+    }                                                                         \
+    memcpy(&record[pos], &(value), sizeof(value));                            \
+    pos += sizeof(value);                                                     \
+  } while (0)
+
+#define GET(type, var)                                                        \
+  type var;                                                                   \
+  if (pos + (int)sizeof(type) > len) {                                        \
+    return out;                                                               \
+  }                                                                           \
+  memcpy(&var, &record[pos], sizeof(type));                                   \
+  pos += sizeof(type)
+
+static int capture_integer(uint8_t *record, int pos, int size,
+                           const conversion_t *c, va_list *ap) {
+  bool is_signed = (c->conversion == 'd' || c->conversion == 'i');
+  switch (c->length) {
+  case LENGTH_L:
+    if (is_signed) { long v = va_arg(*ap, long); PUT(v); }
+    else { unsigned long v = va_arg(*ap, unsigned long); PUT(v); }
+    break;
+  case LENGTH_LL:
+    if (is_signed) { long long v = va_arg(*ap, long long); PUT(v); }
+    else { unsigned long long v = va_arg(*ap, unsigned long long); PUT(v); }
+    break;
+  case LENGTH_J:
+    if (is_signed) { intmax_t v = va_arg(*ap, intmax_t); PUT(v); }
+    else { uintmax_t v = va_arg(*ap, uintmax_t); PUT(v); }
+    break;
+  case LENGTH_Z: { size_t v = va_arg(*ap, size_t); PUT(v); } break;
+  case LENGTH_T: { ptrdiff_t v = va_arg(*ap, ptrdiff_t); PUT(v); } break;
+  default: { int v = va_arg(*ap, int); PUT(v); } break;
+  }
+  return pos;
+}
+
+// true if copying s takes less room than a pointer to it
+static bool shorter_than_pointer(const char *s) {
+  for (size_t i=0; i<sizeof(s); i++) {
+    if (s[i] == '\0') {
+      return true;
+    }
+  }
+  return false;
+}
+
+static int capture_string(uint8_t *record, int pos, int size,
+                          int precision, const char *s) {
+  if (s != NULL && ulog_is_static(s) && !shorter_than_pointer(s)) {
+    uint8_t tag = STRING_STATIC;
+    PUT(tag);
+    PUT(s);
+    return pos;
+  }
+  if (s == NULL) {
+    s = "(null)";
+  }
+  int max = ULOG_CAPTURE_STRING_MAX;
+  if (precision >= 0 && precision < max) {
+    max = precision;
+  }
+  uint8_t n = 0;
+  while (n < max && s[n] != '\0') {
+    n++;
+  }
+  uint8_t tag = STRING_COPY;
+  PUT(tag);
+  PUT(n);
+  if (pos + n > size) {
+    return -1;
+  }
+  memcpy(&record[pos], s, n);
+  return pos + n;
+}
+
+// rebuild the conversion c as a format of its own, with the * arguments
+// filled in.  A negative * width reads back as the '-' flag and its size.
+static void conversion_format(char *spec, int size, const conversion_t *c,
+                              int width, int precision) {
+  int n = snprintf(spec, size, "%%%.*s", c->flag_count, c->flags);
+  if (width >= 0 || c->width_star) {
+    n += snprintf(&spec[n], size - n, "%d", width);
+  }
+  if (precision >= 0) {
+    n += snprintf(&spec[n], size - n, ".%d", precision);
+  }
+  static const char *lengths[] = { "", "hh", "h", "l", "ll", "j", "z", "t", "L" };
+  snprintf(&spec[n], size - n, "%s%c", lengths[c->length], c->conversion);
+}
+
+// capture the arguments of conversion c.  Returns the new position in the
+// record, -1 if they do not fit.
+static int capture(uint8_t *record, int pos, int size, const conversion_t *c, va_list *ap) {
+  int precision = c->precision;
+  if (c->width_star) {
+    int width = va_arg(*ap, int);
+    PUT(width);
+  }
+  if (c->precision_star) {
+    precision = va_arg(*ap, int);
+    PUT(precision);
+  }
+  switch (c->conversion) {
+  case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+    return capture_integer(record, pos, size, c, ap);
+  case 'c': {
+    int v = va_arg(*ap, int);
+    PUT(v);
+    break;
+  }
+  case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+    if (c->length == LENGTH_LONG_DOUBLE) {
+      long double v = va_arg(*ap, long double);
+      PUT(v);
+    } else {
+      double v = va_arg(*ap, double);
+      PUT(v);
+    }
+    break;
+  case 's':
+    if (c->length == LENGTH_L) {
+      (void)va_arg(*ap, void *);        // wide strings are not captured
+      break;
+    }
+    return capture_string(record, pos, size, precision, va_arg(*ap, const char *));
+  case 'p': {
+    void *v = va_arg(*ap, void *);
+    PUT(v);
+    break;
+  }
+  case 'n':
+    (void)va_arg(*ap, void *);          // never written to
+    break;
+  default:
+    break;
+  }
+  return pos;
+}
+
+// bytes the argument of c takes in a record, if it is not a string
+static int argument_size(const conversion_t *c) {
+  switch (c->conversion) {
+  case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+    switch (c->length) {
+    case LENGTH_L: return sizeof(long);
+    case LENGTH_LL: return sizeof(long long);
+    case LENGTH_J: return sizeof(intmax_t);
+    case LENGTH_Z: return sizeof(size_t);
+    case LENGTH_T: return sizeof(ptrdiff_t);
+    default: return sizeof(int);
+    }
+  case 'c':
+    return sizeof(int);
+  case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+    return (c->length == LENGTH_LONG_DOUBLE) ? sizeof(long double) : sizeof(double);
+  case 'p':
+    return sizeof(void *);
+  default:
+    return 0;
+  }
+}
+
+// format a record by parsing fmt as it goes
+static int render_parsed(char *buf, int size, const char *fmt, const uint8_t *record, int len) {
+  char spec[32];
+  conversion_t c;
+  int out = 0;
+  int pos = 0;
+
+  for (;;) {
+    const char *literal = fmt;
+    fmt = parse(fmt, &c);
+    // copy the literal text before the conversion, collapsing %%
+    for (const char *p = literal; p < c.start; p++) {
+      if (out < size - 1) {
+        buf[out] = *p;
+      }
+      out++;
+      p += (p[0] == '%');
+    }
+    if (size > 0) {
+      buf[(out < size) ? out : size - 1] = '\0';
+    }
+    if (c.conversion == 0) {
+      return out;
+    }
+
+    int width = c.width;
+    int precision = c.precision;
+    if (c.width_star) {
+      GET(int, w);
+      width = w;
+    }
+    if (c.precision_star) {
+      GET(int, p);
+      precision = p;
+    }
+    conversion_format(spec, sizeof(spec), &c, width, precision);
+    char *dst = &buf[(out < size) ? out : size];
+    int room = (out < size) ? size - out : 0;
+
+    switch (c.conversion) {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+      switch (c.length) {
+      case LENGTH_L: { GET(long, v); out += snprintf(dst, room, spec, v); } break;
+      case LENGTH_LL: { GET(long long, v); out += snprintf(dst, room, spec, v); } break;
+      case LENGTH_J: { GET(intmax_t, v); out += snprintf(dst, room, spec, v); } break;
+      case LENGTH_Z: { GET(size_t, v); out += snprintf(dst, room, spec, v); } break;
+      case LENGTH_T: { GET(ptrdiff_t, v); out += snprintf(dst, room, spec, v); } break;
+      default: { GET(int, v); out += snprintf(dst, room, spec, v); } break;
+      }
+      break;
+    case 'c': {
+      GET(int, v);
+      out += snprintf(dst, room, spec, v);
+      break;
+    }
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+      if (c.length == LENGTH_LONG_DOUBLE) {
+        GET(long double, v);
+        out += snprintf(dst, room, spec, v);
+      } else {
+        GET(double, v);
+        out += snprintf(dst, room, spec, v);
+      }
+      break;
+    case 's': {
+      if (c.length == LENGTH_L) {
+        break;
+      }
+      char copy[ULOG_CAPTURE_STRING_MAX + 1];
+      const char *s = copy;
+      GET(uint8_t, tag);
+      if (tag == STRING_STATIC) {
+        GET(const char *, p);
+        s = p;
+      } else {
+        GET(uint8_t, n);
+        if (pos + n > len) {
+          return out;
+        }
+        memcpy(copy, &record[pos], n);
+        copy[n] = '\0';
+        pos += n;
+      }
+      out += snprintf(dst, room, spec, s);
+      break;
+    }
+    case 'p': {
+      GET(void *, v);
+      out += snprintf(dst, room, spec, v);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+}
+
+#if (ULOG_FORMAT_CACHE > 0)
+
+// "00" "01" ... "99", to convert two decimal digits per division
+static const char digit_pairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+// append n characters to buf as snprintf() would
+static void put(char *buf, int size, int *out, const char *s, int n) {
+  if (*out < size - 1) {
+    int room = size - 1 - *out;
+    memcpy(&buf[*out], s, (n < room) ? n : room);
+  }
+  *out += n;
+}
+
+// write value in base 10 or 16 so that it ends just before end
+static char *convert(char *end, unsigned long long value, char conversion) {
+  if (conversion == 'x' || conversion == 'X') {
+    const char *hex = (conversion == 'x') ? "0123456789abcdef" : "0123456789ABCDEF";
+    do {
+      *--end = hex[value & 15];
+      value >>= 4;
+    } while (value != 0);
+    return end;
+  }
+  while (value >= 100) {
+    end -= 2;
+    memcpy(end, &digit_pairs[(value % 100) * 2], 2);
+    value /= 100;
+  }
+  if (value >= 10) {
+    end -= 2;
+    memcpy(end, &digit_pairs[value * 2], 2);
+  } else {
+    *--end = (char)('0' + value);
+  }
+  return end;
+}
+
+// parse fmt into c, or leave c->step_count 0 if it cannot be compiled
+static void compile(compiled_t *c, const char *fmt) {
+  conversion_t conversion;
+
+  c->fmt = fmt;
+  c->step_count = 0;
+  for (int i=0; i<=ULOG_FORMAT_STEPS; i++) {
+    step_t *step = &c->steps[i];
+    const char *literal = fmt;
+    fmt = parse(fmt, &conversion);
+    step->literal = literal;
+    step->literal_len = (uint16_t)(conversion.start - literal);
+    step->escaped = memchr(literal, '%', step->literal_len) != NULL;
+    step->length = conversion.length;
+    step->conversion = conversion.conversion;
+    if (conversion.conversion == 0) {
+      c->step_count = i + 1;
+      return;
+    }
+    if (i == ULOG_FORMAT_STEPS || conversion.width_star || conversion.precision_star ||
+        (conversion.length == LENGTH_L && conversion.conversion == 's')) {
+      return;
+    }
+    step->fast = conversion.flag_count == 0 && conversion.width < 0 &&
+                 conversion.precision < 0;
+    switch (conversion.conversion) {
+    case 'd': case 'i': case 'u': case 'x': case 'X':
+      step->fast = step->fast && (conversion.length == LENGTH_NONE ||
+                                  conversion.length == LENGTH_L ||
+                                  conversion.length == LENGTH_LL ||
+                                  conversion.length == LENGTH_Z);
+      break;
+    case 's': case 'c':
+      break;
+    case 'g':
+      step->fast = step->fast && ULOG_SHORTEST_G && conversion.length == LENGTH_NONE;
+      break;
+    default:
+      step->fast = false;
+      break;
+    }
+    conversion_format(step->spec, sizeof(step->spec), &conversion,
+                      conversion.width, conversion.precision);
+    if (strlen(step->spec) == sizeof(step->spec) - 1) {
+      return;                   // possibly cut: leave it to render_parsed()
+    }
+  }
+}
+
+#define TAKE(type, var)                                                       \
+  type var;                                                                   \
+  if (pos + (int)sizeof(type) > len) {                                        \
+    goto done;                                                                \
+  }                                                                           \
+  memcpy(&var, &record[pos], sizeof(type));                                   \
+  pos += sizeof(type)
+
+// format a record with the steps of c
+static int render_compiled(char *buf, int size, const compiled_t *c,
+                           const uint8_t *record, int len) {
+  char digits[ULOG_DTOA_SIZE];
+  int out = 0;
+  int pos = 0;
+
+  for (int i=0; i<c->step_count; i++) {
+    const step_t *step = &c->steps[i];
+    if (!step->escaped) {
+      put(buf, size, &out, step->literal, step->literal_len);
+    } else {
+      for (const char *p = step->literal; p < step->literal + step->literal_len; p++) {
+        put(buf, size, &out, p, 1);
+        p += (p[0] == '%');
+      }
+    }
+    char *dst = &buf[(out < size) ? out : size];
+    int room = (out < size) ? size - out : 0;
+
+    switch (step->conversion) {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': {
+      if (!step->fast) {
+        switch (step->length) {
+        case LENGTH_L: { TAKE(long, v); out += snprintf(dst, room, step->spec, v); } break;
+        case LENGTH_LL: { TAKE(long long, v); out += snprintf(dst, room, step->spec, v); } break;
+        case LENGTH_J: { TAKE(intmax_t, v); out += snprintf(dst, room, step->spec, v); } break;
+        case LENGTH_Z: { TAKE(size_t, v); out += snprintf(dst, room, step->spec, v); } break;
+        case LENGTH_T: { TAKE(ptrdiff_t, v); out += snprintf(dst, room, step->spec, v); } break;
+        default: { TAKE(int, v); out += snprintf(dst, room, step->spec, v); } break;
+        }
+        break;
+      }
+      bool is_signed = (step->conversion == 'd' || step->conversion == 'i');
+      bool negative = false;
+      unsigned long long value;
+      if (step->length == LENGTH_L) {
+        TAKE(long, v);
+        negative = is_signed && v < 0;
+        value = negative ? 0 - (unsigned long long)v : (unsigned long)v;
+      } else if (step->length == LENGTH_LL) {
+        TAKE(long long, v);
+        negative = is_signed && v < 0;
+        value = negative ? 0 - (unsigned long long)v : (unsigned long long)v;
+      } else if (step->length == LENGTH_Z) {
+        TAKE(size_t, v);        // %zd takes the signed type of the same size
+        negative = is_signed && (ptrdiff_t)v < 0;
+        value = negative ? 0 - (unsigned long long)(ptrdiff_t)v : v;
+      } else {
+        TAKE(int, v);
+        negative = is_signed && v < 0;
+        value = negative ? 0 - (unsigned long long)v : (unsigned int)v;
+      }
+      char *first = convert(&digits[sizeof(digits)], value, step->conversion);
+      if (negative) {
+        *--first = '-';
+      }
+      put(buf, size, &out, first, (int)(&digits[sizeof(digits)] - first));
+      break;
+    }
+    case 'c': {
+      TAKE(int, v);
+      if (step->fast) {
+        char ch = (char)v;
+        put(buf, size, &out, &ch, 1);
+      } else {
+        out += snprintf(dst, room, step->spec, v);
+      }
+      break;
+    }
+    case 's': {
+      char copy[ULOG_CAPTURE_STRING_MAX + 1];
+      const char *s;
+      int n;
+      TAKE(uint8_t, tag);
+      if (tag == STRING_STATIC) {
+        TAKE(const char *, p);
+        s = p;
+        n = step->fast ? (int)strlen(s) : 0;
+      } else {
+        TAKE(uint8_t, count);
+        if (pos + count > len) {
+          goto done;
+        }
+        s = (const char *)&record[pos];
+        n = count;
+        pos += count;
+        if (!step->fast) {
+          memcpy(copy, s, n);
+          copy[n] = '\0';
+          s = copy;
+        }
+      }
+      if (step->fast) {
+        put(buf, size, &out, s, n);
+      } else {
+        out += snprintf(dst, room, step->spec, s);
+      }
+      break;
+    }
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+      if (step->length == LENGTH_LONG_DOUBLE) {
+        TAKE(long double, v);
+        out += snprintf(dst, room, step->spec, v);
+#if (ULOG_SHORTEST_G == 1)
+      } else if (step->fast) {
+        TAKE(double, v);
+        put(buf, size, &out, digits, ulog_dtoa(v, digits));
+#endif
+      } else {
+        TAKE(double, v);
+        out += snprintf(dst, room, step->spec, v);
+      }
+      break;
+    case 'p': {
+      TAKE(void *, v);
+      out += snprintf(dst, room, step->spec, v);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+done:
+  if (size > 0) {
+    buf[(out < size) ? out : size - 1] = '\0';
+  }
+  return out;
+}
+
+#undef TAKE
+
+#endif
+
+// =============================================================================
+// user-visible code
+
+int ulog_capture_args(uint8_t *record, int size, const char *fmt, va_list ap) {
+  va_list args;
+  conversion_t c;
+  int pos = 0;
+
+  va_copy(args, ap);
+  for (fmt = parse(fmt, &c); c.conversion != 0 && pos >= 0; fmt = parse(fmt, &c)) {
+    pos = capture(record, pos, size, &c, &args);
+  }
+  va_end(args);
+  return pos;
+}
+
+int ulog_capture_render(char *buf, int size, const char *fmt, const uint8_t *record, int len) {
+#if (ULOG_FORMAT_CACHE > 0)
+  compiled_t *c = &compiled[((uintptr_t)fmt >> 2) % ULOG_FORMAT_CACHE];
+  if (c->fmt != fmt) {
+    compile(c, fmt);
+  }
+  if (c->step_count > 0) {
+    return render_compiled(buf, size, c, record, len);
+  }
+#endif
+  return render_parsed(buf, size, fmt, record, len);
+}
+
+int ulog_capture_relocate(uint8_t *record, int len, const char *fmt,
+                          ulog_capture_string_t string, void *arg) {
+  conversion_t c;
+  int pos = 0;
+  int replaced = 0;
+
+  for (fmt = parse(fmt, &c); c.conversion != 0; fmt = parse(fmt, &c)) {
+    pos += (c.width_star + c.precision_star) * (int)sizeof(int);
+    if (c.conversion != 's' || c.length == LENGTH_L) {
+      pos += argument_size(&c);
+    } else if (pos < len && record[pos] == STRING_STATIC) {
+      const char *p;
+      if (pos + 1 + (int)sizeof(p) > len) {
+        return -1;
+      }
+      memcpy(&p, &record[pos + 1], sizeof(p));
+      p = string(p, arg);
+      memcpy(&record[pos + 1], &p, sizeof(p));
+      pos += 1 + sizeof(p);
+      replaced++;
+    } else if (pos + 1 < len) {
+      pos += 2 + record[pos + 1];       // tag, length, characters
+    } else {
+      return -1;
+    }
+    if (pos > len) {
+      return -1;
+    }
+  }
+  return replaced;
+}
+
+ulog_err_t ulog_static_range(const void *start, const void *end) {
+  if (start == NULL) {
+    static_ranges.count = 0;
+    return ULOG_ERR_NONE;
+  }
+  if (static_ranges.count == ULOG_STATIC_RANGES) {
+    return ULOG_ERR_NO_ROOM;
+  }
+  static_ranges.start[static_ranges.count] = start;
+  static_ranges.end[static_ranges.count] = end;
+  static_ranges.count++;
+  return ULOG_ERR_NONE;
+}
+
+bool ulog_is_static(const void *p) {
+  for (int i=0; i<static_ranges.count; i++) {
+    if ((const char *)p >= (const char *)static_ranges.start[i] &&
+        (const char *)p < (const char *)static_ranges.end[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#if defined(__linux__)
+// add the read-only PT_LOAD segments of the main program, the first object
+// reported
+static int add_segments(struct dl_phdr_info *info, size_t size, void *data) {
+  int *added = (int *)data;
+  (void)size;
+  for (int i=0; i<info->dlpi_phnum; i++) {
+    const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+    if (phdr->p_type == PT_LOAD && !(phdr->p_flags & PF_W)) {
+      const char *start = (const char *)(info->dlpi_addr + phdr->p_vaddr);
+      if (ulog_static_range(start, start + phdr->p_memsz) == ULOG_ERR_NONE) {
+        (*added)++;
+      }
+    }
+  }
+  return 1;                     // stop after the main program
+}
+#endif
+
+int ulog_static_ranges_detect() {
+  int added = 0;
+#if defined(__linux__)
+  dl_iterate_phdr(add_segments, &added);
+#endif
+  return added;
+}
+
+#endif  // #if (ULOG_ENABLED == 1) && (ULOG_DEFERRED == 1)
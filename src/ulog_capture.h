@@ -0,0 +1,103 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_capture.h
+ *
+ * \brief binary capture of printf arguments, for formatting them later
+ *
+ * ulog_capture_args() walks a printf format and stores its arguments in a
+ * compact record; ulog_capture_render() formats the record, possibly much
+ * later and in another thread.  Numbers are stored in their own size.
+ *
+ * %s arguments are the expensive part.  A string inside a static range, such
+ * as a string literal in a read-only section, outlives any record and is
+ * stored as a bare pointer.  Any other string is copied, cut to
+ * ULOG_CAPTURE_STRING_MAX characters.  On Linux ulog_static_ranges_detect()
+ * finds the read-only segments of the program; elsewhere register flash or
+ * other constant memory with ulog_static_range().
+ */
+
+#ifndef ULOG_CAPTURE_H_
+#define ULOG_CAPTURE_H_
+
+#include "ulog.h"
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+/**
+ * @brief: capture the arguments that fmt consumes from ap into record.
+ *
+ * Returns the number of bytes used, or -1 if they do not fit in size bytes.
+ * ap is not consumed (it is copied), so the caller may still use it.
+ */
+int ulog_capture_args(uint8_t *record, int size, const char *fmt, va_list ap);
+
+/**
+ * @brief: format the len bytes captured for fmt into buf, like snprintf().
+ *
+ * Formats are parsed once and kept in a table of ULOG_FORMAT_CACHE entries
+ * indexed by the address of fmt, so call it from one thread at a time, as
+ * ulog_deferred_flush() does.
+ */
+int ulog_capture_render(char *buf, int size, const char *fmt, const uint8_t *record, int len);
+
+// gives where to read a string captured by reference at p
+typedef const char *(*ulog_capture_string_t)(const char *p, void *arg);
+
+/**
+ * @brief: replace every string pointer in the len bytes captured for fmt by
+ * what string(pointer, arg) returns, so that a record read out of another
+ * address space (see tools/ulog-core.c) renders.  Returns the number of
+ * pointers replaced, or -1 if the record is shorter than fmt says.
+ */
+int ulog_capture_relocate(uint8_t *record, int len, const char *fmt,
+                          ulog_capture_string_t string, void *arg);
+
+/**
+ * @brief: declare the memory from start to end as never changing or going
+ * away, so that strings in it are captured by reference.  A NULL start
+ * removes all ranges.  Returns ULOG_ERR_NO_ROOM once
+ * ULOG_STATIC_RANGES ranges are in use.
+ */
+ulog_err_t ulog_static_range(const void *start, const void *end);
+
+/**
+ * @brief: true if p lies in a static range.
+ */
+bool ulog_is_static(const void *p);
+
+/**
+ * @brief: register the read-only segments of the running program (Linux
+ * only, 0 elsewhere).  Returns the number of ranges added.
+ */
+int ulog_static_ranges_detect();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_CAPTURE_H_ */
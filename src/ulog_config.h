@@ -14,5 +14,240 @@
 // maximum length of formatted log message
 #define ULOG_MAX_MESSAGE_LENGTH 128
 
+// Set ULOG_SITES to 1 to give every ULOG_xxx() statement its own static
+// call site record, which counts how often the statement executed, how often
+// its message reached a subscriber and how many bytes it produced.  See
+// ulog_site_top() and ulog_site_dump() to find the noisiest statements.
+#ifndef ULOG_SITES
+  #define ULOG_SITES 0
+#endif
+// the most call sites ulog_site_dump() lists, kept on its stack
+#ifndef ULOG_SITE_DUMP_MAX
+  #define ULOG_SITE_DUMP_MAX 16
+#endif
+
+// Default limit, in messages per second, on how often one call site may log.
+// 0 means unlimited.  Needs ULOG_SITES and the clock set by ulog_set_clock();
+// ulog_site_set_rate_limit() changes it at run time.
+#ifndef ULOG_SITE_RATE_LIMIT
+  #define ULOG_SITE_RATE_LIMIT 0
+#endif
+
+// Set ULOG_FILE_NAME to 1 to have the ULOG_xxx() macros pass only the file
+// name (ulog.c rather than /home/me/project/src/ulog.c) to subscribers.  The
+// name is taken at compile time, from __FILE_NAME__ where the compiler has it
+// and with a constexpr scan in ulog.hpp otherwise.  Either way the full
+// __FILE__ may still end up in the binary; -ffile-prefix-map=$(SRCDIR)/= on
+// the command line strips the build path from it as well.
+#ifndef ULOG_FILE_NAME
+  #define ULOG_FILE_NAME 0
+#endif
+
+// Call site records are aligned to this size so that the counters of two
+// busy statements never share a cache line.
+#ifndef ULOG_CACHE_LINE_SIZE
+  #define ULOG_CACHE_LINE_SIZE 64
+#endif
+
+// Set ULOG_SUBSCRIBER_TIMING to 1 to time every subscriber call with the
+// clock installed by ulog_set_clock().  A subscriber that takes longer than
+// ULOG_SLOW_BUDGET_US on ULOG_SLOW_STRIKES of any ULOG_SLOW_WINDOW consecutive
+// calls is demoted: from then on its messages are copied into its own queue
+// of ULOG_ASYNC_QUEUE_DEPTH entries and delivered by ulog_drain().
+#ifndef ULOG_SUBSCRIBER_TIMING
+  #define ULOG_SUBSCRIBER_TIMING 0
+#endif
+#ifndef ULOG_SLOW_BUDGET_US
+  #define ULOG_SLOW_BUDGET_US 1000
+#endif
+#ifndef ULOG_SLOW_STRIKES
+  #define ULOG_SLOW_STRIKES 3
+#endif
+#ifndef ULOG_SLOW_WINDOW
+  #define ULOG_SLOW_WINDOW 100
+#endif
+#ifndef ULOG_ASYNC_QUEUE_DEPTH
+  #define ULOG_ASYNC_QUEUE_DEPTH 8
+#endif
+
+// Set ULOG_LOCK_STATS to 1 to record, with the clock installed by
+// ulog_set_clock(), how long callers wait for the lock installed by
+// ulog_set_lock() and how long they hold it.  Hold time of ulog_message() is
+// further split into formatting and dispatch.  See ulog_lock_stats().
+#ifndef ULOG_LOCK_STATS
+  #define ULOG_LOCK_STATS 0
+#endif
+// number of power-of-two microsecond buckets in each histogram
+#ifndef ULOG_HISTOGRAM_BUCKETS
+  #define ULOG_HISTOGRAM_BUCKETS 16
+#endif
+
+// Set ULOG_STATS to 1 to count messages per level and to enable ulog_stats(),
+// which gathers every counter uLog keeps into one ulog_stats_t.
+#ifndef ULOG_STATS
+  #define ULOG_STATS 0
+#endif
+
+// Set ULOG_SHM_STATS to 1 (POSIX hosts only, needs ULOG_STATS) to publish
+// ulog_stats() in a shared memory page created by ulog_shm_open(), where
+// tools/ulog-stat.c can read it.  The page is refreshed by ulog_message() at
+// most every ULOG_SHM_INTERVAL_US, or on every message if no clock is set.
+#ifndef ULOG_SHM_STATS
+  #define ULOG_SHM_STATS 0
+#endif
+#ifndef ULOG_SHM_INTERVAL_US
+  #define ULOG_SHM_INTERVAL_US 10000
+#endif
+
+// Set ULOG_CTL to 1 (POSIX hosts only) to let ulog_ctl_open() serve a Unix
+// socket through which tools/ulogctl.c lists and changes subscriber levels,
+// call sites and rate limits, and triggers flushes, at run time.
+#ifndef ULOG_CTL
+  #define ULOG_CTL 0
+#endif
+
+// Set ULOG_HOT_RELOAD to 1 (Linux only) to let ulog_reload_open() watch a
+// configuration file with inotify.  The file is parsed by a background
+// thread, and the result is handed to uLog with a single pointer store that
+// the next caller holding the uLog lock picks up.  See ulog_reload.h.
+#ifndef ULOG_HOT_RELOAD
+  #define ULOG_HOT_RELOAD 0
+#endif
+
+// Set ULOG_BINARY_LOG to 1 (POSIX hosts only) to build the subscriber of
+// ulog_binlog.h, which appends timestamped binary records to a file for
+// tools/ulog-columnar.c.  It numbers up to ULOG_BINLOG_SITES call sites, and
+// starts a new chunk, which tools/ulog-decode.c can decode on its own, every
+// ULOG_BINLOG_CHUNK_SIZE bytes.  With ULOG_BINLOG_FLUSH at 1 every message
+// is flushed to the file at once, for tools/ulog-tail.c --follow, at the cost
+// of a write() call per message.
+#ifndef ULOG_BINARY_LOG
+  #define ULOG_BINARY_LOG 0
+#endif
+#ifndef ULOG_BINLOG_SITES
+  #define ULOG_BINLOG_SITES 1024
+#endif
+#ifndef ULOG_BINLOG_CHUNK_SIZE
+  #define ULOG_BINLOG_CHUNK_SIZE 65536
+#endif
+#ifndef ULOG_BINLOG_FLUSH
+  #define ULOG_BINLOG_FLUSH 0
+#endif
+
+// ulog_level_parse() is built for the features that take level names
+// (ULOG_CTL, ULOG_HOT_RELOAD) and for the tools that read binary logs.
+// Set ULOG_LEVEL_PARSE to 1 to build it anyway.
+#ifndef ULOG_LEVEL_PARSE
+  #if (ULOG_CTL == 1) || (ULOG_HOT_RELOAD == 1) || (ULOG_BINARY_LOG == 1)
+    #define ULOG_LEVEL_PARSE 1
+  #else
+    #define ULOG_LEVEL_PARSE 0
+  #endif
+#endif
+
+// Set ULOG_DEFERRED to 1 to take formatting out of ulog_message().  The call
+// only captures the format and its arguments into a ring buffer of
+// ULOG_DEFERRED_BUFFER_SIZE bytes (see ulog_capture.h), and
+// ulog_deferred_flush() formats and delivers the messages later, typically
+// from an idle task.  A record takes at most ULOG_DEFERRED_RECORD_SIZE bytes;
+// %s arguments outside the ULOG_STATIC_RANGES static ranges are copied, cut
+// to ULOG_CAPTURE_STRING_MAX characters.
+#ifndef ULOG_DEFERRED
+  #define ULOG_DEFERRED 0
+#endif
+#ifndef ULOG_DEFERRED_BUFFER_SIZE
+  #define ULOG_DEFERRED_BUFFER_SIZE 2048
+#endif
+#ifndef ULOG_DEFERRED_RECORD_SIZE
+  #define ULOG_DEFERRED_RECORD_SIZE 160
+#endif
+#ifndef ULOG_CAPTURE_STRING_MAX
+  #define ULOG_CAPTURE_STRING_MAX 32
+#endif
+#ifndef ULOG_STATIC_RANGES
+  #define ULOG_STATIC_RANGES 8
+#endif
+
+// ulog_deferred_flush() parses each format once and keeps the result for the
+// following messages of its call site, in a table of ULOG_FORMAT_CACHE
+// formats of up to ULOG_FORMAT_STEPS conversions each.  0 parses every time.
+#ifndef ULOG_FORMAT_CACHE
+  #define ULOG_FORMAT_CACHE 8
+#endif
+#ifndef ULOG_FORMAT_STEPS
+  #define ULOG_FORMAT_STEPS 8
+#endif
+
+// With ULOG_SHORTEST_G at 1, a plain %g in a deferred message prints the
+// shortest text that reads back to the same double (see ulog_dtoa.h) rather
+// than 6 significant digits.  Link src/ulog_dtoa.c as well.
+#ifndef ULOG_SHORTEST_G
+  #define ULOG_SHORTEST_G 0
+#endif
+
+// Set ULOG_TINY_PRINTF to 1 to format messages with ulog_vsnprintf() (see
+// ulog_printf.h) rather than the C library's vsnprintf(): no floating point,
+// one small stack frame and little code.  ULOG_PRINTF_LONG_LONG at 0 also
+// leaves out 64-bit conversions.  Link src/ulog_printf.c as well.
+#ifndef ULOG_TINY_PRINTF
+  #define ULOG_TINY_PRINTF 0
+#endif
+#ifndef ULOG_PRINTF_LONG_LONG
+  #define ULOG_PRINTF_LONG_LONG 1
+#endif
+
+// Set ULOG_UART_SINK to 1 to build the double-buffered UART subscriber of
+// ulog_uart.h, with two buffers of ULOG_UART_BUFFER_SIZE bytes.
+#ifndef ULOG_UART_SINK
+  #define ULOG_UART_SINK 0
+#endif
+#ifndef ULOG_UART_BUFFER_SIZE
+  #define ULOG_UART_BUFFER_SIZE 256
+#endif
+
+// Set ULOG_FLASH_SINK to 1 to build the persistent flash subscriber of
+// ulog_flash.h.  Records are padded to ULOG_FLASH_ALIGN bytes, the smallest
+// unit the flash programs (8 for STM32L4 double words, 1 for NOR).
+#ifndef ULOG_FLASH_SINK
+  #define ULOG_FLASH_SINK 0
+#endif
+#ifndef ULOG_FLASH_ALIGN
+  #define ULOG_FLASH_ALIGN 8
+#endif
+
+// Set ULOG_CORE_REGISTRY to 1 to put a magic header on the message buffer,
+// the deferred ring and the subscriber queues, and list them in
+// ulog_core_registry (see ulog_core.h), so that tools/ulog-core.c can read
+// the messages still pending out of a core file.
+#ifndef ULOG_CORE_REGISTRY
+  #define ULOG_CORE_REGISTRY 0
+#endif
+
+// With ULOG_COLD_CALLS at 1 (GCC and clang), the code that sets up and makes
+// the call for a ULOG_xxx() statement is moved out of the function containing
+// it, which keeps only the level test and a branch.  Statements below
+// ULOG_LIKELY_LEVEL are also hinted as unlikely to be enabled.
+#ifndef ULOG_COLD_CALLS
+  #define ULOG_COLD_CALLS 1
+#endif
+#ifndef ULOG_LIKELY_LEVEL
+  #define ULOG_LIKELY_LEVEL ULOG_WARNING_LEVEL
+#endif
+
+// Set ULOG_STATIC_SUBSCRIBERS to 1 when the subscribers are fixed at build
+// time.  ulog.h then includes ULOG_SUBSCRIBERS_H, which must define the
+// X-macro ULOG_SUBSCRIBERS(X) with one X(function, threshold) per subscriber
+// and declare the functions.  bench/ulog_subscribers.h is an example.
+// Messages are dispatched with direct calls and constant thresholds instead
+// of a scan of the subscriber table, and ULOG_xxx() statements that no
+// subscriber wants compile to nothing.  Defining the subscribers static
+// inline in that header lets the compiler inline them into ulog.c.
+// ulog_subscribe() and ulog_unsubscribe() return ULOG_ERR_STATIC_SUBSCRIBERS.
+#ifndef ULOG_STATIC_SUBSCRIBERS
+  #define ULOG_STATIC_SUBSCRIBERS 0
+#endif
+#ifndef ULOG_SUBSCRIBERS_H
+  #define ULOG_SUBSCRIBERS_H "ulog_subscribers.h"
+#endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_core.h
+ *
+ * \brief the in-memory layout of the messages uLog holds, for reading them
+ * out of a core file
+ *
+ * With ULOG_CORE_REGISTRY, each buffer that holds messages starts with a
+ * ulog_core_header_t: the message being formatted, the deferred ring and the
+ * queue of every subscriber.  ulog_core_registry, a global with a magic
+ * number of its own, points at all of them.  tools/ulog-core.c finds the
+ * registry in a core file, or the headers alone if the registry is damaged,
+ * and prints the messages that were still pending.
+ *
+ * The types below are the ones ulog.c uses, so a reader built with the same
+ * ulog_config.h settings and for the same ABI decodes them directly; the
+ * size in each header lets it refuse a mismatch.
+ */
+
+#ifndef ULOG_CORE_H_
+#define ULOG_CORE_H_
+
+#include "ulog.h"
+#include "ulog_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+#define ULOG_CORE_MAGIC 0x52474c55u         // "ULGR", the registry
+#define ULOG_CORE_HEADER_MAGIC 0x42474c55u  // "ULGB", a buffer
+#define ULOG_CORE_VERSION 1
+
+// room in the registry: the message buffer, the ring and the queues
+#define ULOG_CORE_BUFFERS (ULOG_MAX_SUBSCRIBERS + 2)
+
+typedef enum {
+  ULOG_CORE_MESSAGE = 1,    // char[ULOG_MAX_MESSAGE_LENGTH], the last message
+  ULOG_CORE_DEFERRED,       // ulog_core_ring_t
+  ULOG_CORE_QUEUE,          // ulog_core_queue_t of subscriber slot index
+} ulog_core_kind_t;
+
+typedef struct {
+  uint32_t magic;           // ULOG_CORE_HEADER_MAGIC
+  uint16_t kind;            // ulog_core_kind_t
+  uint16_t index;
+  uint32_t size;            // bytes at data
+  const volatile void *data;
+} ulog_core_header_t;
+
+typedef struct {
+  uint32_t magic;           // ULOG_CORE_MAGIC
+  uint16_t version;         // ULOG_CORE_VERSION
+  uint16_t pointer_size;
+  uint32_t count;           // headers in use
+  const ulog_core_header_t *headers[ULOG_CORE_BUFFERS];
+} ulog_core_registry_t;
+
+// a message in the deferred ring: this header, then the captured arguments
+// or, if text is set, the message already rendered (without its NUL)
+typedef struct {
+  uint16_t size;            // bytes in the record, header included
+  uint8_t severity;
+  uint8_t text;
+  int line;
+  const char *file;
+  const char *fmt;
+  ulog_site_t *site;
+} ulog_core_record_t;
+
+// the deferred ring.  Records are never split: one that does not fit before
+// the end starts again at 0, and wrap marks where the reader must follow.
+typedef struct {
+  uint32_t head;            // where the next record goes
+  uint32_t tail;            // oldest record
+  uint32_t wrap;            // end of the records written before a wrap
+  uint32_t used;            // bytes held by records
+  uint8_t data[ULOG_DEFERRED_BUFFER_SIZE];
+} ulog_core_ring_t;
+
+// a message waiting for a demoted subscriber
+typedef struct {
+  ulog_level_t severity;
+  const char *file;
+  int line;
+  char msg[ULOG_MAX_MESSAGE_LENGTH];
+} ulog_core_message_t;
+
+typedef struct {
+  ulog_core_message_t entries[ULOG_ASYNC_QUEUE_DEPTH];
+  int head;                 // index of the oldest entry
+  int count;
+} ulog_core_queue_t;
+
+#if (ULOG_ENABLED == 1) && (ULOG_CORE_REGISTRY == 1)
+extern ulog_core_registry_t ulog_core_registry;
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_CORE_H_ */
@@ -0,0 +1,259 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_ctl.c
+ *
+ * \brief run-time control of uLog over a Unix socket (POSIX only)
+ *
+ * See ulog_ctl.h.  Link with -lpthread.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ulog_ctl.h"
+#include "ulog_config.h"
+
+#if (ULOG_ENABLED == 1) && (ULOG_CTL == 1)  // whole file...
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// =============================================================================
+// types and definitions
+
+#define MAX_COMMAND_LENGTH 256
+#define CLIENT_TIMEOUT_MS 1000   // a silent client is dropped after this
+
+// =============================================================================
+// local storage
+
+static struct {
+  int listen_fd;
+  pthread_t thread;
+  ulog_flush_t flush_fn;
+  char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+} ulog_ctl = { .listen_fd = -1 };
+
+// =============================================================================
+// local functions
+
+static void *serve(void *arg);
+static void execute(FILE *out, char *command);
+
+// =============================================================================
+// user-visible code
+
+ulog_err_t ulog_ctl_open(const char *path, ulog_flush_t flush_fn) {
+  struct sockaddr_un address;
+
+  if (path == NULL) {
+    snprintf(ulog_ctl.path, sizeof(ulog_ctl.path), "/tmp/ulog.%d.sock", (int)getpid());
+  } else {
+    snprintf(ulog_ctl.path, sizeof(ulog_ctl.path), "%s", path);
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  memcpy(address.sun_path, ulog_ctl.path, sizeof(address.sun_path));
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return ULOG_ERR_SYSTEM;
+  }
+  unlink(ulog_ctl.path);      // left behind by an earlier run
+  if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(fd, 4) != 0) {
+    close(fd);
+    return ULOG_ERR_SYSTEM;
+  }
+  ulog_ctl.listen_fd = fd;
+  ulog_ctl.flush_fn = flush_fn;
+  if (pthread_create(&ulog_ctl.thread, NULL, serve, NULL) != 0) {
+    ulog_ctl.listen_fd = -1;
+    close(fd);
+    unlink(ulog_ctl.path);
+    return ULOG_ERR_SYSTEM;
+  }
+  return ULOG_ERR_NONE;
+}
+
+void ulog_ctl_close() {
+  if (ulog_ctl.listen_fd < 0) {
+    return;
+  }
+  shutdown(ulog_ctl.listen_fd, SHUT_RDWR);    // wakes up accept()
+  pthread_join(ulog_ctl.thread, NULL);
+  close(ulog_ctl.listen_fd);
+  ulog_ctl.listen_fd = -1;
+  unlink(ulog_ctl.path);
+}
+
+// =============================================================================
+// private code
+
+static void *serve(void *arg) {
+  (void)arg;
+  char command[MAX_COMMAND_LENGTH];
+  struct timeval timeout = {
+    .tv_sec = CLIENT_TIMEOUT_MS / 1000,
+    .tv_usec = (CLIENT_TIMEOUT_MS % 1000) * 1000,
+  };
+
+  for (;;) {
+    int fd = accept(ulog_ctl.listen_fd, NULL, NULL);
+    if (fd < 0) {
+      return NULL;            // closed by ulog_ctl_close()
+    }
+    // so that a client that never sends or never reads cannot keep the
+    // thread, and with it ulog_ctl_close(), waiting
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    FILE *stream = fdopen(fd, "r+");
+    if (stream == NULL) {
+      close(fd);
+      continue;
+    }
+    if (fgets(command, sizeof(command), stream) != NULL) {
+      command[strcspn(command, "\r\n")] = '\0';
+      fseek(stream, 0, SEEK_CUR);   // switch the stream from reading to writing
+      execute(stream, command);
+    }
+    fclose(stream);
+  }
+}
+
+#if (ULOG_SITES == 1)
+// split "file:line" into its parts.  No ":line" means every line.
+static const char *parse_location(char *location, int *line) {
+  char *colon = strrchr(location, ':');
+  *line = 0;
+  if (colon != NULL) {
+    *colon = '\0';
+    *line = atoi(colon + 1);
+  }
+  return location;
+}
+#endif
+
+static void list(FILE *out) {
+  ulog_function_t fn;
+  ulog_level_t threshold;
+
+  for (int slot=0; slot<ULOG_MAX_SUBSCRIBERS; slot++) {
+    if (ulog_subscriber_get(slot, &fn, &threshold) == ULOG_ERR_NONE) {
+      fprintf(out, "subscriber %d %p %s\n",
+              slot, (void *)(size_t)fn, ulog_level_name(threshold));
+    }
+  }
+#if (ULOG_SITES == 1)
+  for (const ulog_site_t *site = ulog_site_first(); site != NULL; site = site->next) {
+    fprintf(out, "site %lu %s:%d %s %s rate=%lu hits=%lu emitted=%lu "
+            "bytes=%lu suppressed=%lu \"%s\"\n",
+            (unsigned long)site->id, site->file, site->line,
+            ulog_level_name(site->level),
+            site->disabled ? "off" : "on",
+            (unsigned long)site->rate_limit,
+            (unsigned long)site->hits,
+            (unsigned long)site->emitted,
+            (unsigned long)site->bytes,
+            (unsigned long)site->suppressed,
+            site->fmt);
+  }
+#endif
+}
+
+static void execute(FILE *out, char *command) {
+  const char *error = NULL;
+  char *save;
+  char *verb = strtok_r(command, " \t", &save);
+  char *arg1 = strtok_r(NULL, " \t", &save);
+  char *arg2 = strtok_r(NULL, " \t", &save);
+
+  if (verb == NULL) {
+    error = "empty command";
+
+  } else if (strcmp(verb, "list") == 0) {
+    list(out);
+
+  } else if (strcmp(verb, "level") == 0 && arg2 != NULL) {
+    ulog_function_t fn;
+    ulog_level_t threshold;
+    ulog_level_t level = ulog_level_parse(arg2);
+    if (level == ULOG_LEVEL_N) {
+      error = "unknown level";
+    } else if (ulog_subscriber_get(atoi(arg1), &fn, &threshold) != ULOG_ERR_NONE) {
+      error = "no subscriber in that slot";
+    } else {
+      ulog_subscribe(fn, level);
+    }
+
+#if (ULOG_SITES == 1)
+  } else if (strcmp(verb, "site") == 0 && arg2 != NULL) {
+    int line;
+    const char *file = parse_location(arg1, &line);
+    if (ulog_site_enable(file, line, strcmp(arg2, "on") == 0) != ULOG_ERR_NONE) {
+      error = "no such site";
+    }
+
+  } else if (strcmp(verb, "rate") == 0 && arg2 != NULL) {
+    int line = 0;
+    const char *file = (strcmp(arg1, "*") == 0) ? NULL : parse_location(arg1, &line);
+    if (ulog_site_set_rate_limit(file, line, strtoul(arg2, NULL, 10)) != ULOG_ERR_NONE) {
+      error = "no such site";
+    }
+#endif
+
+  } else if (strcmp(verb, "quiet") == 0 && arg1 != NULL) {
+    ulog_set_quite(strcmp(arg1, "on") == 0);
+
+  } else if (strcmp(verb, "flush") == 0) {
+    // ulog_drain() and ulog_deferred_flush() expect a single caller: with
+    // the endpoint open, that caller is this thread (see ulog_ctl.h)
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+    fprintf(out, "drained %d\n", ulog_drain());
+#endif
+#if (ULOG_DEFERRED == 1)
+    fprintf(out, "deferred %d\n", ulog_deferred_flush());
+#endif
+    if (ulog_ctl.flush_fn != NULL) {
+      ulog_ctl.flush_fn();
+    }
+
+  } else {
+    error = "unknown command or missing argument";
+  }
+
+  if (error != NULL) {
+    fprintf(out, "error: %s\n", error);
+  } else {
+    fprintf(out, "ok\n");
+  }
+}
+
+#endif  // #if (ULOG_ENABLED == 1) && (ULOG_CTL == 1)
@@ -0,0 +1,82 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_ctl.h
+ *
+ * \brief run-time control of uLog over a Unix socket (POSIX only)
+ *
+ * ulog_ctl_open() starts a thread that serves one command per connection.
+ * tools/ulogctl.c is the matching client.  The commands are:
+ *
+ *     list                              subscribers and call sites
+ *     level <slot> <LEVEL>              change a subscriber's threshold
+ *     site <file>[:<line>] on|off       enable or disable call sites
+ *     rate <file>[:<line>]|* <n>        limit call sites to n messages/s
+ *     quiet on|off                      ulog_set_quite()
+ *     flush                             drain async queues and the deferred
+ *                                       ring, then flush_fn
+ *
+ * The reply is zero or more lines followed by "ok" or "error: <reason>".
+ * Every change is made through the regular uLog API under the uLog lock, so
+ * ulog_message() sees it on its next call and pays nothing extra for it.
+ *
+ * "flush" calls ulog_drain() (ULOG_SUBSCRIBER_TIMING) and
+ * ulog_deferred_flush() (ULOG_DEFERRED) from the control thread.  Both expect
+ * a single caller, so while the endpoint is open the application must not
+ * call them from any other thread.
+ */
+
+#ifndef ULOG_CTL_H_
+#define ULOG_CTL_H_
+
+#include "ulog.h"
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+/**
+ * @brief: prototype for the function that flushes buffered sinks.
+ */
+typedef void (*ulog_flush_t)(void);
+
+/**
+ * @brief: serve control commands on the Unix socket at path.
+ *
+ * A NULL path means "/tmp/ulog.<pid>.sock".  flush_fn, which may be NULL, is
+ * called by the "flush" command from the control thread.  A client that
+ * sends no command, or reads no reply, for a second is dropped.
+ */
+ulog_err_t ulog_ctl_open(const char *path, ulog_flush_t flush_fn);
+
+/**
+ * @brief: stop the control thread and remove the socket.
+ */
+void ulog_ctl_close();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_CTL_H_ */
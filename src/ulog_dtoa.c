@@ -0,0 +1,330 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_dtoa.c
+ *
+ * \brief shortest decimal text of a double that reads back to the same bits
+ *
+ * Grisu2 (Florian Loitsch, "Printing Floating-Point Numbers Quickly and
+ * Accurately with Integers", PLDI 2010), in 64-bit integer arithmetic only.
+ * The digits always lie strictly inside the interval of reals that round to
+ * value, so they read back exactly; in about 0.1% of cases one digit more
+ * than the shortest possible is written.
+ */
+
+#include "ulog_dtoa.h"
+#include "ulog_config.h"
+
+#if (ULOG_ENABLED == 1)  // whole file...
+
+#include <stdint.h>
+#include <string.h>
+
+// =============================================================================
+// local types and definitions
+
+// f * 2^e
+typedef struct {
+  uint64_t f;
+  int e;
+} diy_fp_t;
+
+#define HIDDEN_BIT (1ULL << 52)
+
+// =============================================================================
+// local storage
+
+// 10^k for k = -348, -340, ... 340, normalized and rounded to 64 bits
+static const diy_fp_t cached_powers[] = {
+  { 0xfa8fd5a0081c0288ULL, -1220 }, { 0xbaaee17fa23ebf76ULL, -1193 },
+  { 0x8b16fb203055ac76ULL, -1166 }, { 0xcf42894a5dce35eaULL, -1140 },
+  { 0x9a6bb0aa55653b2dULL, -1113 }, { 0xe61acf033d1a45dfULL, -1087 },
+  { 0xab70fe17c79ac6caULL, -1060 }, { 0xff77b1fcbebcdc4fULL, -1034 },
+  { 0xbe5691ef416bd60cULL, -1007 }, { 0x8dd01fad907ffc3cULL, -980 },
+  { 0xd3515c2831559a83ULL, -954 }, { 0x9d71ac8fada6c9b5ULL, -927 },
+  { 0xea9c227723ee8bcbULL, -901 }, { 0xaecc49914078536dULL, -874 },
+  { 0x823c12795db6ce57ULL, -847 }, { 0xc21094364dfb5637ULL, -821 },
+  { 0x9096ea6f3848984fULL, -794 }, { 0xd77485cb25823ac7ULL, -768 },
+  { 0xa086cfcd97bf97f4ULL, -741 }, { 0xef340a98172aace5ULL, -715 },
+  { 0xb23867fb2a35b28eULL, -688 }, { 0x84c8d4dfd2c63f3bULL, -661 },
+  { 0xc5dd44271ad3cdbaULL, -635 }, { 0x936b9fcebb25c996ULL, -608 },
+  { 0xdbac6c247d62a584ULL, -582 }, { 0xa3ab66580d5fdaf6ULL, -555 },
+  { 0xf3e2f893dec3f126ULL, -529 }, { 0xb5b5ada8aaff80b8ULL, -502 },
+  { 0x87625f056c7c4a8bULL, -475 }, { 0xc9bcff6034c13053ULL, -449 },
+  { 0x964e858c91ba2655ULL, -422 }, { 0xdff9772470297ebdULL, -396 },
+  { 0xa6dfbd9fb8e5b88fULL, -369 }, { 0xf8a95fcf88747d94ULL, -343 },
+  { 0xb94470938fa89bcfULL, -316 }, { 0x8a08f0f8bf0f156bULL, -289 },
+  { 0xcdb02555653131b6ULL, -263 }, { 0x993fe2c6d07b7facULL, -236 },
+  { 0xe45c10c42a2b3b06ULL, -210 }, { 0xaa242499697392d3ULL, -183 },
+  { 0xfd87b5f28300ca0eULL, -157 }, { 0xbce5086492111aebULL, -130 },
+  { 0x8cbccc096f5088ccULL, -103 }, { 0xd1b71758e219652cULL, -77 },
+  { 0x9c40000000000000ULL, -50 }, { 0xe8d4a51000000000ULL, -24 },
+  { 0xad78ebc5ac620000ULL, 3 }, { 0x813f3978f8940984ULL, 30 },
+  { 0xc097ce7bc90715b3ULL, 56 }, { 0x8f7e32ce7bea5c70ULL, 83 },
+  { 0xd5d238a4abe98068ULL, 109 }, { 0x9f4f2726179a2245ULL, 136 },
+  { 0xed63a231d4c4fb27ULL, 162 }, { 0xb0de65388cc8ada8ULL, 189 },
+  { 0x83c7088e1aab65dbULL, 216 }, { 0xc45d1df942711d9aULL, 242 },
+  { 0x924d692ca61be758ULL, 269 }, { 0xda01ee641a708deaULL, 295 },
+  { 0xa26da3999aef774aULL, 322 }, { 0xf209787bb47d6b85ULL, 348 },
+  { 0xb454e4a179dd1877ULL, 375 }, { 0x865b86925b9bc5c2ULL, 402 },
+  { 0xc83553c5c8965d3dULL, 428 }, { 0x952ab45cfa97a0b3ULL, 455 },
+  { 0xde469fbd99a05fe3ULL, 481 }, { 0xa59bc234db398c25ULL, 508 },
+  { 0xf6c69a72a3989f5cULL, 534 }, { 0xb7dcbf5354e9beceULL, 561 },
+  { 0x88fcf317f22241e2ULL, 588 }, { 0xcc20ce9bd35c78a5ULL, 614 },
+  { 0x98165af37b2153dfULL, 641 }, { 0xe2a0b5dc971f303aULL, 667 },
+  { 0xa8d9d1535ce3b396ULL, 694 }, { 0xfb9b7cd9a4a7443cULL, 720 },
+  { 0xbb764c4ca7a44410ULL, 747 }, { 0x8bab8eefb6409c1aULL, 774 },
+  { 0xd01fef10a657842cULL, 800 }, { 0x9b10a4e5e9913129ULL, 827 },
+  { 0xe7109bfba19c0c9dULL, 853 }, { 0xac2820d9623bf429ULL, 880 },
+  { 0x80444b5e7aa7cf85ULL, 907 }, { 0xbf21e44003acdd2dULL, 933 },
+  { 0x8e679c2f5e44ff8fULL, 960 }, { 0xd433179d9c8cb841ULL, 986 },
+  { 0x9e19db92b4e31ba9ULL, 1013 }, { 0xeb96bf6ebadf77d9ULL, 1039 },
+  { 0xaf87023b9bf0ee6bULL, 1066 },
+};
+
+static const uint32_t powers_of_10[] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+// =============================================================================
+// local functions
+
+// x * y, keeping the upper 64 bits of the product rounded
+static diy_fp_t multiply(diy_fp_t x, diy_fp_t y) {
+  const uint64_t mask = 0xffffffffULL;
+  uint64_t a = x.f >> 32;
+  uint64_t b = x.f & mask;
+  uint64_t c = y.f >> 32;
+  uint64_t d = y.f & mask;
+  uint64_t ac = a * c;
+  uint64_t bc = b * c;
+  uint64_t ad = a * d;
+  uint64_t bd = b * d;
+  uint64_t middle = (bd >> 32) + (ad & mask) + (bc & mask) + (1ULL << 31);
+  diy_fp_t product = { ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64 };
+  return product;
+}
+
+// shift x until its top bit is set
+static diy_fp_t normalize(diy_fp_t x) {
+#if defined(__GNUC__)
+  int shift = __builtin_clzll(x.f);
+#else
+  int shift = 0;
+  while (!(x.f & (1ULL << (63 - shift)))) {
+    shift++;
+  }
+#endif
+  x.f <<= shift;
+  x.e -= shift;
+  return x;
+}
+
+// the bounds of the reals that round to v, both with the exponent of the
+// normalized upper one
+static void boundaries(diy_fp_t v, diy_fp_t *minus, diy_fp_t *plus) {
+  diy_fp_t upper = { (v.f << 1) + 1, v.e - 1 };
+  diy_fp_t lower = { (v.f << 1) - 1, v.e - 1 };
+  if (v.f == HIDDEN_BIT) {
+    // the next double down is closer: its exponent is one less
+    lower.f = (v.f << 2) - 1;
+    lower.e = v.e - 2;
+  }
+  *plus = normalize(upper);
+  lower.f <<= lower.e - plus->e;
+  lower.e = plus->e;
+  *minus = lower;
+}
+
+// the cached power c_k = 10^-k that brings a number of binary exponent e
+// into [2^-60, 2^-32] after multiplication
+static diy_fp_t cached_power(int e, int *k) {
+  double dk = (-61 - e) * 0.30102999566398114 + 347;    // log10(2)
+  int ik = (int)dk;
+  if (dk - ik > 0.0) {
+    ik++;
+  }
+  unsigned index = (unsigned)((ik >> 3) + 1);
+  *k = -(-348 + (int)(index << 3));
+  return cached_powers[index];
+}
+
+// step the last digit down while that brings it closer to w and stays in
+// range
+static void round_weed(char *digits, int len, uint64_t delta, uint64_t rest,
+                       uint64_t ten_kappa, uint64_t wp_w) {
+  while (rest < wp_w && delta - rest >= ten_kappa &&
+         (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+    digits[len - 1]--;
+    rest += ten_kappa;
+  }
+}
+
+// generate the digits of plus until they fall within delta of it.  Adds the
+// exponent of the last digit to *k.
+static int generate(diy_fp_t w, diy_fp_t plus, uint64_t delta, char *digits, int *k) {
+  diy_fp_t one = { 1ULL << -plus.e, plus.e };
+  uint64_t wp_w = plus.f - w.f;
+  uint32_t p1 = (uint32_t)(plus.f >> -one.e);
+  uint64_t p2 = plus.f & (one.f - 1);
+  int len = 0;
+  int kappa = 1;
+
+  while (kappa < 10 && p1 >= powers_of_10[kappa]) {
+    kappa++;
+  }
+  while (kappa > 0) {
+    uint32_t d = p1 / powers_of_10[kappa - 1];
+    p1 %= powers_of_10[kappa - 1];
+    if (d != 0 || len != 0) {
+      digits[len++] = (char)('0' + d);
+    }
+    kappa--;
+    uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+    if (rest <= delta) {
+      *k += kappa;
+      round_weed(digits, len, delta, rest, (uint64_t)powers_of_10[kappa] << -one.e, wp_w);
+      return len;
+    }
+  }
+  for (;;) {
+    p2 *= 10;
+    delta *= 10;
+    char d = (char)(p2 >> -one.e);
+    if (d != 0 || len != 0) {
+      digits[len++] = (char)('0' + d);
+    }
+    p2 &= one.f - 1;
+    kappa--;
+    if (p2 < delta) {
+      *k += kappa;
+      round_weed(digits, len, delta, p2, one.f,
+                 wp_w * ((-kappa < 10) ? powers_of_10[-kappa] : 0));
+      return len;
+    }
+  }
+}
+
+// the digits of the positive, finite value, which is digits * 10^k
+static int grisu2(double value, char *digits, int *k) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  int biased = (int)((bits >> 52) & 0x7ff);
+  diy_fp_t v = { bits & (HIDDEN_BIT - 1), -1074 };
+  if (biased != 0) {
+    v.f += HIDDEN_BIT;
+    v.e = biased - 1075;
+  }
+  diy_fp_t minus;
+  diy_fp_t plus;
+  boundaries(v, &minus, &plus);
+  diy_fp_t c = cached_power(plus.e, k);
+  diy_fp_t w = multiply(normalize(v), c);
+  diy_fp_t upper = multiply(plus, c);
+  diy_fp_t lower = multiply(minus, c);
+  lower.f++;                    // stay clear of the rounding error
+  upper.f--;
+  return generate(w, upper, upper.f - lower.f, digits, k);
+}
+
+// write len digits times 10^k as plain or scientific notation
+static int layout(char *buf, const char *digits, int len, int k) {
+  int point = len + k;          // digits before the decimal point
+  int n = 0;
+
+  if (point > 0 && point <= 17) {
+    if (point >= len) {
+      memcpy(buf, digits, len);
+      memset(&buf[len], '0', point - len);
+      n = point;
+    } else {
+      memcpy(buf, digits, point);
+      buf[point] = '.';
+      memcpy(&buf[point + 1], &digits[point], len - point);
+      n = len + 1;
+    }
+  } else if (point <= 0 && point > -5) {
+    buf[n++] = '0';
+    buf[n++] = '.';
+    memset(&buf[n], '0', -point);
+    n += -point;
+    memcpy(&buf[n], digits, len);
+    n += len;
+  } else {
+    int exponent = point - 1;
+    buf[n++] = digits[0];
+    if (len > 1) {
+      buf[n++] = '.';
+      memcpy(&buf[n], &digits[1], len - 1);
+      n += len - 1;
+    }
+    buf[n++] = 'e';
+    buf[n++] = (exponent < 0) ? '-' : '+';
+    if (exponent < 0) {
+      exponent = -exponent;
+    }
+    if (exponent >= 100) {
+      buf[n++] = (char)('0' + exponent / 100);
+    }
+    buf[n++] = (char)('0' + exponent / 10 % 10);
+    buf[n++] = (char)('0' + exponent % 10);
+  }
+  buf[n] = '\0';
+  return n;
+}
+
+// =============================================================================
+// user-visible code
+
+int ulog_dtoa(double value, char *buf) {
+  char digits[18];
+  uint64_t bits;
+  int n = 0;
+  int k;
+
+  memcpy(&bits, &value, sizeof(bits));
+  if (bits >> 63) {
+    buf[n++] = '-';
+    bits &= ~(1ULL << 63);
+    memcpy(&value, &bits, sizeof(value));
+  }
+  if ((bits >> 52) == 0x7ff) {
+    if (bits & (HIDDEN_BIT - 1)) {
+      n = 0;                    // no sign on nan
+      memcpy(buf, "nan", 4);
+      return 3;
+    }
+    memcpy(&buf[n], "inf", 4);
+    return n + 3;
+  }
+  if (bits == 0) {
+    buf[n++] = '0';
+    buf[n] = '\0';
+    return n;
+  }
+  int len = grisu2(value, digits, &k);
+  return n + layout(&buf[n], digits, len, k);
+}
+
+#endif  // #if (ULOG_ENABLED == 1)
@@ -0,0 +1,56 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_dtoa.h
+ *
+ * \brief shortest decimal text of a double that reads back to the same bits
+ *
+ * ulog_dtoa() writes the fewest significant digits that strtod() turns back
+ * into exactly the same double, without snprintf() and without a locale:
+ * 0.1 is "0.1" where "%.17g" prints 0.10000000000000001.  Exponents from -5
+ * to 16 are written out in full, others as 1.5e+300.  Infinities and NaN are
+ * written as inf, -inf and nan.
+ */
+
+#ifndef ULOG_DTOA_H_
+#define ULOG_DTOA_H_
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+// the longest text of ulog_dtoa(), with its NUL
+#define ULOG_DTOA_SIZE 25
+
+/**
+ * @brief: write the shortest round trip text of value and a NUL into buf,
+ * which holds at least ULOG_DTOA_SIZE characters.  Returns the length.
+ */
+int ulog_dtoa(double value, char *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_DTOA_H_ */
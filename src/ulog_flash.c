@@ -0,0 +1,299 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_flash.c
+ *
+ * \brief a uLog subscriber that keeps the latest messages in flash
+ *
+ * See ulog_flash.h.  A sector is a sector_header_t followed by records, each
+ * a record_header_t and its payload: the severity byte and the message text
+ * without a NUL.  Headers and records are padded to ULOG_FLASH_ALIGN.  Erased
+ * flash reads 0xff, so an all-ones record header marks the end of a sector.
+ */
+
+#include "ulog_flash.h"
+#include "ulog_config.h"
+
+#if (ULOG_ENABLED == 1) && (ULOG_FLASH_SINK == 1)  // whole file...
+
+#include <stddef.h>
+#include <string.h>
+
+// =============================================================================
+// local types and definitions
+
+#define SECTOR_MAGIC 0x46474c55       // "ULGF" in a little-endian dump
+
+typedef struct {
+  uint32_t magic;
+  uint32_t sequence;        // one more than the sector used before
+  uint32_t erase_count;     // erases of this sector, this one included
+  uint32_t crc;             // of the fields above
+} sector_header_t;
+
+typedef struct {
+  uint16_t length;          // payload bytes
+  uint16_t check;           // ~length
+  uint32_t crc;             // of the payload
+} record_header_t;
+
+#define ALIGN(n) (((n) + ULOG_FLASH_ALIGN - 1) / ULOG_FLASH_ALIGN * ULOG_FLASH_ALIGN)
+#define SECTOR_HEADER_SIZE ALIGN(sizeof(sector_header_t))
+#define MAX_PAYLOAD (1 + ULOG_MAX_MESSAGE_LENGTH)
+
+// =============================================================================
+// local storage
+
+static struct {
+  const ulog_flash_driver_t *flash;
+  uint32_t sector;          // being written
+  uint32_t offset;          // of the next record in it
+  uint32_t sequence;        // of the current sector
+  uint32_t erase_count;     // of the current sector
+  uint8_t record[ALIGN(sizeof(record_header_t) + MAX_PAYLOAD)];
+  ulog_flash_stats_t stats;
+} ulog_flash;
+
+// =============================================================================
+// local functions
+
+// CRC-32 (IEEE), bit by bit: small rather than fast
+static uint32_t crc32(const void *data, uint32_t len) {
+  const uint8_t *p = (const uint8_t *)data;
+  uint32_t crc = 0xffffffff;
+  while (len--) {
+    crc ^= *p++;
+    for (int i=0; i<8; i++) {
+      crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+// true if sector has an intact header, copied to header
+static bool read_sector_header(const ulog_flash_driver_t *flash, uint32_t sector,
+                               sector_header_t *header) {
+  if (flash->read(flash->ctx, sector * flash->sector_size, header,
+                  sizeof(*header)) != ULOG_ERR_NONE) {
+    return false;
+  }
+  return header->magic == SECTOR_MAGIC &&
+         header->crc == crc32(header, offsetof(sector_header_t, crc));
+}
+
+// read the record at offset of sector into payload.  Returns its total size,
+// 0 at the end of the records, -1 at a damaged record.
+static int read_record(const ulog_flash_driver_t *flash, uint32_t sector,
+                       uint32_t offset, uint8_t *payload, int *length) {
+  record_header_t header;
+  uint32_t address = sector * flash->sector_size + offset;
+
+  if (offset + sizeof(header) > flash->sector_size ||
+      flash->read(flash->ctx, address, &header, sizeof(header)) != ULOG_ERR_NONE) {
+    return 0;
+  }
+  if (header.length == 0xffff && header.check == 0xffff && header.crc == 0xffffffff) {
+    return 0;                   // erased
+  }
+  if ((header.check ^ header.length) != 0xffff || header.length == 0 ||
+      header.length > MAX_PAYLOAD ||
+      offset + sizeof(header) + header.length > flash->sector_size) {
+    return -1;
+  }
+  if (flash->read(flash->ctx, address + sizeof(header), payload,
+                  header.length) != ULOG_ERR_NONE ||
+      crc32(payload, header.length) != header.crc) {
+    return -1;
+  }
+  *length = header.length;
+  return ALIGN(sizeof(header) + header.length);
+}
+
+// erase sector and make it the current one, numbered sequence
+static ulog_err_t start_sector(uint32_t sector, uint32_t sequence) {
+  const ulog_flash_driver_t *flash = ulog_flash.flash;
+  sector_header_t header;
+  // a sector never used or whose header was torn has been erased about as
+  // often as the one before it in the ring
+  uint32_t erase_count = (ulog_flash.erase_count > 0) ? ulog_flash.erase_count - 1 : 0;
+
+  if (read_sector_header(flash, sector, &header)) {
+    erase_count = header.erase_count;
+  }
+  ulog_err_t err = flash->erase(flash->ctx, sector);
+  if (err != ULOG_ERR_NONE) {
+    return err;
+  }
+  ulog_flash.stats.erases++;
+  uint8_t padded[SECTOR_HEADER_SIZE];
+  memset(padded, 0xff, sizeof(padded));
+  header.magic = SECTOR_MAGIC;
+  header.sequence = sequence;
+  header.erase_count = erase_count + 1;
+  header.crc = crc32(&header, offsetof(sector_header_t, crc));
+  memcpy(padded, &header, sizeof(header));
+  err = flash->write(flash->ctx, sector * flash->sector_size, padded, sizeof(padded));
+  ulog_flash.sector = sector;
+  ulog_flash.sequence = sequence;
+  ulog_flash.erase_count = header.erase_count;
+  // a torn header leaves the sector unusable until the next turn
+  ulog_flash.offset = (err == ULOG_ERR_NONE) ? SECTOR_HEADER_SIZE : flash->sector_size;
+  return err;
+}
+
+// move on to the oldest sector
+static ulog_err_t advance() {
+  return start_sector((ulog_flash.sector + 1) % ulog_flash.flash->sector_count,
+                      ulog_flash.sequence + 1);
+}
+
+// =============================================================================
+// user-visible code
+
+ulog_err_t ulog_flash_open(const ulog_flash_driver_t *flash) {
+  sector_header_t header;
+  uint8_t payload[MAX_PAYLOAD];
+  bool found = false;
+  int length;
+
+  memset(&ulog_flash.stats, 0, sizeof(ulog_flash.stats));
+  ulog_flash.flash = flash;
+  ulog_flash.erase_count = 0;
+  for (uint32_t sector=0; sector<flash->sector_count; sector++) {
+    if (read_sector_header(flash, sector, &header) &&
+        (!found || header.sequence > ulog_flash.sequence)) {
+      found = true;
+      ulog_flash.sector = sector;
+      ulog_flash.sequence = header.sequence;
+      ulog_flash.erase_count = header.erase_count;
+    }
+  }
+  if (!found) {
+    return start_sector(0, 1);
+  }
+  // continue after the last intact record, or in a new sector if the newest
+  // one ends in a damaged record
+  int size;
+  ulog_flash.offset = SECTOR_HEADER_SIZE;
+  while ((size = read_record(flash, ulog_flash.sector, ulog_flash.offset,
+                             payload, &length)) > 0) {
+    ulog_flash.offset += size;
+  }
+  return (size < 0) ? advance() : ULOG_ERR_NONE;
+}
+
+void ulog_flash_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  const ulog_flash_driver_t *flash = ulog_flash.flash;
+  record_header_t header;
+
+  (void)file;
+  (void)line;
+  if (flash == NULL) {
+    return;
+  }
+  uint32_t room = flash->sector_size - SECTOR_HEADER_SIZE - sizeof(header);
+  uint32_t length = 1 + (uint32_t)strlen(msg);
+  if (length > MAX_PAYLOAD) {
+    length = MAX_PAYLOAD;
+  }
+  if (length > room) {
+    length = room;
+  }
+  uint32_t size = ALIGN(sizeof(header) + length);
+  if (ulog_flash.offset + size > flash->sector_size && advance() != ULOG_ERR_NONE) {
+    ulog_flash.stats.dropped++;
+    return;
+  }
+
+  uint8_t *payload = &ulog_flash.record[sizeof(header)];
+  payload[0] = (uint8_t)severity;
+  memcpy(&payload[1], msg, length - 1);
+  memset(&payload[length], 0xff, size - sizeof(header) - length);
+  header.length = (uint16_t)length;
+  header.check = (uint16_t)~length;
+  header.crc = crc32(payload, length);
+  memcpy(ulog_flash.record, &header, sizeof(header));
+  uint32_t address = ulog_flash.sector * flash->sector_size + ulog_flash.offset;
+  if (flash->write(flash->ctx, address, ulog_flash.record, size) != ULOG_ERR_NONE) {
+    ulog_flash.offset = flash->sector_size;     // the rest of it is suspect
+    ulog_flash.stats.dropped++;
+    return;
+  }
+  ulog_flash.offset += size;
+  ulog_flash.stats.records++;
+  ulog_flash.stats.bytes += size;
+}
+
+int ulog_flash_replay(const ulog_flash_driver_t *flash, ulog_flash_visit_t visit, void *arg) {
+  sector_header_t header;
+  uint8_t payload[MAX_PAYLOAD];
+  uint32_t last = 0;
+  int count = 0;
+  int length;
+
+  // the sectors in sequence order, by finding the next one each time
+  for (;;) {
+    bool found = false;
+    uint32_t sector = 0;
+    uint32_t sequence = 0;
+    for (uint32_t s=0; s<flash->sector_count; s++) {
+      if (read_sector_header(flash, s, &header) && header.sequence > last &&
+          (!found || header.sequence < sequence)) {
+        found = true;
+        sector = s;
+        sequence = header.sequence;
+      }
+    }
+    if (!found) {
+      return count;
+    }
+    last = sequence;
+    int size;
+    uint32_t offset = SECTOR_HEADER_SIZE;
+    while ((size = read_record(flash, sector, offset, payload, &length)) > 0) {
+      visit((ulog_level_t)payload[0], (const char *)&payload[1], length - 1, arg);
+      offset += size;
+      count++;
+    }
+  }
+}
+
+ulog_err_t ulog_flash_wear(const ulog_flash_driver_t *flash, uint32_t *min, uint32_t *max) {
+  sector_header_t header;
+
+  *min = UINT32_MAX;
+  *max = 0;
+  for (uint32_t sector=0; sector<flash->sector_count; sector++) {
+    uint32_t count = read_sector_header(flash, sector, &header) ? header.erase_count : 0;
+    *min = (count < *min) ? count : *min;
+    *max = (count > *max) ? count : *max;
+  }
+  return ULOG_ERR_NONE;
+}
+
+void ulog_flash_stats(ulog_flash_stats_t *stats) {
+  *stats = ulog_flash.stats;
+}
+
+#endif  // #if (ULOG_ENABLED == 1) && (ULOG_FLASH_SINK == 1)
@@ -0,0 +1,107 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_flash.h
+ *
+ * \brief a uLog subscriber that keeps the latest messages in flash
+ *
+ * ulog_flash_logger() appends each message as a record to a ring of erase
+ * sectors, reached through a ulog_flash_driver_t.  When the current sector is
+ * full, the oldest one is erased and reused, so every sector is erased once
+ * per turn of the ring and wear stays even.  The retained log is the last
+ * sector_count - 1 to sector_count sectors.
+ *
+ * Every sector starts with a header holding its sequence number and erase
+ * count.  Each record carries its length twice and a CRC-32 and is written
+ * with one driver call.  A record or sector header torn by a power failure
+ * fails its checks; readers stop at it, and ulog_flash_open() resumes in a
+ * fresh sector.  ulog_flash_replay() hands the surviving messages over
+ * oldest first.
+ */
+
+#ifndef ULOG_FLASH_H_
+#define ULOG_FLASH_H_
+
+#include "ulog.h"
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+// the flash, as the board support package provides it.  Addresses are
+// offsets from the start of the log area.  write() only clears bits, as NOR
+// flash programming does; erase() sets a whole sector to 0xff.
+typedef struct {
+  ulog_err_t (*read)(void *ctx, uint32_t address, void *data, uint32_t len);
+  ulog_err_t (*write)(void *ctx, uint32_t address, const void *data, uint32_t len);
+  ulog_err_t (*erase)(void *ctx, uint32_t sector);
+  void *ctx;
+  uint32_t sector_size;
+  uint32_t sector_count;    // at least 2
+} ulog_flash_driver_t;
+
+typedef struct {
+  uint32_t records;         // messages written since ulog_flash_open()
+  uint32_t bytes;           // bytes written, headers and padding included
+  uint32_t erases;          // sectors erased
+  uint32_t dropped;         // messages lost to driver errors
+} ulog_flash_stats_t;
+
+// called by ulog_flash_replay() for each message, oldest first
+typedef void (*ulog_flash_visit_t)(ulog_level_t severity, const char *msg, int len, void *arg);
+
+/**
+ * @brief: find the newest sector of the log on flash and continue after its
+ * last intact record, or start a new log if there is none.  flash must stay
+ * valid while logging.
+ */
+ulog_err_t ulog_flash_open(const ulog_flash_driver_t *flash);
+
+/**
+ * @brief: the subscriber, for ULOG_SUBSCRIBE().
+ */
+void ulog_flash_logger(ulog_level_t severity, const char *file, int line, char *msg);
+
+/**
+ * @brief: call visit for each intact message on flash, oldest first, and
+ * return their number.  Needs no ulog_flash_open(), so a tool can read a
+ * dump (see tools/ulog-flash.c).
+ */
+int ulog_flash_replay(const ulog_flash_driver_t *flash, ulog_flash_visit_t visit, void *arg);
+
+/**
+ * @brief: the lowest and highest erase count of the sectors.
+ */
+ulog_err_t ulog_flash_wear(const ulog_flash_driver_t *flash, uint32_t *min, uint32_t *max);
+
+/**
+ * @brief: copy the counters into stats.
+ */
+void ulog_flash_stats(ulog_flash_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_FLASH_H_ */
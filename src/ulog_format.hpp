@@ -0,0 +1,572 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_format.hpp
+ *
+ * \brief uLog: {}-style formatting for C++20, header only
+ *
+ *     #include "ulog_format.hpp"
+ *
+ *     ULOG_FMT_INFO("read {} bytes from {} in {:.3f} ms", n, path, elapsed);
+ *     ULOG_FMT_DEBUG("flags {:#06x} |{:<8}|{:>8}|{:^8}|", flags, "l", "r", "c");
+ *
+ * The format string is parsed at compile time (consteval) into a short list
+ * of operations: copy a literal, or format argument n with a given spec.  A
+ * placeholder that does not fit its argument, or a wrong number of
+ * arguments, fails the build.  At run time the operations are replayed
+ * straight into uLog's message buffer: nothing is allocated and no locale is
+ * consulted.
+ *
+ * The spec follows std::format: {[:[[fill]align][sign][#][0][width][.precision][type]]}
+ * without positional or nested arguments.  Supported types are integers
+ * (d x X b B o c), floating point (f F e E g G a A; none means the shortest
+ * representation that reads back the same), strings and string views (s),
+ * bool, characters and pointers (p).  Other types are formatted by
+ * specializing ulog::formatter<T>:
+ *
+ *     template <> struct ulog::formatter<point> {
+ *       static void format(ulog::writer &out, const point &p, const ulog::format_spec &spec) {
+ *         ulog::format_to(out, spec, p.x);
+ *         out.put(',');
+ *         ulog::format_to(out, spec, p.y);
+ *       }
+ *     };
+ *
+ * bench/ulog_bench_format.cpp compares this path with ulog_message().
+ */
+
+#ifndef ULOG_FORMAT_HPP_
+#define ULOG_FORMAT_HPP_
+
+#include "ulog.hpp"
+#include <cfloat>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace ulog {
+
+using writer = detail::writer;
+
+/**
+ * @brief: a parsed {:...} placeholder.
+ */
+struct format_spec {
+  char fill = ' ';
+  char align = 0;               // '<', '>', '^' or 0 for the type's default
+  char sign = '-';              // '-', '+' or ' '
+  bool alt = false;             // '#'
+  bool zero = false;            // '0'
+  int width = 0;
+  int precision = -1;           // -1: none
+  char type = 0;                // 0: none
+};
+
+/**
+ * @brief: specialize for types that the built-in formatting does not cover.
+ */
+template <typename T, typename Enable = void>
+struct formatter;
+
+template <typename T>
+void format_to(writer &out, const format_spec &spec, const T &value);
+
+namespace detail {
+
+// =============================================================================
+// compile-time parsing
+
+enum class fmt_kind : uint8_t { integer, character, boolean, floating, string, pointer, user };
+
+template <typename T>
+constexpr fmt_kind fmt_kind_of() {
+  using U = std::decay_t<T>;
+  if constexpr (is_lazy_v<U>) {
+    return fmt_kind_of<std::invoke_result_t<const U &>>();
+  } else if constexpr (std::is_same_v<U, bool>) {
+    return fmt_kind::boolean;
+  } else if constexpr (std::is_same_v<U, char>) {
+    return fmt_kind::character;
+  } else if constexpr (std::is_integral_v<U> || std::is_enum_v<U>) {
+    return fmt_kind::integer;
+  } else if constexpr (std::is_floating_point_v<U>) {
+    return fmt_kind::floating;
+  } else if constexpr (std::is_convertible_v<const U &, std::string_view>) {
+    return fmt_kind::string;
+  } else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>) {
+    return fmt_kind::pointer;
+  } else {
+    return fmt_kind::user;
+  }
+}
+
+// Not constexpr: calling it while parsing a format is a compile error that
+// points at the offending check.
+void format_error(const char *reason);
+
+constexpr bool type_allowed(fmt_kind kind, char type) {
+  std::string_view allowed;
+  switch (kind) {
+  case fmt_kind::integer:   allowed = "dxXbBoc"; break;
+  case fmt_kind::character: allowed = "cdxXbBo"; break;
+  case fmt_kind::boolean:   allowed = "sdxXbBo"; break;
+  case fmt_kind::floating:  allowed = "fFeEgGaA"; break;
+  case fmt_kind::string:    allowed = "s"; break;
+  case fmt_kind::pointer:   allowed = "p"; break;
+  case fmt_kind::user:      return true;        // the formatter decides
+  }
+  return type == 0 || allowed.find(type) != std::string_view::npos;
+}
+
+struct fmt_op {
+  uint16_t offset;              // literal: position in the format string
+  uint16_t length;              // literal: length, with {{ and }} still doubled
+  int16_t arg;                  // -1 for a literal
+  bool escaped;                 // literal contains {{ or }}
+  format_spec spec;
+};
+
+// parse the spec after ':' up to the closing '}'
+constexpr format_spec parse_spec(std::string_view text, std::size_t &i) {
+  format_spec spec;
+  auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+  auto digits = [&](int &value) {
+    while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+      value = value * 10 + (text[i++] - '0');
+    }
+  };
+  if (i + 1 < text.size() && is_align(text[i + 1]) && text[i] != '}') {
+    spec.fill = text[i];
+    spec.align = text[i + 1];
+    i += 2;
+  } else if (i < text.size() && is_align(text[i])) {
+    spec.align = text[i++];
+  }
+  if (i < text.size() && (text[i] == '+' || text[i] == '-' || text[i] == ' ')) {
+    spec.sign = text[i++];
+  }
+  if (i < text.size() && text[i] == '#') {
+    spec.alt = true;
+    i++;
+  }
+  if (i < text.size() && text[i] == '0') {
+    spec.zero = true;
+    i++;
+  }
+  digits(spec.width);
+  if (i < text.size() && text[i] == '.') {
+    i++;
+    spec.precision = 0;
+    digits(spec.precision);
+  }
+  if (i < text.size() && text[i] != '}') {
+    spec.type = text[i++];
+  }
+  if (i >= text.size() || text[i] != '}') {
+    format_error("uLog: malformed {} placeholder");
+  }
+  return spec;
+}
+
+}  // namespace detail
+
+/**
+ * @brief: a format string compiled against the argument types Args.
+ *
+ * Built implicitly from a string literal by the ULOG_FMT_xxx() macros.
+ */
+template <typename... Args>
+class format_string {
+ public:
+  static constexpr std::size_t max_ops = 2 * sizeof...(Args) + 1;
+
+  template <std::size_t N>
+  consteval format_string(const char (&fmt)[N]) : text(fmt, N - 1) {
+    constexpr detail::fmt_kind kinds[] = { detail::fmt_kind_of<Args>()..., detail::fmt_kind::user };
+    std::size_t literal_start = 0;
+    std::size_t next_arg = 0;
+    for (std::size_t i = 0; i < text.size(); i++) {
+      if (text[i] == '}') {
+        if (i + 1 >= text.size() || text[i + 1] != '}') {
+          detail::format_error("uLog: unmatched '}' in format string");
+        }
+        i++;
+        continue;
+      }
+      if (text[i] != '{') {
+        continue;
+      }
+      if (i + 1 < text.size() && text[i + 1] == '{') {
+        i++;
+        continue;
+      }
+      add_literal(literal_start, i);
+      i++;
+      format_spec spec;
+      if (i < text.size() && text[i] == ':') {
+        i++;
+        spec = detail::parse_spec(text, i);
+      } else if (i >= text.size() || text[i] != '}') {
+        detail::format_error("uLog: positional and named arguments are not supported");
+      }
+      if (next_arg == sizeof...(Args)) {
+        detail::format_error("uLog: the format string needs more arguments");
+      }
+      if (!detail::type_allowed(kinds[next_arg], spec.type)) {
+        detail::format_error("uLog: a {:type} does not fit its argument");
+      }
+      ops[count++] = detail::fmt_op{0, 0, static_cast<int16_t>(next_arg++), false, spec};
+      literal_start = i + 1;
+    }
+    add_literal(literal_start, text.size());
+    if (next_arg != sizeof...(Args)) {
+      detail::format_error("uLog: more arguments than the format string uses");
+    }
+  }
+
+  std::string_view text;
+  detail::fmt_op ops[max_ops] = {};
+  std::size_t count = 0;
+
+ private:
+  consteval void add_literal(std::size_t start, std::size_t end) {
+    if (end > start) {
+      std::string_view literal = text.substr(start, end - start);
+      bool escaped = literal.find_first_of("{}") != std::string_view::npos;
+      ops[count++] = detail::fmt_op{static_cast<uint16_t>(start),
+                                    static_cast<uint16_t>(end - start), -1, escaped, {}};
+    }
+  }
+};
+
+namespace detail {
+
+// =============================================================================
+// run-time formatting
+
+inline void put(writer &out, std::string_view s) {
+  out.put(s.data(), static_cast<int>(s.size()));
+}
+
+// pad body (after prefix) to spec.width
+inline void write_aligned(writer &out, const format_spec &spec, char default_align,
+                          std::string_view prefix, std::string_view body) {
+  int len = static_cast<int>(prefix.size() + body.size());
+  if (spec.width <= len) {
+    if (!prefix.empty()) {
+      put(out, prefix);
+    }
+    put(out, body);
+    return;
+  }
+  int fill = spec.width - len;
+  char align = spec.align ? spec.align : default_align;
+  if (spec.zero && !spec.align) {
+    put(out, prefix);
+    out.pad('0', fill);
+    put(out, body);
+    return;
+  }
+  int before = (align == '>') ? fill : (align == '^') ? fill / 2 : 0;
+  out.pad(spec.fill, before);
+  put(out, prefix);
+  put(out, body);
+  out.pad(spec.fill, fill - before);
+}
+
+// "00" "01" ... "99", to convert two decimal digits per division
+inline constexpr char digit_pairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+inline void write_unsigned(writer &out, const format_spec &spec, bool negative,
+                           unsigned long long value) {
+  char digits[64];
+  char prefix[4];
+  int prefix_len = 0;
+  int base = 10;
+  bool upper = false;
+  switch (spec.type) {
+  case 'x': base = 16; break;
+  case 'X': base = 16; upper = true; break;
+  case 'b': base = 2; break;
+  case 'B': base = 2; upper = true; break;
+  case 'o': base = 8; break;
+  }
+  if (negative) {
+    prefix[prefix_len++] = '-';
+  } else if (spec.sign != '-') {
+    prefix[prefix_len++] = spec.sign;
+  }
+  if (spec.alt && base != 10) {
+    prefix[prefix_len++] = '0';
+    if (base != 8) {
+      prefix[prefix_len++] = (base == 16) ? (upper ? 'X' : 'x') : (upper ? 'B' : 'b');
+    }
+  }
+  const char *hex = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  int n = sizeof(digits);
+  if (base == 10) {
+    while (value >= 100) {
+      const char *pair = &digit_pairs[2 * (value % 100)];
+      value /= 100;
+      digits[--n] = pair[1];
+      digits[--n] = pair[0];
+    }
+    if (value >= 10) {
+      digits[--n] = digit_pairs[2 * value + 1];
+      digits[--n] = digit_pairs[2 * value];
+    } else {
+      digits[--n] = static_cast<char>('0' + value);
+    }
+  } else {
+    int shift = (base == 16) ? 4 : (base == 8) ? 3 : 1;
+    do {
+      digits[--n] = hex[value & (base - 1)];
+      value >>= shift;
+    } while (value != 0);
+  }
+  write_aligned(out, spec, '>', std::string_view(prefix, prefix_len),
+                std::string_view(&digits[n], sizeof(digits) - n));
+}
+
+template <typename T>
+void write_integer(writer &out, const format_spec &spec, T value) {
+  if (spec.type == 'c') {
+    char c = static_cast<char>(value);
+    write_aligned(out, spec, '<', {}, std::string_view(&c, 1));
+  } else if constexpr (std::is_signed_v<T>) {
+    bool negative = value < 0;
+    unsigned long long magnitude = negative ?
+      0ULL - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+    write_unsigned(out, spec, negative, magnitude);
+  } else {
+    write_unsigned(out, spec, false, value);
+  }
+}
+
+// precisions above this are cut to it
+constexpr int max_float_precision = 100;
+
+inline void write_floating(writer &out, const format_spec &spec, double value) {
+  // room for the longest fixed notation: every digit of DBL_MAX, the point
+  // and the precision
+  char text[DBL_MAX_10_EXP + 2 + max_float_precision];
+  std::to_chars_result result;
+  char *end = text + sizeof(text);
+  bool upper = (spec.type >= 'A' && spec.type <= 'Z');
+  char *start = text;
+  bool negative = std::signbit(value);
+  if (negative) {
+    value = -value;
+  }
+  int precision = (spec.precision < max_float_precision) ? spec.precision : max_float_precision;
+  switch (spec.type) {
+  case 'f': case 'F':
+    result = std::to_chars(start, end, value, std::chars_format::fixed,
+                           precision < 0 ? 6 : precision);
+    break;
+  case 'e': case 'E':
+    result = std::to_chars(start, end, value, std::chars_format::scientific,
+                           precision < 0 ? 6 : precision);
+    break;
+  case 'g': case 'G':
+    result = std::to_chars(start, end, value, std::chars_format::general,
+                           precision < 0 ? 6 : precision);
+    break;
+  case 'a': case 'A':
+    result = (precision < 0) ?
+      std::to_chars(start, end, value, std::chars_format::hex) :
+      std::to_chars(start, end, value, std::chars_format::hex, precision);
+    break;
+  default:
+    result = (precision < 0) ?
+      std::to_chars(start, end, value) :
+      std::to_chars(start, end, value, std::chars_format::general, precision);
+    break;
+  }
+  if (result.ec != std::errc()) {
+    // cannot happen with text sized as above, but never drop the value
+    result = std::to_chars(start, end, value, std::chars_format::scientific);
+  }
+  if (upper) {
+    for (char *p = start; p < result.ptr; p++) {
+      if (*p >= 'a' && *p <= 'z') {
+        *p = *p - 'a' + 'A';
+      }
+    }
+  }
+  char sign[1] = { negative ? '-' : spec.sign };
+  bool has_sign = negative || spec.sign != '-';
+  write_aligned(out, spec, '>', std::string_view(sign, has_sign ? 1 : 0),
+                std::string_view(start, result.ptr - start));
+}
+
+inline void write_string(writer &out, const format_spec &spec, std::string_view s) {
+  if (spec.precision >= 0 && s.size() > static_cast<std::size_t>(spec.precision)) {
+    s = s.substr(0, spec.precision);
+  }
+  format_spec plain = spec;
+  plain.zero = false;
+  write_aligned(out, plain, '<', {}, s);
+}
+
+// one captured argument: its address and how to format it
+struct fmt_arg {
+  const void *value;
+  void (*format)(writer &out, const void *value, const format_spec &spec);
+};
+
+// render_fmt() only runs once uLog decided to log the message, so lazy
+// arguments are called here, once per field that uses them.
+template <typename T>
+void format_erased(writer &out, const void *value, const format_spec &spec) {
+  format_to(out, spec, evaluate(*static_cast<const T *>(value)));
+}
+
+struct fmt_message {
+  std::string_view text;
+  const fmt_op *ops;
+  std::size_t count;
+  const fmt_arg *args;
+};
+
+// copy a literal, collapsing {{ and }}
+inline void write_literal(writer &out, std::string_view literal) {
+  std::size_t start = 0;
+  for (std::size_t i = 0; i < literal.size(); i++) {
+    if (literal[i] == '{' || literal[i] == '}') {
+      out.put(&literal[start], static_cast<int>(i + 1 - start));
+      start = ++i + 1;          // skip the second brace
+    }
+  }
+  if (start < literal.size()) {
+    out.put(&literal[start], static_cast<int>(literal.size() - start));
+  }
+}
+
+// ulog_render_t for messages logged by ulog::fmt_log()
+inline int render_fmt(char *buf, int size, void *ctx) {
+  const fmt_message &msg = *static_cast<const fmt_message *>(ctx);
+  writer out{buf, size, 0};
+  for (std::size_t i = 0; i < msg.count; i++) {
+    const fmt_op &op = msg.ops[i];
+    if (op.arg < 0 && !op.escaped) {
+      out.put(&msg.text[op.offset], op.length);
+    } else if (op.arg < 0) {
+      write_literal(out, msg.text.substr(op.offset, op.length));
+    } else {
+      const fmt_arg &arg = msg.args[op.arg];
+      arg.format(out, arg.value, op.spec);
+    }
+  }
+  return out.finish();
+}
+
+}  // namespace detail
+
+/**
+ * @brief: format value into out according to spec.  For use in formatter
+ * specializations.
+ */
+template <typename T>
+void format_to(writer &out, const format_spec &spec, const T &value) {
+  using U = std::decay_t<T>;
+  constexpr detail::fmt_kind kind = detail::fmt_kind_of<U>();
+  if constexpr (kind == detail::fmt_kind::user) {
+    formatter<U>::format(out, value, spec);
+  } else if constexpr (kind == detail::fmt_kind::boolean) {
+    if (spec.type == 0 || spec.type == 's') {
+      detail::write_string(out, spec, value ? "true" : "false");
+    } else {
+      detail::write_integer(out, spec, static_cast<unsigned>(value));
+    }
+  } else if constexpr (kind == detail::fmt_kind::character) {
+    format_spec as_char = spec;
+    if (spec.type == 0) {
+      as_char.type = 'c';
+    }
+    detail::write_integer(out, as_char, value);
+  } else if constexpr (std::is_enum_v<U>) {
+    detail::write_integer(out, spec, static_cast<std::underlying_type_t<U>>(value));
+  } else if constexpr (kind == detail::fmt_kind::integer) {
+    detail::write_integer(out, spec, value);
+  } else if constexpr (kind == detail::fmt_kind::floating) {
+    detail::write_floating(out, spec, static_cast<double>(value));
+  } else if constexpr (kind == detail::fmt_kind::string) {
+    if constexpr (std::is_pointer_v<T>) {
+      detail::write_string(out, spec, value ? std::string_view(value) : std::string_view("(null)"));
+    } else {
+      detail::write_string(out, spec, std::string_view(value));
+    }
+  } else {
+    format_spec hex = spec;
+    hex.type = 'x';
+    hex.alt = true;
+    detail::write_unsigned(out, hex, false, reinterpret_cast<std::uintptr_t>(value));
+  }
+}
+
+/**
+ * @brief: log a message in {} style.  Called by the ULOG_FMT_xxx() macros.
+ */
+template <typename... Args>
+void fmt_log(ulog_site_t *site, ulog_level_t level, const char *file, int line,
+             format_string<std::type_identity_t<Args>...> fmt, const Args &... args) {
+  const detail::fmt_arg captured[sizeof...(Args) + 1] = {
+    detail::fmt_arg{&args, &detail::format_erased<Args>}..., detail::fmt_arg{}
+  };
+  detail::fmt_message msg{fmt.text, fmt.ops, fmt.count, captured};
+  ulog_render_message(site, level, file, line, fmt.text.data(), detail::render_fmt, &msg);
+}
+
+}  // namespace ulog
+
+#if (ULOG_ENABLED == 1)
+  #define ULOG_FMT_AT_(level, ...) do {                                         \
+    if constexpr (ULOG_CXX_WANTED_(level)) {                                  \
+      if (ULOG_UNLIKELY_(level, ulog_wants(level))) {                         \
+        [&]() ULOG_COLD {                                                     \
+          ULOG_CXX_SITE_(level);                                              \
+          ::ulog::fmt_log(ulog_site_ptr_, level, ULOG_FILE, __LINE__, __VA_ARGS__); \
+        }();                                                                  \
+      }                                                                       \
+    }                                                                         \
+  } while (0)
+#else
+  #define ULOG_FMT_AT_(level, ...) do { } while (0)
+#endif
+
+#define ULOG_FMT_TRACE(...) ULOG_FMT_AT_(ULOG_TRACE_LEVEL, __VA_ARGS__)
+#define ULOG_FMT_DEBUG(...) ULOG_FMT_AT_(ULOG_DEBUG_LEVEL, __VA_ARGS__)
+#define ULOG_FMT_INFO(...) ULOG_FMT_AT_(ULOG_INFO_LEVEL, __VA_ARGS__)
+#define ULOG_FMT_WARNING(...) ULOG_FMT_AT_(ULOG_WARNING_LEVEL, __VA_ARGS__)
+#define ULOG_FMT_ERROR(...) ULOG_FMT_AT_(ULOG_ERROR_LEVEL, __VA_ARGS__)
+#define ULOG_FMT_CRITICAL(...) ULOG_FMT_AT_(ULOG_CRITICAL_LEVEL, __VA_ARGS__)
+
+#endif /* ULOG_FORMAT_HPP_ */
@@ -0,0 +1,267 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_printf.c
+ *
+ * \brief a small vsnprintf() without floating point, for ULOG_TINY_PRINTF
+ *
+ * See ulog_printf.h.
+ */
+
+#include "ulog_printf.h"
+#include "ulog_config.h"
+
+#if (ULOG_ENABLED == 1) && (ULOG_TINY_PRINTF == 1)  // whole file...
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// local types and definitions
+
+// integer sizes, in the order of the lengths that ask for them
+enum { SIZE_CHAR, SIZE_SHORT, SIZE_INT, SIZE_LONG, SIZE_LONG_LONG };
+
+#if (ULOG_PRINTF_LONG_LONG == 1)
+typedef unsigned long long value_t;
+#else
+typedef unsigned long value_t;
+#endif
+
+// append c to buf as snprintf() would
+#define EMIT(c) do {                                                          \
+    if (out < size - 1) {                                                     \
+      buf[out] = (c);                                                         \
+    }                                                                         \
+    out++;                                                                    \
+  } while (0)
+
+// the size class of a type given to %z, %t or %j
+#define SIZE_OF(type) ((sizeof(type) > sizeof(long)) ? SIZE_LONG_LONG :       \
+                       (sizeof(type) > sizeof(int)) ? SIZE_LONG : SIZE_INT)
+
+// =============================================================================
+// user-visible code
+
+int ulog_vsnprintf(char *buf, int size, const char *fmt, va_list ap) {
+  char digits[24];
+  int out = 0;
+
+  for (; *fmt != '\0'; fmt++) {
+    if (*fmt != '%') {
+      EMIT(*fmt);
+      continue;
+    }
+    fmt++;
+
+    bool left = false;
+    char pad = ' ';
+    for (;; fmt++) {
+      if (*fmt == '-') {
+        left = true;
+      } else if (*fmt == '0') {
+        pad = '0';
+      } else if (*fmt != '+' && *fmt != ' ' && *fmt != '#') {
+        break;
+      }
+    }
+    if (left) {
+      pad = ' ';                // 0 pads on the left only
+    }
+    int width = 0;
+    if (*fmt == '*') {
+      width = va_arg(ap, int);
+      if (width < 0) {
+        left = true;
+        pad = ' ';
+        width = -width;
+      }
+      fmt++;
+    }
+    while (*fmt >= '0' && *fmt <= '9') {
+      width = width * 10 + (*fmt++ - '0');
+    }
+    int precision = -1;
+    if (*fmt == '.') {
+      fmt++;
+      precision = 0;
+      if (*fmt == '*') {
+        precision = va_arg(ap, int);
+        fmt++;
+      }
+      while (*fmt >= '0' && *fmt <= '9') {
+        precision = precision * 10 + (*fmt++ - '0');
+      }
+    }
+    int length = SIZE_INT;
+    for (;; fmt++) {
+      if (*fmt == 'l') {
+        length++;
+      } else if (*fmt == 'h') {
+        length--;
+      } else if (*fmt == 'z') {
+        length = SIZE_OF(size_t);
+      } else if (*fmt == 't') {
+        length = SIZE_OF(ptrdiff_t);
+      } else if (*fmt == 'j') {
+        length = SIZE_OF(intmax_t);
+      } else {
+        break;
+      }
+    }
+
+    // the converted text, in digits unless it is a %s argument
+    char *end = &digits[sizeof(digits)];
+    const char *text = end;
+    int len = 0;
+    bool negative = false;
+    value_t value = 0;
+    unsigned base = 0;
+
+    switch (*fmt) {
+    case 'd': case 'i':
+      if (length <= SIZE_INT) {
+        int v = va_arg(ap, int);  // hh and h arguments arrive as int
+        if (length == SIZE_CHAR) {
+          v = (signed char)v;
+        } else if (length == SIZE_SHORT) {
+          v = (short)v;
+        }
+        negative = v < 0;
+        value = negative ? 0 - (value_t)v : (value_t)v;
+      } else if (length == SIZE_LONG) {
+        long v = va_arg(ap, long);
+        negative = v < 0;
+        value = negative ? 0 - (value_t)v : (value_t)v;
+      } else {
+        long long v = va_arg(ap, long long);
+#if (ULOG_PRINTF_LONG_LONG == 1)
+        negative = v < 0;
+        value = negative ? 0 - (value_t)v : (value_t)v;
+#else
+        (void)v;
+        base = 1;
+#endif
+      }
+      base += 10;
+      break;
+    case 'u': case 'x': case 'X': case 'p':
+      if (*fmt == 'p') {
+        value = (value_t)(uintptr_t)va_arg(ap, void *);
+      } else if (length <= SIZE_INT) {
+        unsigned int v = va_arg(ap, unsigned int);
+        if (length == SIZE_CHAR) {
+          v = (unsigned char)v;
+        } else if (length == SIZE_SHORT) {
+          v = (unsigned short)v;
+        }
+        value = v;
+      } else if (length == SIZE_LONG) {
+        value = va_arg(ap, unsigned long);
+      } else {
+        unsigned long long v = va_arg(ap, unsigned long long);
+#if (ULOG_PRINTF_LONG_LONG == 1)
+        value = v;
+#else
+        (void)v;
+        base = 1;
+#endif
+      }
+      base += (*fmt == 'u') ? 10 : 16;
+      break;
+    case 'c':
+      *--end = (char)va_arg(ap, int);
+      break;
+    case 's':
+      text = va_arg(ap, const char *);
+      if (text == NULL) {
+        text = "(null)";
+      }
+      while (text[len] != '\0' && (precision < 0 || len < precision)) {
+        len++;
+      }
+      break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+      (void)va_arg(ap, double);
+      *--end = '?';
+      break;
+    case '\0':
+      fmt--;                    // a lone % at the end
+      continue;
+    default:
+      *--end = *fmt;            // %% and unknown conversions print themselves
+      break;
+    }
+
+    if (base == 10 || base == 16) {
+      const char *hex = (*fmt == 'X') ? "0123456789ABCDEF" : "0123456789abcdef";
+      do {
+        *--end = hex[value % base];
+        value /= base;
+      } while (value != 0);
+      if (*fmt == 'p') {
+        *--end = 'x';
+        *--end = '0';
+      }
+    } else if (base != 0) {
+      *--end = '?';             // 64-bit conversion without ULOG_PRINTF_LONG_LONG
+    }
+    if (text == &digits[sizeof(digits)]) {
+      text = end;
+      len = (int)(&digits[sizeof(digits)] - end);
+    }
+
+    int fill = width - len - negative;
+    if (negative && pad == '0') {
+      EMIT('-');
+    }
+    while (!left && fill-- > 0) {
+      EMIT(pad);
+    }
+    if (negative && pad != '0') {
+      EMIT('-');
+    }
+    for (int i=0; i<len; i++) {
+      EMIT(text[i]);
+    }
+    while (left && fill-- > 0) {
+      EMIT(' ');
+    }
+  }
+  if (size > 0) {
+    buf[(out < size) ? out : size - 1] = '\0';
+  }
+  return out;
+}
+
+int ulog_snprintf(char *buf, int size, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = ulog_vsnprintf(buf, size, fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+#endif  // #if (ULOG_ENABLED == 1) && (ULOG_TINY_PRINTF == 1)
@@ -0,0 +1,64 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_printf.h
+ *
+ * \brief a small vsnprintf() without floating point, for ULOG_TINY_PRINTF
+ *
+ * Conversions: %d %i %u %x %X %s %c %p and %%, with the flags - and 0, a
+ * width, a precision for %s, and the lengths hh h l ll z t j.  Widths and
+ * precisions may be *.  %e %f %g and %a take their double but print "?".
+ *
+ * ulog_vsnprintf() calls no other function, does not recurse and keeps a
+ * fixed 24 byte digit buffer, so its stack use is one small frame (see
+ * bench/ulog_bench_printf.c).  With ULOG_PRINTF_LONG_LONG at 0, %lld and
+ * the other 64-bit conversions print "?" too, and no 64-bit division is
+ * linked on 32-bit targets.
+ */
+
+#ifndef ULOG_PRINTF_H_
+#define ULOG_PRINTF_H_
+
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+/**
+ * @brief: like vsnprintf(): write at most size characters including a NUL,
+ * and return the length the whole text would have.
+ */
+int ulog_vsnprintf(char *buf, int size, const char *fmt, va_list ap);
+
+/**
+ * @brief: like snprintf(), see ulog_vsnprintf().
+ */
+int ulog_snprintf(char *buf, int size, const char *fmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_PRINTF_H_ */
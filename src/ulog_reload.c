@@ -0,0 +1,338 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_reload.c
+ *
+ * \brief reload the uLog configuration when a file changes (Linux only)
+ *
+ * See ulog_reload.h.  Link with -lpthread.
+ */
+
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "ulog_reload.h"
+#include "ulog_config.h"
+
+#if (ULOG_ENABLED == 1) && (ULOG_HOT_RELOAD == 1)  // whole file...
+
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// =============================================================================
+// types and definitions
+
+// A parsed configuration file.  update comes first so that the pointer
+// handed back by ulog_update_publish() is also the snapshot to free.
+typedef struct {
+  ulog_update_t update;
+  char *text;               // the file, split into tokens.  rules point into it.
+  ulog_site_rule_t *rules;
+  ulog_site_setting_t *settings;
+} snapshot_t;
+
+// =============================================================================
+// local storage
+
+static struct {
+  char path[PATH_MAX];
+  const char *name;         // file name part of path
+  ulog_sink_option_t sink_fn;
+  ulog_print_t error_fn;
+  int inotify_fd;
+  int stop_fds[2];          // pipe written by ulog_reload_close()
+  pthread_t thread;
+  bool running;
+} ulog_reload;
+
+// =============================================================================
+// local functions
+
+static void *watch(void *arg);
+static ulog_err_t reload();
+static snapshot_t *parse(char *text);
+static void settle(snapshot_t *snapshot);
+static void free_snapshot(ulog_update_t *update);
+
+// =============================================================================
+// user-visible code
+
+ulog_err_t ulog_reload_open(const char *path,
+                            ulog_sink_option_t sink_fn,
+                            ulog_print_t error_fn) {
+  char dir[PATH_MAX];
+
+  snprintf(ulog_reload.path, sizeof(ulog_reload.path), "%s", path);
+  char *slash = strrchr(ulog_reload.path, '/');
+  ulog_reload.name = (slash != NULL) ? slash + 1 : ulog_reload.path;
+  ulog_reload.sink_fn = sink_fn;
+  ulog_reload.error_fn = error_fn;
+  if (reload() != ULOG_ERR_NONE) {
+    return ULOG_ERR_SYSTEM;
+  }
+
+  // Watch the directory rather than the file: editors and deployment tools
+  // usually replace the file with a rename, which ends a watch on the file.
+  if (slash == NULL) {
+    snprintf(dir, sizeof(dir), ".");
+  } else {
+    snprintf(dir, sizeof(dir), "%.*s", (int)(slash - ulog_reload.path), ulog_reload.path);
+  }
+  ulog_reload.inotify_fd = inotify_init1(IN_CLOEXEC);
+  if (ulog_reload.inotify_fd < 0) {
+    return ULOG_ERR_SYSTEM;
+  }
+  if (inotify_add_watch(ulog_reload.inotify_fd, dir,
+                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+      pipe(ulog_reload.stop_fds) != 0) {
+    close(ulog_reload.inotify_fd);
+    return ULOG_ERR_SYSTEM;
+  }
+  if (pthread_create(&ulog_reload.thread, NULL, watch, NULL) != 0) {
+    close(ulog_reload.inotify_fd);
+    close(ulog_reload.stop_fds[0]);
+    close(ulog_reload.stop_fds[1]);
+    return ULOG_ERR_SYSTEM;
+  }
+  ulog_reload.running = true;
+  return ULOG_ERR_NONE;
+}
+
+void ulog_reload_close() {
+  if (!ulog_reload.running) {
+    return;
+  }
+  ulog_reload.running = false;
+  if (write(ulog_reload.stop_fds[1], "", 1) != 1) {
+    pthread_cancel(ulog_reload.thread);
+  }
+  pthread_join(ulog_reload.thread, NULL);
+  close(ulog_reload.inotify_fd);
+  close(ulog_reload.stop_fds[0]);
+  close(ulog_reload.stop_fds[1]);
+}
+
+// =============================================================================
+// private code
+
+static void *watch(void *arg) {
+  char events[sizeof(struct inotify_event) + NAME_MAX + 1]
+    __attribute__((aligned(__alignof__(struct inotify_event))));
+  struct pollfd fds[2] = {
+    { .fd = ulog_reload.inotify_fd, .events = POLLIN },
+    { .fd = ulog_reload.stop_fds[0], .events = POLLIN },
+  };
+  (void)arg;
+
+  for (;;) {
+    if (poll(fds, 2, -1) < 0 || fds[1].revents != 0) {
+      return NULL;
+    }
+    ssize_t n = read(ulog_reload.inotify_fd, events, sizeof(events));
+    bool changed = false;
+    for (char *p = events; n > 0 && p < events + n; ) {
+      struct inotify_event *event = (struct inotify_event *)p;
+      if (event->len > 0 && strcmp(event->name, ulog_reload.name) == 0) {
+        changed = true;
+      }
+      p += sizeof(struct inotify_event) + event->len;
+    }
+    if (changed) {
+      reload();
+    }
+  }
+}
+
+// read, parse and publish the file
+static ulog_err_t reload() {
+  FILE *file = fopen(ulog_reload.path, "r");
+  if (file == NULL) {
+    return ULOG_ERR_SYSTEM;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *text = (size >= 0) ? malloc(size + 1) : NULL;
+  if (text == NULL) {
+    fclose(file);
+    return ULOG_ERR_SYSTEM;
+  }
+  size = fread(text, 1, size, file);
+  text[size] = '\0';
+  fclose(file);
+
+  snapshot_t *snapshot = parse(text);
+  if (snapshot == NULL) {
+    free(text);
+    return ULOG_ERR_SYSTEM;
+  }
+  settle(snapshot);
+  free_snapshot(ulog_update_publish(&snapshot->update));
+  return ULOG_ERR_NONE;
+}
+
+// match the rules against the call sites here, so that the thread applying
+// the update only copies the results
+static void settle(snapshot_t *snapshot) {
+  int capacity = 0;
+  int count;
+  while ((count = ulog_update_settle(&snapshot->update, snapshot->settings, capacity)) > capacity) {
+    capacity = count + 16;    // and room for the sites registered meanwhile
+    free(snapshot->settings);
+    snapshot->settings = malloc(capacity * sizeof(ulog_site_setting_t));
+    if (snapshot->settings == NULL) {
+      return;               // the rules are matched when the update is applied
+    }
+  }
+}
+
+static void report(int line_number, const char *reason) {
+  char line[PATH_MAX + 64];
+  if (ulog_reload.error_fn != NULL) {
+    snprintf(line, sizeof(line), "%s:%d: %s", ulog_reload.path, line_number, reason);
+    ulog_reload.error_fn(line);
+  }
+}
+
+// split "file:line" into its parts.  No ":line" means every line.
+static const char *parse_location(char *location, int *line) {
+  char *colon = strrchr(location, ':');
+  *line = 0;
+  if (colon != NULL) {
+    *colon = '\0';
+    *line = atoi(colon + 1);
+  }
+  return location;
+}
+
+static snapshot_t *parse(char *text) {
+  int max_rules = 1;
+  for (const char *p = text; *p; p++) {
+    max_rules += (*p == '\n');
+  }
+  snapshot_t *snapshot = calloc(1, sizeof(snapshot_t));
+  ulog_site_rule_t *rules = calloc(max_rules, sizeof(ulog_site_rule_t));
+  if (snapshot == NULL || rules == NULL) {
+    free(snapshot);
+    free(rules);
+    return NULL;
+  }
+  ulog_update_t *update = &snapshot->update;
+  snapshot->text = text;
+  snapshot->rules = rules;
+  update->rules = rules;
+  update->quiet = 0;
+  update->rate_limit = 0;
+  for (int i=0; i<ULOG_MAX_SUBSCRIBERS; i++) {
+    update->thresholds[i] = ULOG_LEVEL_N;
+  }
+
+  char *next_line;
+  int line_number = 0;
+  for (char *line = text; line != NULL; line = next_line) {
+    char *save;
+    line_number++;
+    next_line = strchr(line, '\n');
+    if (next_line != NULL) {
+      *next_line++ = '\0';
+    }
+    line[strcspn(line, "#\r")] = '\0';
+    char *verb = strtok_r(line, " \t", &save);
+    char *arg1 = strtok_r(NULL, " \t", &save);
+    char *arg2 = strtok_r(NULL, " \t", &save);
+    char *arg3 = strtok_r(NULL, " \t", &save);
+    ulog_site_rule_t *rule = &rules[update->rule_count];
+
+    if (verb == NULL) {
+      continue;
+    }
+    rule->min_level = ULOG_LEVEL_N;
+    rule->enable = -1;
+    rule->rate_limit = -1;
+
+    if (strcmp(verb, "subscriber") == 0 && arg2 != NULL) {
+      int slot = atoi(arg1);
+      ulog_level_t level = ulog_level_parse(arg2);
+      if (slot < 0 || slot >= ULOG_MAX_SUBSCRIBERS || level == ULOG_LEVEL_N) {
+        report(line_number, "bad subscriber slot or level");
+      } else {
+        update->thresholds[slot] = level;
+      }
+
+    } else if (strcmp(verb, "module") == 0 && arg2 != NULL) {
+      rule->file = arg1;
+      rule->min_level = ulog_level_parse(arg2);
+      if (rule->min_level == ULOG_LEVEL_N) {
+        report(line_number, "unknown level");
+      } else {
+        update->rule_count++;
+      }
+
+    } else if (strcmp(verb, "site") == 0 && arg2 != NULL) {
+      rule->file = parse_location(arg1, &rule->line);
+      rule->enable = (strcmp(arg2, "on") == 0);
+      update->rule_count++;
+
+    } else if (strcmp(verb, "rate") == 0 && arg2 != NULL) {
+      if (strcmp(arg1, "*") == 0) {
+        update->rate_limit = strtoul(arg2, NULL, 10);
+      } else {
+        rule->file = parse_location(arg1, &rule->line);
+        rule->rate_limit = strtoul(arg2, NULL, 10);
+        update->rule_count++;
+      }
+
+    } else if (strcmp(verb, "quiet") == 0 && arg1 != NULL) {
+      update->quiet = (strcmp(arg1, "on") == 0);
+
+    } else if (strcmp(verb, "sink") == 0 && arg3 != NULL) {
+      if (ulog_reload.sink_fn != NULL) {
+        ulog_reload.sink_fn(arg1, arg2, arg3);
+      }
+
+    } else {
+      report(line_number, "unknown setting or missing argument");
+    }
+  }
+  return snapshot;
+}
+
+static void free_snapshot(ulog_update_t *update) {
+  snapshot_t *snapshot = (snapshot_t *)update;
+  if (snapshot != NULL) {
+    free(snapshot->text);
+    free(snapshot->rules);
+    free(snapshot->settings);
+    free(snapshot);
+  }
+}
+
+#endif  // #if (ULOG_ENABLED == 1) && (ULOG_HOT_RELOAD == 1)
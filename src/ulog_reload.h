@@ -0,0 +1,84 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_reload.h
+ *
+ * \brief reload the uLog configuration when a file changes (Linux only)
+ *
+ * ulog_reload_open() reads the file once, then starts a thread that waits
+ * for inotify events on it.  Every time the file is rewritten or replaced,
+ * the thread parses it into a ulog_update_t and publishes it with
+ * ulog_update_publish().  ulog_message() never waits for the thread.
+ *
+ * The file holds one setting per line.  Blank lines and text after '#' are
+ * ignored:
+ *
+ *     subscriber <slot> <LEVEL>       threshold of the subscriber in slot
+ *     module <file> <LEVEL>           sites in <file> below LEVEL are off
+ *     site <file>[:<line>] on|off     enable or disable call sites
+ *     rate <file>[:<line>] <n>        limit call sites to n messages/s
+ *     rate * <n>                      default limit for every call site
+ *     quiet on|off                    ulog_set_quite()
+ *     sink <name> <key> <value>       passed to the sink_fn callback
+ *
+ * The file describes the whole configuration: a call site no longer named
+ * in it goes back to being on, with the default rate limit.
+ */
+
+#ifndef ULOG_RELOAD_H_
+#define ULOG_RELOAD_H_
+
+#include "ulog.h"
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+/**
+ * @brief: prototype for the function that receives "sink" settings.  It is
+ * called from the watcher thread, never from ulog_message().
+ */
+typedef void (*ulog_sink_option_t)(const char *sink, const char *key, const char *value);
+
+/**
+ * @brief: apply the configuration in path and reload it whenever it changes.
+ *
+ * Returns ULOG_ERR_SYSTEM if the file cannot be read or watched.  sink_fn may
+ * be NULL.  error_fn, which may also be NULL, is told about lines it could
+ * not parse.  Such lines are skipped; the rest of the file still applies.
+ */
+ulog_err_t ulog_reload_open(const char *path,
+                            ulog_sink_option_t sink_fn,
+                            ulog_print_t error_fn);
+
+/**
+ * @brief: stop watching the file.  The last configuration stays in effect.
+ */
+void ulog_reload_close();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_RELOAD_H_ */
@@ -0,0 +1,110 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_shm.c
+ *
+ * \brief uLog statistics published in a shared memory page (POSIX only)
+ *
+ * See ulog_shm.h.  Link with -lrt on older C libraries.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ulog_shm.h"
+#include "ulog_config.h"
+
+#if (ULOG_ENABLED == 1) && (ULOG_SHM_STATS == 1)  // whole file...
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// =============================================================================
+// local storage
+
+static struct {
+  ulog_shm_page_t *page;
+  char name[64];
+} ulog_shm;
+
+// =============================================================================
+// user-visible code
+
+ulog_err_t ulog_shm_open(const char *name) {
+  if (name == NULL) {
+    snprintf(ulog_shm.name, sizeof(ulog_shm.name), "/ulog.%d", (int)getpid());
+  } else {
+    snprintf(ulog_shm.name, sizeof(ulog_shm.name), "%s", name);
+  }
+  int fd = shm_open(ulog_shm.name, O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    return ULOG_ERR_SYSTEM;
+  }
+  if (ftruncate(fd, sizeof(ulog_shm_page_t)) != 0) {
+    close(fd);
+    shm_unlink(ulog_shm.name);
+    return ULOG_ERR_SYSTEM;
+  }
+  ulog_shm_page_t *page = mmap(NULL, sizeof(ulog_shm_page_t),
+                               PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (page == MAP_FAILED) {
+    shm_unlink(ulog_shm.name);
+    return ULOG_ERR_SYSTEM;
+  }
+  memset(page, 0, sizeof(*page));
+  page->version = ULOG_SHM_VERSION;
+  page->size = sizeof(ulog_shm_page_t);
+  page->pid = (uint32_t)getpid();
+  // readers check magic first, so it goes in last
+  __atomic_store_n(&page->magic, ULOG_SHM_MAGIC, __ATOMIC_RELEASE);
+  ulog_shm.page = page;
+  return ULOG_ERR_NONE;
+}
+
+void ulog_shm_close() {
+  ulog_shm_page_t *page = ulog_shm.page;
+  if (page != NULL) {
+    ulog_shm.page = NULL;
+    munmap(page, sizeof(*page));
+    shm_unlink(ulog_shm.name);
+  }
+}
+
+void ulog_shm_write(const ulog_stats_t *stats, uint32_t now_us) {
+  ulog_shm_page_t *page = ulog_shm.page;
+  if (page == NULL) {
+    return;
+  }
+  uint32_t sequence = page->sequence;
+  __atomic_store_n(&page->sequence, sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  page->stats = *stats;
+  page->updated_us = now_us;
+  page->updates++;
+  __atomic_store_n(&page->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+#endif  // #if (ULOG_ENABLED == 1) && (ULOG_SHM_STATS == 1)
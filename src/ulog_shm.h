@@ -0,0 +1,112 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_shm.h
+ *
+ * \brief uLog statistics published in a shared memory page (POSIX only)
+ *
+ * The logging process calls ulog_shm_open() once.  From then on
+ * ulog_message() refreshes the page with ulog_stats() every
+ * ULOG_SHM_INTERVAL_US.  Readers such as tools/ulog-stat.c map the page
+ * read-only and take snapshots with ulog_shm_read(): the writer never waits
+ * for them and they never make a system call after mapping the page.
+ *
+ * The page is versioned with a sequence lock.  The writer makes sequence odd,
+ * updates the page, then makes it even again.  A reader that sees an odd
+ * sequence, or a different one after copying, retries.
+ */
+
+#ifndef ULOG_SHM_H_
+#define ULOG_SHM_H_
+
+#include "ulog.h"
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+#define ULOG_SHM_MAGIC 0x474f4c55     // "ULOG" in a little-endian dump
+#define ULOG_SHM_VERSION 1
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;            // sizeof(ulog_shm_page_t): writer and reader agree
+  uint32_t pid;
+  uint32_t sequence;        // odd while the writer updates the page
+  uint32_t updates;         // number of completed updates
+  uint32_t updated_us;      // writer clock at the last update, 0 if no clock
+  ulog_stats_t stats;
+} ulog_shm_page_t;
+
+/**
+ * @brief: create the shared memory object name (e.g. "/ulog.1234") and start
+ * publishing into it.  A NULL name means "/ulog.<pid>".
+ */
+ulog_err_t ulog_shm_open(const char *name);
+
+/**
+ * @brief: stop publishing and remove the shared memory object.  Call once
+ * no thread is logging any more.
+ */
+void ulog_shm_close();
+
+/**
+ * @brief: copy stats into the page.  Called by ulog_message() with the uLog
+ * lock held, so there is only ever one writer.
+ */
+void ulog_shm_write(const ulog_stats_t *stats, uint32_t now_us);
+
+/**
+ * @brief: copy a consistent snapshot of page into snapshot.
+ *
+ * Returns false if the page is not a uLog page of this layout, or if the
+ * writer kept it busy for too many attempts.
+ */
+static inline bool ulog_shm_read(const ulog_shm_page_t *page, ulog_shm_page_t *snapshot) {
+  if (page->magic != ULOG_SHM_MAGIC ||
+      page->version != ULOG_SHM_VERSION ||
+      page->size != sizeof(ulog_shm_page_t)) {
+    return false;
+  }
+  for (int attempt=0; attempt<1000; attempt++) {
+    uint32_t before = __atomic_load_n(&page->sequence, __ATOMIC_ACQUIRE);
+    if (before & 1) {
+      continue;
+    }
+    memcpy(snapshot, page, sizeof(*snapshot));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&page->sequence, __ATOMIC_RELAXED) == before) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_SHM_H_ */
@@ -0,0 +1,139 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_uart.c
+ *
+ * \brief a uLog subscriber that streams messages to a UART by DMA
+ *
+ * See ulog_uart.h.  buffers[filling] takes new messages.  While sending is
+ * set the other buffer belongs to the DMA; the buffers swap only when a
+ * transfer is started, in the logger or in ulog_uart_tx_done().
+ */
+
+#include "ulog_uart.h"
+#include "ulog_config.h"
+
+#if (ULOG_ENABLED == 1) && (ULOG_UART_SINK == 1)  // whole file...
+
+#include <string.h>
+
+// =============================================================================
+// local storage
+
+static struct {
+  uint8_t buffers[2][ULOG_UART_BUFFER_SIZE];
+  int filling;              // index of the buffer taking messages
+  int length;               // bytes in buffers[filling]
+  bool sending;             // the other buffer is being transmitted
+  ulog_uart_start_t start_fn;
+  ulog_lock_t critical_fn;
+  ulog_uart_stats_t stats;
+} ulog_uart;
+
+// =============================================================================
+// local functions
+
+static void critical(bool enter) {
+  if (ulog_uart.critical_fn != NULL) {
+    ulog_uart.critical_fn(enter);
+  }
+}
+
+// hand buffers[filling] to the DMA and fill the other one.  Called in the
+// critical section; the caller starts the transfer once it has left it.
+static const uint8_t *swap(int *len) {
+  const uint8_t *data = ulog_uart.buffers[ulog_uart.filling];
+  *len = ulog_uart.length;
+  ulog_uart.filling ^= 1;
+  ulog_uart.length = 0;
+  ulog_uart.sending = true;
+  ulog_uart.stats.transfers++;
+  return data;
+}
+
+// =============================================================================
+// user-visible code
+
+void ulog_uart_init(ulog_uart_start_t start_fn, ulog_lock_t critical_fn) {
+  memset(&ulog_uart, 0, sizeof(ulog_uart));
+  ulog_uart.start_fn = start_fn;
+  ulog_uart.critical_fn = critical_fn;
+}
+
+void ulog_uart_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  const char *level = ulog_level_name(severity);
+  int level_len = (int)strlen(level);
+  int msg_len = (int)strlen(msg);
+  int need = level_len + 2 + msg_len + 2;
+  const uint8_t *data = NULL;
+  int len = 0;
+
+  (void)file;
+  (void)line;
+  critical(true);
+  if (ulog_uart.length + need > ULOG_UART_BUFFER_SIZE) {
+    ulog_uart.stats.dropped_messages++;
+    ulog_uart.stats.dropped_bytes += need;
+  } else {
+    uint8_t *p = &ulog_uart.buffers[ulog_uart.filling][ulog_uart.length];
+    memcpy(p, level, level_len);
+    memcpy(&p[level_len], ": ", 2);
+    memcpy(&p[level_len + 2], msg, msg_len);
+    memcpy(&p[need - 2], "\r\n", 2);
+    ulog_uart.length += need;
+    ulog_uart.stats.messages++;
+    ulog_uart.stats.bytes += need;
+    if (!ulog_uart.sending) {
+      data = swap(&len);
+    }
+  }
+  critical(false);
+  if (data != NULL) {
+    ulog_uart.start_fn(data, len);
+  }
+}
+
+void ulog_uart_tx_done() {
+  const uint8_t *data = NULL;
+  int len = 0;
+
+  critical(true);
+  if (ulog_uart.length > 0) {
+    data = swap(&len);
+  } else {
+    ulog_uart.sending = false;
+  }
+  critical(false);
+  if (data != NULL) {
+    ulog_uart.start_fn(data, len);
+  }
+}
+
+void ulog_uart_stats(ulog_uart_stats_t *stats) {
+  critical(true);
+  *stats = ulog_uart.stats;
+  critical(false);
+}
+
+#endif  // #if (ULOG_ENABLED == 1) && (ULOG_UART_SINK == 1)
@@ -0,0 +1,97 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_uart.h
+ *
+ * \brief a uLog subscriber that streams messages to a UART by DMA
+ *
+ * ulog_uart_logger() appends each message, as "LEVEL: text\r\n", to one of
+ * two buffers while the other is being transmitted.  When nothing is being
+ * transmitted it hands the buffer to the start function right away.  The
+ * driver calls ulog_uart_tx_done() from its transfer complete interrupt,
+ * which starts the next buffer if anything was written meanwhile.  The caller
+ * never waits for the UART: a message that does not fit in the free part of
+ * the buffer is dropped whole and counted.
+ *
+ *     static void start(const uint8_t *data, int len) {
+ *       DMA1_Channel4->CMAR = (uint32_t)data;
+ *       DMA1_Channel4->CNDTR = len;
+ *       DMA1_Channel4->CCR |= DMA_CCR_EN;
+ *     }
+ *
+ *     ulog_uart_init(start, irq_lock);
+ *     ULOG_SUBSCRIBE(ulog_uart_logger, ULOG_INFO_LEVEL);
+ *
+ * bench/ulog_bench_uart.c simulates the device with a thread on Linux.
+ */
+
+#ifndef ULOG_UART_H_
+#define ULOG_UART_H_
+
+#include "ulog.h"
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+// start transmitting len bytes at data; must not wait for the end
+typedef void (*ulog_uart_start_t)(const uint8_t *data, int len);
+
+typedef struct {
+  uint32_t messages;        // messages accepted
+  uint32_t bytes;           // bytes accepted
+  uint32_t dropped_messages;  // messages that found the buffer full
+  uint32_t dropped_bytes;
+  uint32_t transfers;       // buffers handed to the start function
+} ulog_uart_stats_t;
+
+/**
+ * @brief: empty the buffers and set the start function.  critical_fn(true)
+ * and critical_fn(false) bracket every access to the buffers shared with
+ * ulog_uart_tx_done(), typically by masking the DMA interrupt.  It may be
+ * NULL if the two never run concurrently.
+ */
+void ulog_uart_init(ulog_uart_start_t start_fn, ulog_lock_t critical_fn);
+
+/**
+ * @brief: the subscriber, for ULOG_SUBSCRIBE().
+ */
+void ulog_uart_logger(ulog_level_t severity, const char *file, int line, char *msg);
+
+/**
+ * @brief: the transfer started last has completed.  Call from the DMA
+ * interrupt.
+ */
+void ulog_uart_tx_done();
+
+/**
+ * @brief: copy the counters into stats.
+ */
+void ulog_uart_stats(ulog_uart_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_UART_H_ */
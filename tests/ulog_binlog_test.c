@@ -0,0 +1,134 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_binlog_test.c
+ *
+ * \brief unit testing for the binary log subscriber.  Build with
+ * -DULOG_BINARY_LOG=1
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ulog.h"
+#include "ulog_binlog.h"
+#include "ulog_test.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if (ULOG_BINARY_LOG == 1)
+
+static void log_item(int i) {
+  ULOG_INFO("item %d", i);
+}
+
+void ulog_binlog_test() {
+  static ulog_binlog_record_t record;
+  char path[] = "/tmp/ulog_binlog_testXXXXXX";
+
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  close(fd);
+  ULOG_INIT();
+  assert(ulog_binlog_open(path) == ULOG_ERR_NONE);
+  assert(ULOG_SUBSCRIBE(ulog_binlog_logger, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+  log_item(1);
+  log_item(2);
+  ULOG_ERROR("other site");
+  ULOG_UNSUBSCRIBE(ulog_binlog_logger);
+  ulog_binlog_close();
+
+  // a chunk record, a site record before the first message of each call
+  // site, then the messages with their site id
+  FILE *file = fopen(path, "rb");
+  assert(file != NULL && ulog_binlog_check(file));
+  assert(ulog_binlog_read(file, &record) == 1 && record.type == ULOG_BINLOG_CHUNK);
+  assert(record.offset == strlen(ULOG_BINLOG_MAGIC));
+  assert(ulog_binlog_read(file, &record) == 1 && record.type == ULOG_BINLOG_SITE);
+  assert(record.site == 1 && strstr(record.text, "ulog_binlog_test.c") != NULL);
+  uint32_t line = record.line;
+
+  assert(ulog_binlog_read(file, &record) == 1 && record.type == ULOG_BINLOG_MESSAGE);
+  assert(record.site == 1 && record.level == ULOG_INFO_LEVEL && record.thread != 0);
+  assert(strcmp(record.text, "item 1") == 0 && record.length == 6);
+  uint64_t first = record.time_us;
+
+  assert(ulog_binlog_read(file, &record) == 1 && record.type == ULOG_BINLOG_MESSAGE);
+  assert(record.site == 1 && strcmp(record.text, "item 2") == 0);
+  assert(record.time_us >= first);
+
+  assert(ulog_binlog_read(file, &record) == 1 && record.type == ULOG_BINLOG_SITE);
+  assert(record.site == 2 && record.line > line);
+  assert(ulog_binlog_read(file, &record) == 1 && record.type == ULOG_BINLOG_MESSAGE);
+  assert(record.site == 2 && record.level == ULOG_ERROR_LEVEL);
+  assert(ulog_binlog_read(file, &record) == 0);
+  fclose(file);
+
+  // past ULOG_BINLOG_CHUNK_SIZE bytes a new chunk starts, at the offset it
+  // records, and repeats the site record of the messages in it
+  assert(ulog_binlog_open(path) == ULOG_ERR_NONE);
+  assert(ULOG_SUBSCRIBE(ulog_binlog_logger, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+  for (int i=0; i<ULOG_BINLOG_CHUNK_SIZE / 16; i++) {
+    log_item(i);
+  }
+  ULOG_UNSUBSCRIBE(ulog_binlog_logger);
+  ulog_binlog_close();
+  file = fopen(path, "rb");
+  assert(file != NULL && ulog_binlog_check(file));
+  int chunks = 0;
+  int sites = 0;
+  long offset = ftell(file);
+  while (ulog_binlog_read(file, &record) == 1) {
+    if (record.type == ULOG_BINLOG_CHUNK) {
+      assert(record.offset == (uint64_t)offset);
+      assert(ulog_binlog_read(file, &record) == 1 && record.type == ULOG_BINLOG_SITE);
+      assert(record.site == 1);
+      chunks++;
+      sites++;
+    } else {
+      assert(record.type == ULOG_BINLOG_MESSAGE && record.site == 1);
+    }
+    offset = ftell(file);
+  }
+  assert(chunks > 1 && sites == chunks);
+  fclose(file);
+
+  // a file cut short in a record reads as damaged
+  file = fopen(path, "r+b");
+  assert(file != NULL);
+  fseek(file, -3, SEEK_END);
+  long cut = ftell(file);
+  assert(ftruncate(fileno(file), cut) == 0);
+  rewind(file);
+  assert(ulog_binlog_check(file));
+  int status;
+  while ((status = ulog_binlog_read(file, &record)) == 1) {
+  }
+  assert(status == -1);
+  fclose(file);
+  unlink(path);
+}
+
+#endif
@@ -0,0 +1,203 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_capture_test.c
+ *
+ * \brief unit testing for the argument capture of deferred messages.
+ * Build with -DULOG_DEFERRED=1 and link src/ulog_capture.c, once as is and
+ * once with -DULOG_FORMAT_CACHE=0, so that both the compiled and the parsed
+ * renderers are covered.
+ */
+
+#include "ulog.h"
+#include "ulog_capture.h"
+#include "ulog_test.h"
+#include <assert.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if (ULOG_ENABLED == 1) && (ULOG_DEFERRED == 1)
+
+// capture the arguments, render them into size bytes and compare with
+// vsnprintf(), twice so that a cached format is used again
+static void expect_same(int size, const char *fmt, ...) {
+  uint8_t record[ULOG_DEFERRED_RECORD_SIZE];
+  char expected[64];
+  char got[64];
+  va_list ap;
+
+  assert(size <= (int)sizeof(got));
+  va_start(ap, fmt);
+  int len = ulog_capture_args(record, sizeof(record), fmt, ap);
+  va_end(ap);
+  assert(len >= 0);
+  va_start(ap, fmt);
+  int n = vsnprintf(expected, size, fmt, ap);
+  va_end(ap);
+  for (int i=0; i<2; i++) {
+    memset(got, '#', sizeof(got));
+    assert(ulog_capture_render(got, size, fmt, record, len) == n);
+    assert(strcmp(got, expected) == 0);
+  }
+}
+
+#define EXPECT_SAME(...) expect_same(64, __VA_ARGS__)
+
+static int pointed_at;
+
+static char delivered[ULOG_MAX_MESSAGE_LENGTH];
+
+static void keep(ulog_level_t severity, const char *file, int line, char *msg) {
+  (void)severity;
+  (void)file;
+  (void)line;
+  strcpy(delivered, msg);
+}
+
+// log one deferred message and deliver it
+#define EXPECT_DEFERRED(text, ...) do {                                       \
+    ULOG_INFO(__VA_ARGS__);                                                   \
+    assert(ulog_deferred_flush() == 1);                                       \
+    assert(strcmp(delivered, text) == 0);                                     \
+  } while (0)
+
+// what ULOG_xxx() delivers once ulog_deferred_flush() runs
+static void deferred_test() {
+  static char changing[] = "kept by reference, then changed";
+  static char tiny[] = "ab";
+  char stack[] = "copied, then changed";
+  char long_text[2 * ULOG_CAPTURE_STRING_MAX + 1];
+  char cut[ULOG_CAPTURE_STRING_MAX + 1];
+
+  ULOG_INIT();
+  assert(ULOG_SUBSCRIBE(keep, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+
+  // literals are found static by ULOG_INIT() and kept by reference
+  assert(ulog_is_static("a literal long enough"));
+  EXPECT_DEFERRED("a literal long enough", "%s", "a literal long enough");
+
+  // so is anything declared static, even if it changes before the flush
+  assert(!ulog_is_static(changing));
+  assert(ulog_static_range(changing, changing + sizeof(changing)) == ULOG_ERR_NONE);
+  ULOG_INFO("%s", changing);
+  changing[0] = 'K';
+  assert(ulog_deferred_flush() == 1);
+  assert(strcmp(delivered, "Kept by reference, then changed") == 0);
+
+  // ... but strings shorter than a pointer are copied anyway
+  assert(ulog_static_range(tiny, tiny + sizeof(tiny)) == ULOG_ERR_NONE);
+  ULOG_INFO("%s", tiny);
+  tiny[0] = 'A';
+  assert(ulog_deferred_flush() == 1);
+  assert(strcmp(delivered, "ab") == 0);
+
+  // other strings are copied when logged
+  ULOG_INFO("%s", stack);
+  stack[0] = 'C';
+  assert(ulog_deferred_flush() == 1);
+  assert(strcmp(delivered, "copied, then changed") == 0);
+
+  // copies are cut to ULOG_CAPTURE_STRING_MAX, or less by the precision
+  memset(long_text, 'x', sizeof(long_text) - 1);
+  long_text[sizeof(long_text) - 1] = '\0';
+  memcpy(cut, long_text, ULOG_CAPTURE_STRING_MAX);
+  cut[ULOG_CAPTURE_STRING_MAX] = '\0';
+  EXPECT_DEFERRED(cut, "%s", long_text);
+  EXPECT_DEFERRED(cut, "%.*s", 2 * ULOG_CAPTURE_STRING_MAX, long_text);
+  EXPECT_DEFERRED("xxx|xxxxx", "%.3s|%.*s", long_text, 5, long_text);
+
+  // NULL prints as snprintf() does
+  EXPECT_DEFERRED("(null) 1", "%s %d", (const char *)NULL, 1);
+
+  // arguments that do not fit in a record are rendered at once instead, so
+  // even the string kept by reference shows what it held at the call
+  char full[sizeof(changing) + 7 * sizeof(stack)];
+  snprintf(full, sizeof(full), "%s %s %s %s %s %s %s %s", changing, stack, stack,
+           stack, stack, stack, stack, stack);
+  ULOG_INFO("%s %s %s %s %s %s %s %s", changing, stack, stack, stack, stack, stack,
+            stack, stack);
+  changing[0] = 'k';
+  assert(ulog_deferred_flush() == 1);
+  assert(strlen(delivered) > 2 * ULOG_CAPTURE_STRING_MAX);
+  assert(strncmp(delivered, full, strlen(delivered)) == 0);
+
+  // ULOG_STATIC_RANGES ranges at most; NULL forgets them all
+  assert(ulog_static_range(NULL, NULL) == ULOG_ERR_NONE);
+  assert(!ulog_is_static("a literal long enough"));
+  for (int i=0; i<ULOG_STATIC_RANGES; i++) {
+    assert(ulog_static_range(&long_text[i], &long_text[i + 1]) == ULOG_ERR_NONE);
+  }
+  assert(ulog_static_range(stack, stack + sizeof(stack)) == ULOG_ERR_NO_ROOM);
+  assert(ulog_is_static(&long_text[ULOG_STATIC_RANGES - 1]));
+  assert(!ulog_is_static(&long_text[ULOG_STATIC_RANGES]));
+  assert(!ulog_is_static(stack));
+  assert(ulog_static_range(NULL, NULL) == ULOG_ERR_NONE);
+  ulog_static_ranges_detect();
+
+  ULOG_UNSUBSCRIBE(keep);
+}
+
+void ulog_capture_test() {
+  // integers of every length, at their limits
+  EXPECT_SAME("%d %i %u", 0, -1, 4000000000u);
+  EXPECT_SAME("%d|%d", INT_MIN, INT_MAX);
+  EXPECT_SAME("%x %X %o", 0xbeefu, 0xbeefu, 8u);
+  EXPECT_SAME("%ld %lu %lx", LONG_MIN, ULONG_MAX, 0x7fL);
+  EXPECT_SAME("%lld %llu %llx", LLONG_MIN, ULLONG_MAX, 0x123456789abcLL);
+  EXPECT_SAME("%zd %zi %zu %zx", (ptrdiff_t)-1, (ptrdiff_t)-42, (size_t)-1, (size_t)255);
+  EXPECT_SAME("%zd", (ptrdiff_t)PTRDIFF_MIN);
+  EXPECT_SAME("%jd %ju %td", INTMAX_MIN, UINTMAX_MAX, (ptrdiff_t)-7);
+  EXPECT_SAME("%hhd %hhu %hd %hu", 300, -1, 40000, 65537);
+
+  // flags, widths and precisions, given or from the arguments
+  EXPECT_SAME("[%5d|%-5d|%05d|%+d|% d]", 42, 42, -42, 42, 42);
+  EXPECT_SAME("[%#x|%#o|%.3d|%8.3x]", 255u, 8u, 7, 0xau);
+  EXPECT_SAME("[%*d|%-*d|%.*d]", 6, 1, 6, 2, 4, 3);
+  EXPECT_SAME("[%*zd]", -6, (ptrdiff_t)-1);
+
+  // characters, strings and pointers
+  EXPECT_SAME("%c%c%3c", 'o', 'k', '!');
+  EXPECT_SAME("[%s|%8s|%-8s|%.2s]", "ab", "cd", "ef", "ghij");
+  EXPECT_SAME("[%.*s|%*s]", 3, "abcdef", 4, "x");
+  EXPECT_SAME("%p %p", (void *)&pointed_at, (void *)NULL);
+  EXPECT_SAME("100%% %d%%", 5);
+
+  // floating point
+  EXPECT_SAME("%f %e %E", 3.25, -1e-10, 6.02e23);
+  EXPECT_SAME("%.3g %10.4f %-+8.1e", 1.0 / 3.0, 2.5, 12345.0);
+  EXPECT_SAME("%Lf", 1.5L);
+
+  // cut to the buffer, returning the full length
+  expect_same(1, "%d", 12345);
+  expect_same(4, "%zd apples", (ptrdiff_t)-123);
+  expect_same(6, "%s and %s", "first", "second");
+
+  deferred_test();
+}
+
+#endif
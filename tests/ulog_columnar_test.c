@@ -0,0 +1,146 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_columnar_test.c
+ *
+ * \brief unit testing for tools/ulog-columnar.c, compiled into the test with
+ * its main() renamed.  Build with -DULOG_BINARY_LOG=1 and link
+ * src/ulog_binlog.c and tests/ulog_tool.c.
+ */
+
+#include "ulog.h"
+#include "ulog_test.h"
+
+#if (ULOG_BINARY_LOG == 1) && defined(__unix__)
+
+#define main ulog_columnar_main
+#include "../tools/ulog-columnar.c"
+#undef main
+
+#include "ulog_tool.h"
+#include <assert.h>
+#include <unistd.h>
+
+#define MESSAGES (4 * CHUNK_ROWS)
+#define RARE_FIRST 100            // the only messages of tenant "rare"
+#define RARE_COUNT 10
+#define FIRST_SITE_ID 26          // "ULOGBIN2", the chunk record, the type
+
+typedef struct {
+  int read;
+  int chunks;
+  int by_time;
+  int by_bloom;
+  unsigned long long matched;
+} stats_t;
+
+static char archive_path[] = "/tmp/ulog_columnar_testXXXXXX";
+
+// query the archive with one option and its value, and read the statistics
+// the tool prints
+static stats_t query_with(const char *option, const char *value) {
+  const char *args[] = { "ulog-columnar", "query", archive_path, option, value, NULL };
+  char output[1024];
+  stats_t stats;
+
+  assert(ulog_tool_run(ulog_columnar_main, output, sizeof(output), args) == 0);
+  const char *line = strstr(output, " chunks read");
+  while (line > output && line[-1] != '\n') {
+    line--;
+  }
+  assert(sscanf(line, "%d of %d chunks read (%d skipped by time, %d by bloom filter), "
+                "%llu messages matched", &stats.read, &stats.chunks, &stats.by_time,
+                &stats.by_bloom, &stats.matched) == 5);
+  return stats;
+}
+
+void ulog_columnar_test() {
+  char log_path[] = "/tmp/ulog_columnar_logXXXXXX";
+  char output[1024];
+
+  int fd = mkstemp(log_path);
+  assert(fd >= 0);
+  close(fd);
+  fd = mkstemp(archive_path);
+  assert(fd >= 0);
+  close(fd);
+
+  // a log of several chunks, where one tenant appears in the first alone
+  ULOG_INIT();
+  assert(ulog_binlog_open(log_path) == ULOG_ERR_NONE);
+  assert(ULOG_SUBSCRIBE(ulog_binlog_logger, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+  for (int i=0; i<MESSAGES; i++) {
+    bool rare = i >= RARE_FIRST && i < RARE_FIRST + RARE_COUNT;
+    ULOG_INFO("request=%d tenant=%s", i, rare ? "rare" : "acme");
+  }
+  ULOG_UNSUBSCRIBE(ulog_binlog_logger);
+  ulog_binlog_close();
+
+  const char *convert_args[] = { "ulog-columnar", "convert", "--fields", "tenant",
+                                 log_path, archive_path, NULL };
+  assert(ulog_tool_run(ulog_columnar_main, output, sizeof(output), convert_args) == 0);
+  char expected[64];
+  snprintf(expected, sizeof(expected), "%d messages, 1 sites, 4 chunks", MESSAGES);
+  assert(strstr(output, expected) != NULL);
+
+  // the bloom filters skip the chunks without the word or indexed field...
+  stats_t word = query_with("--word", "rare");
+  assert(word.chunks == 4 && word.by_bloom > 0 && word.by_time == 0);
+  stats_t field = query_with("--field", "tenant=rare");
+  assert(field.by_bloom > 0);
+
+  // ... and find what reading every chunk finds: a --grep without a whole
+  // word cannot use them
+  stats_t grep = query_with("--grep", "nant=rar");
+  assert(grep.by_bloom == 0 && grep.read == 4);
+  assert(word.matched == RARE_COUNT && field.matched == RARE_COUNT &&
+         grep.matched == RARE_COUNT);
+
+  stats_t common = query_with("--word", "acme");
+  assert(common.by_bloom == 0 && common.matched == MESSAGES - RARE_COUNT);
+  stats_t absent = query_with("--field", "tenant=none");
+  assert(absent.matched == 0 && absent.by_bloom > 0);
+
+  // a site record with an id the writer never gives is dropped, and the
+  // messages of the first chunk, now naming no known site, keep site 0
+  const uint8_t bad_id[4] = { 0xff, 0xff, 0xff, 0xff };
+  FILE *file = fopen(log_path, "r+b");
+  assert(file != NULL);
+  fseek(file, FIRST_SITE_ID, SEEK_SET);
+  fwrite(bad_id, sizeof(bad_id), 1, file);
+  fclose(file);
+  assert(ulog_tool_run(ulog_columnar_main, output, sizeof(output), convert_args) == 0);
+  assert(strstr(output, "name a site never described") != NULL);
+  snprintf(expected, sizeof(expected), "%d messages, 1 sites,", MESSAGES);
+  assert(strstr(output, expected) != NULL);
+  stats_t by_file = query_with("--file", "ulog_columnar_test");
+  assert(by_file.matched > 0 && by_file.matched < MESSAGES);
+  stats_t grouped = query_with("--by", "file");
+  assert(grouped.matched == MESSAGES);
+
+  remove(log_path);
+  remove(archive_path);
+}
+
+#endif
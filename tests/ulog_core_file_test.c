@@ -0,0 +1,160 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_core_file_test.c
+ *
+ * \brief unit testing for tools/ulog-core.c on damaged and oversized core
+ * files.  The tool is compiled into the test with its main() renamed.  Build
+ * with -DULOG_CORE_REGISTRY=1 -DULOG_DEFERRED=1 on Linux and link
+ * src/ulog_capture.c.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ulog.h"
+#include "ulog_test.h"
+
+#if (ULOG_CORE_REGISTRY == 1) && (ULOG_DEFERRED == 1) && defined(__linux__)
+
+#define main ulog_core_main
+#include "../tools/ulog-core.c"
+#undef main
+
+#include <assert.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#define LOAD_ADDRESS 0x10000
+#define HEADER_COUNT (ULOG_CORE_BUFFERS + 2)
+
+// a core file: the ELF header, a PT_LOAD and a PT_NOTE segment, the loaded
+// bytes, then the note, last so that reading past it leaves the file
+typedef struct {
+  ehdr_t ehdr;
+  phdr_t phdrs[2];
+  ulog_core_header_t headers[HEADER_COUNT];
+  ulog_core_queue_t queue;
+} loaded_t;
+
+static char path[] = "/tmp/ulog_core_file_testXXXXXX";
+
+// write a core whose NT_FILE note holds the given words and names, and load
+// it as the tool does
+static void load_core(const unsigned long *words, int word_count,
+                      const char *names, size_t names_len) {
+  static loaded_t loaded;
+  static const char owner[8] = "CORE";
+  nhdr_t note;
+
+  memset(&loaded, 0, sizeof(loaded));
+  memcpy(loaded.ehdr.e_ident, ELFMAG, SELFMAG);
+  loaded.ehdr.e_ident[EI_CLASS] = ELF_CLASS;
+  loaded.ehdr.e_type = ET_CORE;
+  loaded.ehdr.e_phoff = offsetof(loaded_t, phdrs);
+  loaded.ehdr.e_phnum = 2;
+
+  // more buffer headers than the tool has room for, all pointing at a queue
+  // whose head is out of range
+  phdr_t *loads = &loaded.phdrs[0];
+  loads->p_type = PT_LOAD;
+  loads->p_offset = offsetof(loaded_t, headers);
+  loads->p_vaddr = LOAD_ADDRESS;
+  loads->p_filesz = sizeof(loaded) - offsetof(loaded_t, headers);
+  for (int i=0; i<HEADER_COUNT; i++) {
+    loaded.headers[i].magic = ULOG_CORE_HEADER_MAGIC;
+    loaded.headers[i].kind = ULOG_CORE_QUEUE;
+    loaded.headers[i].index = (uint16_t)i;
+    loaded.headers[i].size = sizeof(ulog_core_queue_t);
+    loaded.headers[i].data = (const void *)(uintptr_t)(LOAD_ADDRESS + sizeof(loaded.headers));
+  }
+  loaded.queue.head = 100 * ULOG_ASYNC_QUEUE_DEPTH;
+  loaded.queue.count = 1;
+
+  memset(&note, 0, sizeof(note));
+  note.n_namesz = 5;
+  note.n_descsz = (uint32_t)(word_count * sizeof(unsigned long) + names_len);
+  note.n_type = NT_FILE;
+  phdr_t *notes = &loaded.phdrs[1];
+  notes->p_type = PT_NOTE;
+  notes->p_offset = sizeof(loaded);
+  notes->p_filesz = sizeof(note) + sizeof(owner) + ((note.n_descsz + 3) & ~3u);
+
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  FILE *file = fdopen(fd, "wb");
+  assert(file != NULL);
+  fwrite(&loaded, sizeof(loaded), 1, file);
+  fwrite(&note, sizeof(note), 1, file);
+  fwrite(owner, sizeof(owner), 1, file);
+  fwrite(words, sizeof(unsigned long), word_count, file);
+  fwrite(names, 1, names_len, file);
+  fwrite("\0\0\0", 1, (0 - note.n_descsz) & 3, file);
+  fclose(file);
+
+  memset(&core, 0, sizeof(core));
+  assert(load(path));
+  remove(path);
+  memcpy(&path[sizeof(path) - 7], "XXXXXX", 6);
+  load_mappings();
+}
+
+static void unload_core() {
+  free(core.mappings);
+  free(core.data);
+  memset(&core, 0, sizeof(core));
+}
+
+void ulog_core_file_test() {
+  ulog_core_header_t headers[ULOG_CORE_BUFFERS];
+
+  // a note that holds what it says
+  const unsigned long two[] = { 2, 4096, 1, 2, 0, 3, 4, 1 };
+  load_core(two, 8, "/lib/a\0/lib/b", 14);
+  assert(core.mapping_count == 2);
+  assert(strcmp(core.mappings[1].path, "/lib/b") == 0);
+  assert(core.mappings[1].offset == 4096);
+  unload_core();
+
+  // a count larger than the note, and a last name cut by its end
+  const unsigned long many[] = { 1000000, 4096, 1, 2, 0 };
+  load_core(many, 5, "/lib/a", 7);
+  assert(core.mapping_count == 0);
+  unload_core();
+  load_core(two, 8, "/lib/a\0/lib/b", 13);
+  assert(core.mapping_count == 1);
+  unload_core();
+
+  // a description too short for its count and page size
+  load_core(two, 1, "", 0);
+  assert(core.mapping_count == 0);
+
+  // more headers than ULOG_CORE_BUFFERS, and a queue with a damaged head
+  assert(find_registry(headers) == -1);
+  assert(scan_headers(headers) == ULOG_CORE_BUFFERS);
+  assert(headers[ULOG_CORE_BUFFERS - 1].index == ULOG_CORE_BUFFERS - 1);
+  print_queue(&headers[0]);
+  unload_core();
+}
+
+#endif
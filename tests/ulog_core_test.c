@@ -0,0 +1,108 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_core_test.c
+ *
+ * \brief unit testing for the buffer registry read by tools/ulog-core.c.
+ * Build with -DULOG_CORE_REGISTRY=1 -DULOG_DEFERRED=1 and link
+ * src/ulog_capture.c.
+ */
+
+#include "ulog.h"
+#include "ulog_capture.h"
+#include "ulog_core.h"
+#include "ulog_test.h"
+#include <assert.h>
+#include <string.h>
+
+#if (ULOG_CORE_REGISTRY == 1) && (ULOG_DEFERRED == 1)
+
+static const ulog_core_header_t *find(ulog_core_kind_t kind) {
+  for (uint32_t i=0; i<ulog_core_registry.count; i++) {
+    if (ulog_core_registry.headers[i]->kind == kind) {
+      return ulog_core_registry.headers[i];
+    }
+  }
+  return NULL;
+}
+
+// stands in for reading the string out of a core file
+static const char *relocated(const char *p, void *arg) {
+  (*(int *)arg)++;
+  return (strcmp(p, "a literal long enough") == 0) ? "moved" : p;
+}
+
+static void drop(ulog_level_t severity, const char *file, int line, char *msg) {
+  (void)severity;
+  (void)file;
+  (void)line;
+  (void)msg;
+}
+
+void ulog_core_test() {
+  ULOG_INIT();
+  assert(ULOG_SUBSCRIBE(drop, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+
+  // the registry and every header it lists hold their magic numbers
+  assert(ulog_core_registry.magic == ULOG_CORE_MAGIC);
+  assert(ulog_core_registry.version == ULOG_CORE_VERSION);
+  assert(ulog_core_registry.pointer_size == sizeof(void *));
+  for (uint32_t i=0; i<ulog_core_registry.count; i++) {
+    assert(ulog_core_registry.headers[i]->magic == ULOG_CORE_HEADER_MAGIC);
+  }
+  const ulog_core_header_t *message = find(ULOG_CORE_MESSAGE);
+  const ulog_core_header_t *deferred = find(ULOG_CORE_DEFERRED);
+  assert(message != NULL && message->size == ULOG_MAX_MESSAGE_LENGTH);
+  assert(deferred != NULL && deferred->size == sizeof(ulog_core_ring_t));
+
+  // a pending record reads back through the ring layout of ulog_core.h
+  ULOG_INFO("%d and %s", 42, "a literal long enough");
+  const ulog_core_ring_t *ring = (const ulog_core_ring_t *)deferred->data;
+  assert(ring->used > sizeof(ulog_core_record_t));
+  ulog_core_record_t header;
+  memcpy(&header, &ring->data[ring->tail], sizeof(header));
+  assert(header.size == ring->used && header.severity == ULOG_INFO_LEVEL);
+  assert(strcmp(header.fmt, "%d and %s") == 0 && !header.text);
+
+  // with its string pointers relocated, it renders as the tool prints it
+  uint8_t record[ULOG_DEFERRED_RECORD_SIZE];
+  int len = header.size - (int)sizeof(header);
+  memcpy(record, &ring->data[ring->tail + sizeof(header)], len);
+  int calls = 0;
+  int replaced = ulog_capture_relocate(record, len, header.fmt, relocated, &calls);
+  char msg[ULOG_MAX_MESSAGE_LENGTH];
+  ulog_capture_render(msg, sizeof(msg), header.fmt, record, len);
+  if (ulog_is_static("a literal long enough")) {
+    assert(replaced == 1 && calls == 1 && strcmp(msg, "42 and moved") == 0);
+  } else {
+    assert(replaced == 0 && strcmp(msg, "42 and a literal long enough") == 0);
+  }
+
+  // a record cut short is refused
+  assert(ulog_capture_relocate(record, 2, header.fmt, relocated, &calls) == -1);
+  ulog_deferred_flush();
+  ULOG_UNSUBSCRIBE(drop);
+}
+
+#endif
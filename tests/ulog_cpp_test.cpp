@@ -0,0 +1,172 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_cpp_test.cpp
+ *
+ * \brief unit testing for the uLog C++ front end: its output must match
+ * snprintf() for the same format and arguments, with one exception: length
+ * modifiers are ignored, so %x of a negative signed char or short prints in
+ * the width of its own type ("ff" for -1), where printf() without hh or h
+ * prints it as an int.  Built as C++20, it also tests the {} formatting of
+ * ulog_format.hpp.
+ */
+
+#include "ulog.hpp"
+#include "ulog_test.h"
+#if __cplusplus >= 202002L
+#include "ulog_format.hpp"
+#endif
+#include <cassert>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+static char last_msg[ULOG_MAX_MESSAGE_LENGTH];
+
+static void cpp_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  std::strcpy(last_msg, msg);
+}
+
+// log through ulog.hpp and compare with the C library's snprintf()
+#define EXPECT_SAME(...) do {                                                 \
+    char expected[ULOG_MAX_MESSAGE_LENGTH];                                   \
+    std::snprintf(expected, sizeof(expected), __VA_ARGS__);                   \
+    ULOG_INFO(__VA_ARGS__);                                                   \
+    assert(std::strcmp(last_msg, expected) == 0);                             \
+  } while (0)
+
+enum class color : short { red = -3 };
+
+static_assert(ulog::file_name_offset("src/app/main.cpp") == 8);
+static_assert(ulog::file_name_offset("C:\\app\\main.cpp") == 7);
+static_assert(ulog::file_name_offset("main.cpp") == 0);
+
+#if __cplusplus >= 202002L
+
+// log through ULOG_FMT_INFO() and compare with the expected text
+#define EXPECT_FMT(expected, ...) do {                                        \
+    ULOG_FMT_INFO(__VA_ARGS__);                                               \
+    assert(std::strcmp(last_msg, expected) == 0);                             \
+  } while (0)
+
+// the checks behind the compile errors for bad placeholders
+constexpr ulog::format_spec spec_of(std::string_view text) {
+  std::size_t i = 0;
+  return ulog::detail::parse_spec(text, i);
+}
+static_assert(spec_of("*^8}").fill == '*' && spec_of("*^8}").align == '^');
+static_assert(spec_of("+#010.3x}").sign == '+' && spec_of("+#010.3x}").alt);
+static_assert(spec_of("+#010.3x}").zero && spec_of("+#010.3x}").width == 10);
+static_assert(spec_of("+#010.3x}").precision == 3 && spec_of("+#010.3x}").type == 'x');
+static_assert(!ulog::detail::type_allowed(ulog::detail::fmt_kind::string, 'd'));
+static_assert(!ulog::detail::type_allowed(ulog::detail::fmt_kind::integer, 'f'));
+static_assert(ulog::detail::type_allowed(ulog::detail::fmt_kind::floating, 0));
+static_assert(ulog::format_string<int, const char *>("{} {:>4}").count == 3);
+
+static void fmt_test() {
+  EXPECT_FMT("plain", "plain");
+  EXPECT_FMT("{} {1} }{", "{{}} {{{}}} }}{{", 1);
+  EXPECT_FMT("|l     |     r|  c   |**42***|", "|{:<6}|{:>6}|{:^6}|{:*^7}|", "l", "r", "c", 42);
+  EXPECT_FMT("-42 +5 ff 0XFF 0b101 10", "{} {:+} {:x} {:#X} {:#b} {:o}", -42, 5, 255, 255, 5, 8);
+  EXPECT_FMT("-0000042 0x00ff |  7|7  |", "{:08} {:#06x} |{:3}|{:<3}|", -42, 255, 7, 7);
+  EXPECT_FMT("18446744073709551615 -9223372036854775808", "{} {}",
+             UINT64_MAX, INT64_MIN);
+  EXPECT_FMT("A 65 true 1", "{} {:d} {} {:d}", 'A', 'A', true, true);
+  EXPECT_FMT("abc [   ab] sv (null)", "{:.3} [{:>5}] {} {}", "abcdef", std::string("ab"),
+             std::string_view("sv"), (const char *)nullptr);
+  EXPECT_FMT("3.14 0.1 1.234500e+03", "{:.2f} {} {:e}", 3.14159, 0.1, 1234.5);
+  EXPECT_FMT("-3", "{}", color::red);
+
+  // fixed notation of large values, cut to the message buffer like snprintf()
+  char expected[ULOG_MAX_MESSAGE_LENGTH];
+  std::snprintf(expected, sizeof(expected), "a %f b", 1e200);
+  EXPECT_FMT(expected, "a {:f} b", 1e200);
+  std::snprintf(expected, sizeof(expected), "%.60f", 1e80);
+  EXPECT_FMT(expected, "{:.60f}", 1e80);
+  std::snprintf(expected, sizeof(expected), "%.100f", -DBL_MAX);
+  EXPECT_FMT(expected, "{:.100f}", -DBL_MAX);
+  std::snprintf(expected, sizeof(expected), "%.60f|", 1.5);
+  EXPECT_FMT(expected, "{:.60f}|", 1.5);
+
+  // truncated to the message buffer
+  std::string long_name(2 * ULOG_MAX_MESSAGE_LENGTH, 'x');
+  ULOG_FMT_INFO("{}", long_name);
+  assert(std::strlen(last_msg) == ULOG_MAX_MESSAGE_LENGTH - 1);
+  ULOG_FMT_INFO("{:>200}", "right");
+  assert(std::strlen(last_msg) == ULOG_MAX_MESSAGE_LENGTH - 1 && last_msg[0] == ' ');
+}
+
+#endif
+
+void ulog_cpp_test() {
+  ULOG_INIT();
+  assert(ULOG_SUBSCRIBE(cpp_logger, ULOG_TRACE_LEVEL) == ULOG_ERR_NONE);
+
+  EXPECT_SAME("Hello!");
+  EXPECT_SAME("%d %5d %-5d| %05d %+d % d %.3d %u", 1, -42, 7, -42, 5, 5, 7, 4000000000u);
+  EXPECT_SAME("%x %X %#x %o %#o", -1, 255, 255, 8, 8);
+  EXPECT_SAME("%lld %llx %hhx %c", -9000000000LL, -1LL, (unsigned char)200, 'z');
+  EXPECT_SAME("[%10s] [%-10s] [%.2s] %p", "hi", "hi", "hello", (void *)0x1234);
+  EXPECT_SAME("%f %.2f %10.3e %g", 3.14159, 2.5, 12345.678, 0.0001);
+  EXPECT_SAME("%*d %.*s %%", 6, 42, 3, "abcdef");
+  EXPECT_SAME("%d %#o %.0d|", 0, 0, 0);
+
+  // C++ types the C library cannot take
+  std::string name = "ada";
+  ULOG_INFO("%s/%s/%.2s", name, std::string_view("lovelace"), name);
+  assert(std::strcmp(last_msg, "ada/lovelace/ad") == 0);
+  ULOG_INFO("%d", color::red);
+  assert(std::strcmp(last_msg, "-3") == 0);
+
+  // lambdas are called only when the message is logged
+  int calls = 0;
+  auto serialize = [&] { calls++; return std::string("{\"id\":1}"); };
+  ULOG_INFO("request %s", serialize);
+  assert(std::strcmp(last_msg, "request {\"id\":1}") == 0 && calls == 1);
+  assert(ULOG_SUBSCRIBE(cpp_logger, ULOG_WARNING_LEVEL) == ULOG_ERR_NONE);
+  ULOG_INFO("request %s", serialize);
+  assert(calls == 1);
+  assert(ULOG_SUBSCRIBE(cpp_logger, ULOG_TRACE_LEVEL) == ULOG_ERR_NONE);
+
+  // ... also when written inline, as in the README
+  ULOG_INFO("request %s/%d", [&] { calls++; return name; }, [] { return 7; });
+  assert(std::strcmp(last_msg, "request ada/7") == 0 && calls == 2);
+
+  // truncated like snprintf()
+  std::string long_name(2 * ULOG_MAX_MESSAGE_LENGTH, 'x');
+  ULOG_INFO("%s", long_name);
+  assert(std::strlen(last_msg) == ULOG_MAX_MESSAGE_LENGTH - 1);
+  EXPECT_SAME("%s%8d|%-8s|%08x", long_name.c_str(), 5, "pad", 255u);
+
+  // the C library hashes modules like the constexpr version
+  assert(ulog_module_hash("ulog_cpp_test.cpp") == ulog::module_hash("ulog_cpp_test.cpp"));
+
+#if __cplusplus >= 202002L
+  fmt_test();
+#endif
+
+  ULOG_UNSUBSCRIBE(cpp_logger);
+}
@@ -0,0 +1,110 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_decode_test.c
+ *
+ * \brief unit testing for tools/ulog-decode.c, compiled into the test with
+ * its main() renamed.  Build on Linux with -DULOG_BINARY_LOG=1 -pthread and
+ * link src/ulog_binlog.c and tests/ulog_tool.c.
+ */
+
+#include "ulog.h"
+#include "ulog_test.h"
+
+#if (ULOG_BINARY_LOG == 1) && defined(__linux__)
+
+#define main ulog_decode_main
+#include "../tools/ulog-decode.c"
+#undef main
+
+#include "ulog_tool.h"
+#include <assert.h>
+
+#define ITEMS (ULOG_BINLOG_CHUNK_SIZE / 16)   // enough for several chunks
+#define OUTPUT_SIZE (ITEMS * 128)
+#define FIRST_SITE (MAGIC_SIZE + CHUNK_RECORD_SIZE)
+
+static char log_path[] = "/tmp/ulog_decode_testXXXXXX";
+static char *output;
+
+// decode the log on threads threads, and count the lines that contain text
+static int decode_lines(const char *threads, int status, const char *text) {
+  const char *args[] = { "ulog-decode", "-j", threads, log_path, NULL };
+  assert(ulog_tool_run(ulog_decode_main, output, OUTPUT_SIZE, args) == status);
+  int count = 0;
+  for (char *line = strtok(output, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+    count += strstr(line, text) != NULL;
+  }
+  return count;
+}
+
+// overwrite the id of the first site record
+static void set_first_site(uint32_t id) {
+  uint8_t bytes[4] = { (uint8_t)id, (uint8_t)(id >> 8), (uint8_t)(id >> 16), (uint8_t)(id >> 24) };
+  FILE *file = fopen(log_path, "r+b");
+  assert(file != NULL);
+  fseek(file, FIRST_SITE + 1, SEEK_SET);
+  fwrite(bytes, sizeof(bytes), 1, file);
+  fclose(file);
+}
+
+void ulog_decode_test() {
+  const uint32_t bad_ids[] = { 0, 0xffffffffu, 0x80000000u, ULOG_BINLOG_SITES + 1, 100000000u };
+  char damage[64];
+
+  output = malloc(OUTPUT_SIZE);
+  assert(output != NULL);
+  int fd = mkstemp(log_path);
+  assert(fd >= 0);
+  close(fd);
+  ULOG_INIT();
+  assert(ulog_binlog_open(log_path) == ULOG_ERR_NONE);
+  assert(ULOG_SUBSCRIBE(ulog_binlog_logger, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+  for (int i=0; i<ITEMS; i++) {
+    ULOG_INFO("item %d", i);
+  }
+  ULOG_UNSUBSCRIBE(ulog_binlog_logger);
+  ulog_binlog_close();
+
+  // every message, on one thread or several
+  assert(decode_lines("1", 0, " item ") == ITEMS);
+  assert(strstr(output, "ulog_decode_test.c:") != NULL && strstr(output, "] item 0") != NULL);
+  assert(decode_lines("4", 0, " item ") == ITEMS);
+
+  // a site id no writer gives costs the rest of its chunk, and nothing more
+  snprintf(damage, sizeof(damage), "damaged records, the first at offset %d", (int)FIRST_SITE);
+  for (size_t i=0; i<sizeof(bad_ids) / sizeof(bad_ids[0]); i++) {
+    set_first_site(bad_ids[i]);
+    int items = decode_lines("2", 1, " item ");
+    assert(items > 0 && items < ITEMS);
+    assert(decode_lines("2", 1, damage) == 1);
+  }
+  set_first_site(1);
+  assert(decode_lines("2", 0, " item ") == ITEMS);
+
+  remove(log_path);
+  free(output);
+}
+
+#endif
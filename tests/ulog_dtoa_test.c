@@ -0,0 +1,85 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_dtoa_test.c
+ *
+ * \brief unit testing for the shortest round trip double formatter
+ */
+
+#include "ulog.h"
+#include "ulog_dtoa.h"
+#include "ulog_test.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (ULOG_ENABLED == 1)
+
+static void expect(double value, const char *text) {
+  char buf[ULOG_DTOA_SIZE];
+  assert(ulog_dtoa(value, buf) == (int)strlen(text));
+  assert(strcmp(buf, text) == 0);
+}
+
+void ulog_dtoa_test() {
+  char buf[ULOG_DTOA_SIZE];
+
+  expect(0.0, "0");
+  expect(-0.0, "-0");
+  expect(1.0, "1");
+  expect(0.1, "0.1");
+  expect(-2.5, "-2.5");
+  expect(100.0, "100");
+  expect(0.3, "0.3");
+  expect(1.0 / 3.0, "0.3333333333333333");
+  expect(1e16, "10000000000000000");
+  expect(1e17, "1e+17");
+  expect(0.00001, "0.00001");
+  expect(1e-6, "1e-06");
+  expect(5e-324, "5e-324");
+  expect(1.7976931348623157e308, "1.7976931348623157e+308");
+  expect(2.2250738585072014e-308, "2.2250738585072014e-308");
+  expect(strtod("inf", NULL), "inf");
+  expect(strtod("-inf", NULL), "-inf");
+  expect(strtod("nan", NULL), "nan");
+
+  // every finite double reads back exactly
+  uint64_t state = 88172645463325252ULL;
+  for (int i=0; i<100000; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    double value;
+    memcpy(&value, &state, sizeof(value));
+    if (value != value || value - value != 0) {
+      continue;                 // nan or infinite
+    }
+    assert(ulog_dtoa(value, buf) < ULOG_DTOA_SIZE);
+    double back = strtod(buf, NULL);
+    assert(memcmp(&back, &value, sizeof(value)) == 0);
+  }
+}
+
+#endif
@@ -0,0 +1,133 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_flash_file.c
+ *
+ * \brief a flash emulator in a file, with power failures on demand
+ */
+
+#include "ulog_flash_file.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if (ULOG_FLASH_SINK == 1)
+
+// =============================================================================
+// local functions
+
+static ulog_err_t file_read(void *ctx, uint32_t address, void *data, uint32_t len) {
+  ulog_flash_file_t *emu = (ulog_flash_file_t *)ctx;
+  if (!emu->powered || fseek(emu->file, address, SEEK_SET) != 0 ||
+      fread(data, 1, len, emu->file) != len) {
+    return ULOG_ERR_SYSTEM;
+  }
+  return ULOG_ERR_NONE;
+}
+
+static ulog_err_t file_write(void *ctx, uint32_t address, const void *data, uint32_t len) {
+  ulog_flash_file_t *emu = (ulog_flash_file_t *)ctx;
+  uint8_t cells[512];
+  uint32_t programmed = len;
+
+  if (!emu->powered) {
+    return ULOG_ERR_SYSTEM;
+  }
+  if (emu->budget >= 0 && (long)len > emu->budget) {
+    programmed = (uint32_t)emu->budget;
+    emu->powered = false;
+  }
+  if (emu->budget >= 0) {
+    emu->budget -= programmed;
+  }
+  for (uint32_t done = 0; done < programmed; ) {
+    uint32_t n = programmed - done;
+    n = (n < sizeof(cells)) ? n : sizeof(cells);
+    fseek(emu->file, address + done, SEEK_SET);
+    if (fread(cells, 1, n, emu->file) != n) {
+      return ULOG_ERR_SYSTEM;
+    }
+    for (uint32_t i=0; i<n; i++) {
+      cells[i] &= ((const uint8_t *)data)[done + i];
+    }
+    fseek(emu->file, address + done, SEEK_SET);
+    fwrite(cells, 1, n, emu->file);
+    done += n;
+  }
+  return emu->powered ? ULOG_ERR_NONE : ULOG_ERR_SYSTEM;
+}
+
+static ulog_err_t file_erase(void *ctx, uint32_t sector) {
+  ulog_flash_file_t *emu = (ulog_flash_file_t *)ctx;
+  uint8_t erased[512];
+
+  if (!emu->powered) {
+    return ULOG_ERR_SYSTEM;
+  }
+  memset(erased, 0xff, sizeof(erased));
+  fseek(emu->file, sector * emu->driver.sector_size, SEEK_SET);
+  for (uint32_t done = 0; done < emu->driver.sector_size; done += sizeof(erased)) {
+    uint32_t n = emu->driver.sector_size - done;
+    fwrite(erased, 1, (n < sizeof(erased)) ? n : sizeof(erased), emu->file);
+  }
+  emu->erases[sector]++;
+  return ULOG_ERR_NONE;
+}
+
+// =============================================================================
+// user-visible code
+
+ulog_err_t ulog_flash_file_open(ulog_flash_file_t *emu, uint32_t sector_size,
+                                uint32_t sector_count) {
+  memset(emu, 0, sizeof(*emu));
+  emu->file = tmpfile();
+  emu->erases = calloc(sector_count, sizeof(uint32_t));
+  if (emu->file == NULL || emu->erases == NULL) {
+    return ULOG_ERR_SYSTEM;
+  }
+  emu->budget = -1;
+  emu->powered = true;
+  emu->driver.read = file_read;
+  emu->driver.write = file_write;
+  emu->driver.erase = file_erase;
+  emu->driver.ctx = emu;
+  emu->driver.sector_size = sector_size;
+  emu->driver.sector_count = sector_count;
+  for (uint32_t sector=0; sector<sector_count; sector++) {
+    file_erase(emu, sector);
+    emu->erases[sector] = 0;    // comes erased from the factory
+  }
+  return ULOG_ERR_NONE;
+}
+
+void ulog_flash_file_close(ulog_flash_file_t *emu) {
+  fclose(emu->file);
+  free(emu->erases);
+}
+
+void ulog_flash_file_power_on(ulog_flash_file_t *emu, long budget) {
+  emu->powered = true;
+  emu->budget = budget;
+}
+
+#endif
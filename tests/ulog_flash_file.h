@@ -0,0 +1,72 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_flash_file.h
+ *
+ * \brief a flash emulator in a file, with power failures on demand
+ *
+ * Programming only clears bits and erasing sets a sector to 0xff, as on NOR
+ * flash.  With a budget set, the write that exhausts it programs only the
+ * bytes the budget allows and fails, as if power was lost in the middle.
+ * Every later call fails until ulog_flash_file_power_on().
+ */
+
+#ifndef ULOG_FLASH_FILE_H_
+#define ULOG_FLASH_FILE_H_
+
+#include "ulog_flash.h"
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+typedef struct {
+  FILE *file;
+  long budget;              // bytes to program before power fails, -1: no limit
+  bool powered;
+  uint32_t *erases;         // per sector
+  ulog_flash_driver_t driver;
+} ulog_flash_file_t;
+
+/**
+ * @brief: create an erased flash of sector_count sectors of sector_size
+ * bytes in an anonymous temporary file.
+ */
+ulog_err_t ulog_flash_file_open(ulog_flash_file_t *emu, uint32_t sector_size,
+                                uint32_t sector_count);
+
+void ulog_flash_file_close(ulog_flash_file_t *emu);
+
+/**
+ * @brief: restore power, with budget bytes (-1: any number) to program until
+ * the next failure.
+ */
+void ulog_flash_file_power_on(ulog_flash_file_t *emu, long budget);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_FLASH_FILE_H_ */
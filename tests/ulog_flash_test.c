@@ -0,0 +1,141 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_flash_test.c
+ *
+ * \brief unit testing for the flash subscriber, on the file emulator of
+ * ulog_flash_file.c, with power failures.  Build with -DULOG_FLASH_SINK=1
+ */
+
+#include "ulog.h"
+#include "ulog_flash.h"
+#include "ulog_flash_file.h"
+#include "ulog_test.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (ULOG_FLASH_SINK == 1)
+
+#define SECTOR_SIZE 512
+#define SECTOR_COUNT 8
+
+// what ulog_flash_replay() found
+static struct {
+  int count;
+  int first;                // number of the first message
+  int last;                 // number of the last message
+  int gaps;                 // messages missing between two others
+} replayed;
+
+static void visit(ulog_level_t severity, const char *msg, int len, void *arg) {
+  int n;
+  assert(severity == ULOG_INFO_LEVEL);
+  assert(len > 8 && memcmp(msg, "message ", 8) == 0);
+  n = atoi(&msg[8]);
+  if (replayed.count == 0) {
+    replayed.first = n;
+  } else {
+    assert(n > replayed.last);  // in order
+    replayed.gaps += n - replayed.last - 1;
+  }
+  replayed.last = n;
+  replayed.count++;
+}
+
+static void replay(ulog_flash_file_t *emu) {
+  memset(&replayed, 0, sizeof(replayed));
+  assert(ulog_flash_replay(&emu->driver, visit, NULL) == replayed.count);
+}
+
+void ulog_flash_test() {
+  ulog_flash_file_t emu;
+  ulog_flash_stats_t stats;
+  uint32_t min, max;
+  int next = 0;
+
+  ULOG_INIT();
+  assert(ulog_flash_file_open(&emu, SECTOR_SIZE, SECTOR_COUNT) == ULOG_ERR_NONE);
+  assert(ulog_flash_open(&emu.driver) == ULOG_ERR_NONE);
+  assert(ULOG_SUBSCRIBE(ulog_flash_logger, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+
+  // a few messages read back as they were written
+  for (; next < 10; next++) {
+    ULOG_INFO("message %d", next);
+  }
+  replay(&emu);
+  assert(replayed.count == 10 && replayed.first == 0 && replayed.last == 9);
+
+  // many turns of the ring: the newest messages stay, wear stays even
+  for (; next < 5000; next++) {
+    ULOG_INFO("message %d", next);
+  }
+  replay(&emu);
+  assert(replayed.last == 4999 && replayed.gaps == 0);
+  assert(replayed.count > (SECTOR_COUNT - 1) * SECTOR_SIZE / 32);
+  ulog_flash_wear(&emu.driver, &min, &max);
+  assert(min > 10 && max - min <= 1);
+  ulog_flash_stats(&stats);
+  assert(stats.dropped == 0);
+
+  // power fails at every point of a record or a sector header: after a
+  // restart every message written before stays, in order, and the log
+  // continues
+  int written = next - 1;       // the last message known to be on flash
+  srand(1);
+  for (int trial=0; trial<200; trial++) {
+    ulog_flash_file_power_on(&emu, rand() % (2 * SECTOR_SIZE));
+    while (emu.powered) {
+      uint32_t records = stats.records;
+      ULOG_INFO("message %d", next);
+      ulog_flash_stats(&stats);
+      written = (stats.records > records) ? next : written;
+      next++;
+    }
+    ulog_flash_file_power_on(&emu, -1);
+    assert(ulog_flash_open(&emu.driver) == ULOG_ERR_NONE);
+    ulog_flash_stats(&stats);
+    replay(&emu);
+    // the torn message itself may survive when only its padding was cut
+    assert(replayed.last == written || replayed.last == next - 1);
+  }
+  ULOG_INFO("message %d", next);
+  replay(&emu);
+  assert(replayed.last == next);
+  ulog_flash_wear(&emu.driver, &min, &max);
+  assert(max - min <= 1);
+  // the real erases, re-erases after torn sector headers included
+  min = max = emu.erases[0];
+  for (int i=1; i<SECTOR_COUNT; i++) {
+    min = (emu.erases[i] < min) ? emu.erases[i] : min;
+    max = (emu.erases[i] > max) ? emu.erases[i] : max;
+  }
+  assert(max - min <= 3);
+
+  ULOG_UNSUBSCRIBE(ulog_flash_logger);
+  ulog_flash_file_close(&emu);
+}
+
+#endif
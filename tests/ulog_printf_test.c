@@ -0,0 +1,130 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_printf_test.c
+ *
+ * \brief unit testing for the small vsnprintf() of ULOG_TINY_PRINTF.
+ * Build with -DULOG_TINY_PRINTF=1 and link src/ulog_printf.c, also with
+ * -DULOG_PRINTF_LONG_LONG=0.
+ */
+
+#include "ulog.h"
+#include "ulog_printf.h"
+#include "ulog_test.h"
+#include <assert.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if (ULOG_ENABLED == 1) && (ULOG_TINY_PRINTF == 1)
+
+// format into size bytes with ulog_vsnprintf() and with vsnprintf(), and
+// compare the text and the returned length
+static void expect_same(int size, const char *fmt, ...) {
+  char expected[64];
+  char got[64];
+  va_list ap;
+
+  assert(size <= (int)sizeof(got));
+  va_start(ap, fmt);
+  int n = vsnprintf(expected, size, fmt, ap);
+  va_end(ap);
+  memset(got, '#', sizeof(got));
+  va_start(ap, fmt);
+  assert(ulog_vsnprintf(got, size, fmt, ap) == n);
+  va_end(ap);
+  assert(strcmp(got, expected) == 0);
+}
+
+// format with ulog_vsnprintf() and compare with text
+static void expect(const char *text, const char *fmt, ...) {
+  char got[64];
+  va_list ap;
+
+  va_start(ap, fmt);
+  assert(ulog_vsnprintf(got, sizeof(got), fmt, ap) == (int)strlen(text));
+  va_end(ap);
+  assert(strcmp(got, text) == 0);
+}
+
+#define EXPECT_SAME(...) expect_same(64, __VA_ARGS__)
+
+static int pointed_at;
+
+void ulog_printf_test() {
+  char buf[8];
+
+  // integers, at their limits
+  EXPECT_SAME("%d %i %u", 0, -1, 4000000000u);
+  EXPECT_SAME("%d|%d", INT_MIN, INT_MAX);
+  EXPECT_SAME("%x %X %u", 0xbeefu, 0xbeefu, UINT_MAX);
+  EXPECT_SAME("%ld %lu %lx", LONG_MIN, ULONG_MAX, 0x7fL);
+
+  // hh and h cut their int argument to char and short
+  EXPECT_SAME("%hhd %hhd %hhu %hhx", 300, -129, 511, (signed char)-1);
+  EXPECT_SAME("%hd %hd %hu %hX", 40000, -32769, 65537, (short)-2);
+
+  // z, t and j take their own sizes
+  EXPECT_SAME("%zu %zx %td", (size_t)-1, (size_t)255, (ptrdiff_t)-7);
+  if (sizeof(intmax_t) <= sizeof(long) || ULOG_PRINTF_LONG_LONG == 1) {
+    EXPECT_SAME("%jd %ju", INTMAX_MIN, UINTMAX_MAX);
+  }
+
+#if (ULOG_PRINTF_LONG_LONG == 1)
+  EXPECT_SAME("%lld %llu %llx", LLONG_MIN, ULLONG_MAX, 0x123456789abcLL);
+#else
+  // 64-bit conversions take their argument but print ?
+  expect("? ? 3", "%lld %llx %d", LLONG_MIN, ULLONG_MAX, 3);
+#endif
+
+  // the - and 0 flags and widths, given or from the arguments
+  EXPECT_SAME("[%5d|%-5d|%05d|%5x|%-3u]", 42, 42, -42, 0xabu, 7u);
+  EXPECT_SAME("[%*d|%-*d|%*d|%*s]", 6, 1, 6, 2, -6, 3, 4, "x");
+  EXPECT_SAME("[%2d|%1s]", 12345, "long");
+
+  // characters, strings and pointers
+  EXPECT_SAME("%c%c%3c%-3c|", 'o', 'k', '!', '?');
+  EXPECT_SAME("[%s|%8s|%-8s|%.2s|%.*s]", "ab", "cd", "ef", "ghij", 3, "klmnop");
+  EXPECT_SAME("[%.0s|%s]", "gone", "");
+  EXPECT_SAME("%s", (const char *)NULL);
+  EXPECT_SAME("%p", (void *)&pointed_at);
+  EXPECT_SAME("100%% %d%%", 5);
+
+  // floating point is not formatted, but its argument is taken
+  expect("? ? 1", "%f %g %d", 1.5, 2.5, 1);
+
+  // cut to the buffer, returning the full length
+  expect_same(1, "%d", 12345);
+  expect_same(4, "%d apples", -123);
+  expect_same(6, "%s and %s", "first", "second");
+  expect_same(5, "%-8s|", "ab");
+  assert(ulog_snprintf(buf, 0, "%d", 12345) == 5);
+  assert(ulog_snprintf(buf, sizeof(buf), "%s-%d", "x", 7) == 3);
+  assert(strcmp(buf, "x-7") == 0);
+}
+
+#endif
@@ -0,0 +1,185 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_site_test.c
+ *
+ * \brief unit testing for uLog call site counters.  Build with -DULOG_SITES=1
+ */
+
+#include "ulog.h"
+#include "ulog_test.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#if (ULOG_SITES == 1)
+
+static int dump_lines;
+
+static void site_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  // nothing to do: the site counters are under test
+}
+
+static int module_matches;
+
+static void module_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  const ulog_site_t *site = ulog_current_site();
+  if (site != NULL && site->file == file && site->module == ulog_module_hash(file)) {
+    module_matches++;
+  }
+}
+
+static int renders;
+
+static int render_request(char *buf, int size, void *ctx) {
+  renders++;
+  return snprintf(buf, size, "request %d", *(int *)ctx);
+}
+
+static void lazy_site(int request) {
+  ULOG_LAZY(ULOG_INFO_LEVEL, render_request, &request);
+}
+
+static uint32_t fixed_clock() {
+  return 5000000;                      // every call in the same second
+}
+
+static const ulog_site_t *find_site(const char *fmt) {
+  const ulog_site_t *site = ulog_site_first();
+  while (site != NULL && strcmp(site->fmt, fmt) != 0) {
+    site = site->next;
+  }
+  return site;
+}
+
+static void site_printer(const char *line) {
+  dump_lines++;
+}
+
+static void quiet_site() {
+  ULOG_INFO("%d", 1);                  // 1 byte per hit
+}
+
+static void noisy_site() {
+  ULOG_WARNING("noisy %d", 1000);      // 10 bytes per hit
+}
+
+static void filtered_site() {
+  ULOG_TRACE("filtered");              // below threshold: never emitted
+}
+
+void ulog_site_test() {
+  const ulog_site_t *top[4];
+
+  ULOG_INIT();
+  assert(ULOG_SUBSCRIBE(site_logger, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+  ulog_site_reset();
+
+  for (int i=0; i<3; i++) {
+    quiet_site();
+    noisy_site();
+    filtered_site();
+  }
+
+  assert(ulog_site_top(top, 4) == 3);
+  assert(top[0]->bytes == 30);
+  assert(top[0]->hits == 3);
+  assert(top[0]->emitted == 3);
+  assert(strcmp(top[0]->fmt, "noisy %d") == 0);
+  assert(top[1]->bytes == 3);
+  assert(top[2]->hits == 3);
+  assert(top[2]->emitted == 0);
+  assert(top[2]->bytes == 0);
+
+  // top-k with k smaller than the number of sites keeps the largest
+  assert(ulog_site_top(top, 1) == 1);
+  assert(top[0]->bytes == 30);
+
+  dump_lines = 0;
+  ulog_site_dump(site_printer, 2);
+  assert(dump_lines == 3);             // header plus two sites
+
+  ulog_site_reset();
+  assert(ulog_site_top(top, 4) == 3);
+  assert(top[0]->hits == 0);
+
+  // disabled sites count hits but emit nothing
+  assert(ulog_site_enable("ulog_site_test.c", 0, false) == ULOG_ERR_NONE);
+  assert(ulog_site_enable("no_such_file.c", 0, false) == ULOG_ERR_NO_SUCH_SITE);
+  noisy_site();
+  assert(ulog_site_top(top, 4) == 3);
+  assert(top[0]->hits == 1 || top[1]->hits == 1 || top[2]->hits == 1);
+  assert(top[0]->bytes == 0);
+  assert(ulog_site_enable("ulog_site_test.c", 0, true) == ULOG_ERR_NONE);
+  noisy_site();
+  assert(ulog_site_top(top, 1) == 1);
+  assert(top[0]->bytes == 10);
+
+  // subscribers find the module hash in the current call site
+  module_matches = 0;
+  assert(ULOG_SUBSCRIBE(module_logger, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+  noisy_site();
+  assert(module_matches == 1);
+  assert(ulog_current_site() == NULL);
+  ULOG_UNSUBSCRIBE(module_logger);
+  assert(ulog_module_hash("") == 2166136261u);
+  assert(ulog_module_hash("a") == 0xe40c292cu);
+
+  // lazy messages are only rendered once they pass every check
+  renders = 0;
+  lazy_site(7);
+  assert(renders == 1);
+  assert(ulog_site_enable("ulog_site_test.c", 0, false) == ULOG_ERR_NONE);
+  lazy_site(8);
+  assert(renders == 1);
+  assert(ulog_site_enable("ulog_site_test.c", 0, true) == ULOG_ERR_NONE);
+  assert(ULOG_SUBSCRIBE(site_logger, ULOG_WARNING_LEVEL) == ULOG_ERR_NONE);
+  lazy_site(9);
+  assert(renders == 1);
+  assert(ULOG_SUBSCRIBE(site_logger, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+
+  // rate limits only charge messages that some subscriber takes
+  ulog_set_clock(fixed_clock);
+  assert(ulog_site_set_rate_limit("ulog_site_test.c", 0, 1) == ULOG_ERR_NONE);
+  for (int i=0; i<3; i++) {
+    filtered_site();
+  }
+  assert(find_site("filtered")->suppressed == 0);
+  for (int i=0; i<3; i++) {
+    quiet_site();
+  }
+  assert(find_site("%d")->suppressed == 2);
+  assert(ulog_site_set_rate_limit("ulog_site_test.c", 0, 0) == ULOG_ERR_NONE);
+  ulog_set_clock(NULL);
+
+#if (ULOG_LEVEL_PARSE == 1)
+  assert(ulog_level_parse("warn") == ULOG_WARNING_LEVEL);
+  assert(ulog_level_parse("CRITICAL") == ULOG_CRITICAL_LEVEL);
+  assert(ulog_level_parse("LOUD") == ULOG_LEVEL_N);
+#endif
+
+  ULOG_UNSUBSCRIBE(site_logger);
+}
+
+#endif
@@ -0,0 +1,143 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_tail_test.c
+ *
+ * \brief unit testing for tools/ulog-tail.c without --follow, compiled into
+ * the test with its main() renamed.  Build on Linux with -DULOG_BINARY_LOG=1
+ * and link src/ulog_binlog.c and tests/ulog_tool.c.
+ */
+
+#include "ulog.h"
+#include "ulog_test.h"
+
+#if (ULOG_BINARY_LOG == 1) && defined(__linux__)
+
+#define main ulog_tail_main
+#include "../tools/ulog-tail.c"
+#undef main
+
+#include "ulog_tool.h"
+#include <assert.h>
+
+#define ITEMS (ULOG_BINLOG_CHUNK_SIZE / 16)   // enough for several chunks
+#define ERROR_EVERY 1000
+#define ERRORS (ITEMS / ERROR_EVERY)
+#define OUTPUT_SIZE (ITEMS * 128)
+
+static char log_path[] = "/tmp/ulog_tail_testXXXXXX";
+static char *output;
+
+// run ulog-tail with up to two options before the log, and count the lines
+// it prints that contain text
+static int tail_lines(const char *option, const char *value, const char *text) {
+  const char *args[] = { "ulog-tail", option, value, log_path, NULL };
+  if (value == NULL) {
+    args[2] = log_path;
+    args[3] = NULL;
+  }
+  if (option == NULL) {
+    args[1] = log_path;
+    args[2] = NULL;
+  }
+  assert(ulog_tool_run(ulog_tail_main, output, OUTPUT_SIZE, args) == 0);
+  int count = 0;
+  for (char *line = strtok(output, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+    count += strstr(line, text) != NULL;
+  }
+  return count;
+}
+
+void ulog_tail_test() {
+  char site[64];
+  int error_line = 0;
+
+  output = malloc(OUTPUT_SIZE);
+  assert(output != NULL);
+  int fd = mkstemp(log_path);
+  assert(fd >= 0);
+  close(fd);
+  ULOG_INIT();
+  assert(ulog_binlog_open(log_path) == ULOG_ERR_NONE);
+  assert(ULOG_SUBSCRIBE(ulog_binlog_logger, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+  for (int i=0; i<ITEMS; i++) {
+    ULOG_INFO("item %d", i);
+    if ((i + 1) % ERROR_EVERY == 0) {
+      ULOG_ERROR("disk %d full", i);
+      error_line = __LINE__ - 1;
+    }
+  }
+  ULOG_UNSUBSCRIBE(ulog_binlog_logger);
+  ulog_binlog_close();
+
+  // every message, as ulog-decode prints it, with or without --all
+  assert(tail_lines(NULL, NULL, " item ") == ITEMS);
+  assert(strncmp(output, "20", 2) == 0 && strstr(output, " INFO ") != NULL);
+  assert(strstr(output, "ulog_tail_test.c:") != NULL && strstr(output, "] item 0") != NULL);
+  assert(tail_lines("--all", NULL, " full") == ERRORS);
+
+  // --level and --site, by file name or FILE:LINE
+  assert(tail_lines("--level", "error", " item ") == 0);
+  assert(tail_lines("--level", "error", " full") == ERRORS);
+  assert(tail_lines("--site", "tail_test", " item ") == ITEMS);
+  snprintf(site, sizeof(site), "ulog_tail_test.c:%d", error_line);
+  assert(tail_lines("--site", site, " item ") == 0);
+  assert(tail_lines("--site", site, " full") == ERRORS);
+  assert(tail_lines("--site", "elsewhere.c", "]") == 0);
+
+  // a site id no writer gives is damage too, however large
+  uint8_t bad_id[4] = { 0xff, 0xff, 0xff, 0xff };
+  FILE *file = fopen(log_path, "r+b");
+  assert(file != NULL);
+  fseek(file, MAGIC_SIZE + CHUNK_RECORD_SIZE + 1, SEEK_SET);
+  fwrite(bad_id, sizeof(bad_id), 1, file);
+  fclose(file);
+  int items = tail_lines(NULL, NULL, " item ");
+  assert(items > 0 && items < ITEMS);
+  snprintf(site, sizeof(site), "damaged record at offset %d,",
+           (int)(MAGIC_SIZE + CHUNK_RECORD_SIZE));
+  assert(tail_lines(NULL, NULL, site) == 1);
+
+  // a damaged record is reported, and the messages of the next chunk print
+  char garbage[64];
+  memset(garbage, 0xff, sizeof(garbage));
+  file = fopen(log_path, "r+b");
+  assert(file != NULL);
+  fseek(file, ULOG_BINLOG_CHUNK_SIZE / 2, SEEK_SET);
+  fwrite(garbage, sizeof(garbage), 1, file);
+  fclose(file);
+  items = tail_lines(NULL, NULL, " item ");
+  assert(items > ITEMS / 4 && items < ITEMS);
+  assert(tail_lines(NULL, NULL, "damaged record") == 1);
+
+  // a file that is not a binary log is refused
+  const char *args[] = { "ulog-tail", "/dev/null", NULL };
+  assert(ulog_tool_run(ulog_tail_main, output, OUTPUT_SIZE, args) == 1);
+  assert(strstr(output, "not a uLog binary log") != NULL);
+
+  remove(log_path);
+  free(output);
+}
+
+#endif
@@ -35,6 +35,20 @@ extern "C" {
     #endif
 
 void ulog_test();
+void ulog_site_test();
+void ulog_timing_test();
+void ulog_cpp_test();
+void ulog_dtoa_test();
+void ulog_uart_test();
+void ulog_flash_test();
+void ulog_core_test();
+void ulog_binlog_test();
+void ulog_capture_test();
+void ulog_printf_test();
+void ulog_core_file_test();
+void ulog_columnar_test();
+void ulog_tail_test();
+void ulog_decode_test();
 
 #ifdef __cplusplus
 }
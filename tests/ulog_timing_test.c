@@ -0,0 +1,111 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_timing_test.c
+ *
+ * \brief unit testing for uLog slow subscriber demotion.  Build with
+ * -DULOG_SUBSCRIBER_TIMING=1
+ */
+
+#include "ulog.h"
+#include "ulog_test.h"
+#include <assert.h>
+#include <string.h>
+
+#if (ULOG_SUBSCRIBER_TIMING == 1)
+
+static uint32_t now_us;
+static uint32_t slow_cost_us;
+static int slow_calls;
+static int fast_calls;
+static ulog_function_t demoted_fn;
+
+static uint32_t fake_clock() {
+  return now_us;
+}
+
+static void slow_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  assert(strcmp(msg, "Hello!") == 0);
+  now_us += slow_cost_us;
+  slow_calls++;
+}
+
+static void fast_logger(ulog_level_t severity, const char *file, int line, char *msg) {
+  now_us += 1;
+  fast_calls++;
+}
+
+static void on_demote(ulog_function_t fn) {
+  demoted_fn = fn;
+}
+
+void ulog_timing_test() {
+  ulog_subscriber_stats_t stats;
+
+  ULOG_INIT();
+  ulog_set_clock(fake_clock);
+  ulog_set_demote_handler(on_demote);
+  assert(ULOG_SUBSCRIBE(slow_logger, ULOG_TRACE_LEVEL) == ULOG_ERR_NONE);
+  assert(ULOG_SUBSCRIBE(fast_logger, ULOG_TRACE_LEVEL) == ULOG_ERR_NONE);
+
+  // within budget: stays synchronous
+  slow_cost_us = ULOG_SLOW_BUDGET_US;
+  ULOG_INFO("Hello!");
+  assert(ulog_subscriber_stats(slow_logger, &stats) == ULOG_ERR_NONE);
+  assert(stats.calls == 1 && stats.slow_calls == 0 && !stats.demoted);
+
+  // over budget ULOG_SLOW_STRIKES times: demoted
+  slow_cost_us = ULOG_SLOW_BUDGET_US + 1;
+  for (int i=0; i<ULOG_SLOW_STRIKES; i++) {
+    ULOG_INFO("Hello!");
+  }
+  assert(demoted_fn == slow_logger);
+  assert(ulog_subscriber_stats(slow_logger, &stats) == ULOG_ERR_NONE);
+  assert(stats.demoted);
+  assert(stats.max_us == ULOG_SLOW_BUDGET_US + 1);
+  assert(ulog_subscriber_stats(fast_logger, &stats) == ULOG_ERR_NONE);
+  assert(!stats.demoted);
+
+  // demoted subscriber is queued, the other one is still called directly
+  slow_calls = 0;
+  fast_calls = 0;
+  for (int i=0; i<ULOG_ASYNC_QUEUE_DEPTH + 2; i++) {
+    ULOG_INFO("Hello!");
+  }
+  assert(slow_calls == 0);
+  assert(fast_calls == ULOG_ASYNC_QUEUE_DEPTH + 2);
+  assert(ulog_subscriber_stats(slow_logger, &stats) == ULOG_ERR_NONE);
+  assert(stats.queued == ULOG_ASYNC_QUEUE_DEPTH);
+  assert(stats.dropped == 2);
+
+  assert(ulog_drain() == ULOG_ASYNC_QUEUE_DEPTH);
+  assert(slow_calls == ULOG_ASYNC_QUEUE_DEPTH);
+  assert(ulog_drain() == 0);
+
+  ULOG_UNSUBSCRIBE(slow_logger);
+  ULOG_UNSUBSCRIBE(fast_logger);
+  assert(ulog_subscriber_stats(slow_logger, &stats) == ULOG_ERR_NOT_SUBSCRIBED);
+}
+
+#endif
@@ -0,0 +1,67 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_tool.c
+ *
+ * \brief run the main() of a tool in tools/ and keep what it prints
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ulog_tool.h"
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int ulog_tool_run(ulog_tool_main_t tool_main, char *output, int size, const char *const *args) {
+  int argc = 0;
+  while (args[argc] != NULL) {
+    argc++;
+  }
+  FILE *capture = tmpfile();
+  if (capture == NULL) {
+    return -1;
+  }
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    dup2(fileno(capture), STDOUT_FILENO);
+    dup2(fileno(capture), STDERR_FILENO);
+    int status = tool_main(argc, (char **)args);
+    fflush(stdout);
+    _exit(status);          // skips the leak checks of the tool's globals
+  }
+  int status = -1;
+  if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+    status = -1;
+  } else {
+    status = WEXITSTATUS(status);
+  }
+  rewind(capture);
+  size_t n = fread(output, 1, size - 1, capture);
+  output[n] = '\0';
+  fclose(capture);
+  return status;
+}
@@ -0,0 +1,53 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_tool.h
+ *
+ * \brief run the main() of a tool in tools/, compiled into a test with
+ * #define main, and keep what it prints
+ */
+
+#ifndef ULOG_TOOL_H_
+#define ULOG_TOOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+typedef int (*ulog_tool_main_t)(int argc, char **argv);
+
+/**
+ * @brief: call tool_main with args, a NULL terminated list that starts with
+ * the program name, in a child process so that the globals of the tool start
+ * from zero each time.  What it prints to stdout and stderr is written into
+ * output, cut to size bytes and NUL terminated.  Returns its exit status, or
+ * -1 if it could not be run or was killed.
+ */
+int ulog_tool_run(ulog_tool_main_t tool_main, char *output, int size, const char *const *args);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ULOG_TOOL_H_ */
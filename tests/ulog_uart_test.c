@@ -0,0 +1,95 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog_uart_test.c
+ *
+ * \brief unit testing for the double-buffered UART subscriber.  Build with
+ * -DULOG_UART_SINK=1
+ */
+
+#include "ulog.h"
+#include "ulog_test.h"
+#include "ulog_uart.h"
+#include <assert.h>
+#include <string.h>
+
+#if (ULOG_UART_SINK == 1)
+
+// the transfer in progress, as a DMA channel would hold it
+static const uint8_t *sent_data;
+static int sent_len;
+static int starts;
+
+static void fake_start(const uint8_t *data, int len) {
+  sent_data = data;
+  sent_len = len;
+  starts++;
+}
+
+static bool sent(const char *text) {
+  return sent_len == (int)strlen(text) && memcmp(sent_data, text, sent_len) == 0;
+}
+
+void ulog_uart_test() {
+  ulog_uart_stats_t stats;
+
+  ULOG_INIT();
+  ulog_uart_init(fake_start, NULL);
+  assert(ULOG_SUBSCRIBE(ulog_uart_logger, ULOG_INFO_LEVEL) == ULOG_ERR_NONE);
+
+  // an idle UART starts at once
+  ULOG_INFO("one");
+  assert(starts == 1 && sent("INFO: one\r\n"));
+
+  // while it transmits, messages collect in the other buffer
+  ULOG_INFO("two");
+  ULOG_WARNING("three");
+  assert(starts == 1);
+  ulog_uart_tx_done();
+  assert(starts == 2 && sent("INFO: two\r\nWARN: three\r\n"));
+
+  // nothing new: the UART goes idle, and the next message starts it again
+  ulog_uart_tx_done();
+  assert(starts == 2);
+  ULOG_INFO("four");
+  assert(starts == 3 && sent("INFO: four\r\n"));
+
+  // a full buffer drops whole messages
+  int accepted = 0;
+  for (int i=0; i<ULOG_UART_BUFFER_SIZE; i++) {
+    ULOG_INFO("x");               // 9 bytes with "INFO: " and "\r\n"
+    accepted += (i < ULOG_UART_BUFFER_SIZE / 9);
+  }
+  ulog_uart_stats(&stats);
+  assert(stats.messages == 4 + (uint32_t)accepted);
+  assert(stats.dropped_messages == ULOG_UART_BUFFER_SIZE - (uint32_t)accepted);
+  assert(stats.dropped_bytes == 9 * stats.dropped_messages);
+  assert(stats.transfers == 3);
+  ulog_uart_tx_done();
+  assert(starts == 4 && sent_len == 9 * accepted);
+
+  ULOG_UNSUBSCRIBE(ulog_uart_logger);
+}
+
+#endif
@@ -0,0 +1,51 @@
+#!/bin/sh
+#
+# Write uLog as a single header, ulog_single.h unless told otherwise:
+#
+#     sh tools/amalgamate.sh [output]
+#
+# Include the result wherever ulog.h was included.  In exactly one .c file,
+# define ULOG_IMPLEMENTATION before including it to compile the library:
+#
+#     #define ULOG_IMPLEMENTATION
+#     #include "ulog_single.h"
+#
+# Configuration switches (ULOG_SITES, ...) must be the same for every file,
+# best given with -D.  With ULOG_DEFERRED on Linux, the implementation file
+# must include it before any system header, or be compiled with -D_GNU_SOURCE.
+# The POSIX add-ons (ulog_shm, ulog_ctl, ulog_reload, ulog_binlog) stay
+# separate files.
+
+set -e
+
+src=$(dirname "$0")/../src
+out=${1:-ulog_single.h}
+
+# copy a source file, dropping the includes that are already inlined
+inline() {
+  printf '\n// ---- %s ----\n\n' "$1"
+  grep -v -e '^#include "ulog.h"' -e '^#include "ulog_config.h"' \
+    -e '^#include "ulog_capture.h"' -e '^#include "ulog_dtoa.h"' \
+    -e '^#include "ulog_printf.h"' -e '^#include "ulog_core.h"' "$src/$1"
+}
+
+{
+  printf '// uLog single header, generated by tools/amalgamate.sh.  Do not edit.\n'
+  printf '#ifndef ULOG_SINGLE_H_\n#define ULOG_SINGLE_H_\n'
+  printf '#ifdef ULOG_IMPLEMENTATION\n#define ULOG_LIBRARY_\n'
+  printf '#if defined(__linux__) && !defined(_GNU_SOURCE)\n#define _GNU_SOURCE\n#endif\n'
+  printf '#endif\n'
+  inline ulog_config.h
+  inline ulog.h
+  inline ulog_core.h
+  inline ulog_capture.h
+  inline ulog_dtoa.h
+  inline ulog_printf.h
+  printf '\n#endif /* ULOG_SINGLE_H_ */\n'
+  printf '\n#ifdef ULOG_IMPLEMENTATION\n'
+  inline ulog.c
+  inline ulog_capture.c
+  inline ulog_dtoa.c
+  inline ulog_printf.c
+  printf '\n#endif /* ULOG_IMPLEMENTATION */\n'
+} > "$out"
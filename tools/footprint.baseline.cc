@@ -0,0 +1,22 @@
+# tools/footprint.sh --update, CFLAGS=-Os
+# cc (Debian 12.2.0-14+deb12u1) 12.2.0
+# config text data bss
+disabled 0 0 0
+default 1285 4 248
+sites 2892 4 272
+rate_limit 2894 4 272
+static_subs 1148 4 248
+stats 1487 4 280
+timing 2224 4 7952
+lock_stats 2226 4 560
+tiny_printf 2957 4 248
+tiny_no_ll 3032 4 248
+deferred 7901 76 5216
+shortest_g 10932 76 5216
+uart_sink 2083 4 816
+flash_sink 3243 4 432
+core_registry 1375 84 272
+shm_stats 2070 4 960
+ctl 5119 188 272
+hot_reload 6305 52 4448
+binary_log 3329 52 16796
@@ -0,0 +1,171 @@
+#!/bin/sh
+#
+# Compile uLog under each configuration below and report the text, data and
+# bss it costs, with the growth against the stored baseline:
+#
+#     sh tools/footprint.sh [--update] [--buffers]
+#
+# The cross toolchain is picked with CC, SIZE and NM, the flags with CFLAGS:
+#
+#     CC=arm-none-eabi-gcc SIZE=arm-none-eabi-size NM=arm-none-eabi-nm \
+#       CFLAGS="-Os -mcpu=cortex-m0plus -mthumb" sh tools/footprint.sh
+#
+# --buffers also lists, for each configuration, the static objects of 16
+# bytes or more, with the ulog_config.h setting that sizes them where there
+# is one.  --update rewrites the baseline instead of comparing against it.
+# The baseline lives in tools/footprint.baseline.<compiler>, so every
+# toolchain keeps its own; without one the report shows no deltas.  The exit
+# status is 1 when a configuration grew by more than SLACK bytes (default 0)
+# of text + data + bss.
+
+set -e
+
+root=$(dirname "$0")/..
+CC=${CC:-cc}
+SIZE=${SIZE:-size}
+NM=${NM:-nm}
+CFLAGS=${CFLAGS:--Os}
+SLACK=${SLACK:-0}
+
+update=0
+buffers=0
+for arg in "$@"; do
+  case $arg in
+    --update) update=1 ;;
+    --buffers) buffers=1 ;;
+    *) echo "usage: $0 [--update] [--buffers]" >&2; exit 2 ;;
+  esac
+done
+
+baseline=$root/tools/footprint.baseline.$(basename "$CC")
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# name, -D switches (comma separated), sources besides ulog.c.  Switches that
+# only change the logging macros (ULOG_FILE_NAME, ULOG_COLD_CALLS) cost at the
+# call sites and are not here.  The POSIX add-ons are last; a bare-metal
+# toolchain is expected to fail them.
+configs='
+disabled      ULOG_ENABLED=0
+default       -
+sites         ULOG_SITES=1
+rate_limit    ULOG_SITES=1,ULOG_SITE_RATE_LIMIT=1
+static_subs   ULOG_STATIC_SUBSCRIBERS=1
+stats         ULOG_STATS=1
+timing        ULOG_SUBSCRIBER_TIMING=1
+lock_stats    ULOG_LOCK_STATS=1
+tiny_printf   ULOG_TINY_PRINTF=1                        ulog_printf.c
+tiny_no_ll    ULOG_TINY_PRINTF=1,ULOG_PRINTF_LONG_LONG=0 ulog_printf.c
+deferred      ULOG_DEFERRED=1                           ulog_capture.c
+shortest_g    ULOG_DEFERRED=1,ULOG_SHORTEST_G=1         ulog_capture.c,ulog_dtoa.c
+uart_sink     ULOG_UART_SINK=1                          ulog_uart.c
+flash_sink    ULOG_FLASH_SINK=1                         ulog_flash.c
+core_registry ULOG_CORE_REGISTRY=1
+shm_stats     ULOG_STATS=1,ULOG_SHM_STATS=1             ulog_shm.c
+ctl           ULOG_SITES=1,ULOG_CTL=1                   ulog_ctl.c
+hot_reload    ULOG_SITES=1,ULOG_HOT_RELOAD=1            ulog_reload.c
+binary_log    ULOG_BINARY_LOG=1                         ulog_binlog.c
+'
+
+# the ulog_config.h setting that sizes a static object, where there is one
+setting() {
+  case $1 in
+    ulog_config.subscribers) echo "ULOG_MAX_SUBSCRIBERS, ULOG_ASYNC_QUEUE_DEPTH" ;;
+    ulog_config.msg|message.*|ulog_flash) echo ULOG_MAX_MESSAGE_LENGTH ;;
+    ulog_config.lock_stats)  echo ULOG_HISTOGRAM_BUCKETS ;;
+    ulog_config.ring)        echo ULOG_DEFERRED_BUFFER_SIZE ;;
+    ulog_config.record|record.*) echo ULOG_DEFERRED_RECORD_SIZE ;;
+    compiled)                echo "ULOG_FORMAT_CACHE, ULOG_FORMAT_STEPS" ;;
+    static_ranges)           echo ULOG_STATIC_RANGES ;;
+    ulog_uart)               echo ULOG_UART_BUFFER_SIZE ;;
+    *)                       echo ;;
+  esac
+}
+
+# the members of ulog_config in ulog.c, one sized global each: the
+# preprocessor lines are kept, so only the members of this configuration
+# are there, and nm reads the sizes without running anything on the target
+members() {
+  printf '#include "ulog.c"\n#if (ULOG_ENABLED == 1)\n'
+  sed -n '/^static struct {/,/^} ulog_config;/p' "$root/src/ulog.c" |
+    sed '1d;$d; s://.*::' |
+    awk '/^#/ { print; next }
+         /;/  { sub(/\[.*/, ""); sub(/;.*/, ""); gsub(/\*/, " ");
+                n = split($0, w, " ");
+                printf "char ulog_config_%s[sizeof(ulog_config.%s)];\n", w[n], w[n] }'
+  echo '#endif'
+}
+
+report=$work/report
+failed=0
+printf '%-14s %8s %8s %8s %8s %8s\n' config text data bss total delta
+echo "$configs" | while read -r name defines sources; do
+  [ -n "$name" ] || continue
+  flags=
+  if [ "$defines" != - ]; then
+    flags=$(echo "$defines" | sed 's/^/-D/; s/,/ -D/g')
+  fi
+  objects=
+  for src in ulog.c $(echo "$sources" | tr , ' '); do
+    obj=$work/$name.${src%.c}.o
+    # shellcheck disable=SC2086
+    if ! $CC $CFLAGS $flags -I"$root/src" -I"$root/bench" \
+         -c "$root/src/$src" -o "$obj" 2>"$work/errors"; then
+      printf '%-14s does not build: %s\n' "$name" "$(head -1 "$work/errors")"
+      continue 2
+    fi
+    objects="$objects $obj"
+  done
+  # shellcheck disable=SC2086
+  set -- $($SIZE -t $objects | tail -1)
+  text=$1 data=$2 bss=$3 total=$(($1 + $2 + $3))
+  echo "$name $text $data $bss" >> "$report"
+
+  delta=
+  if [ $update = 0 ] && [ -f "$baseline" ]; then
+    old=$(awk -v n="$name" '$1 == n { print $2 + $3 + $4 }' "$baseline")
+    if [ -n "$old" ]; then
+      delta=$((total - old))
+      [ $delta -gt 0 ] && delta=+$delta
+      [ $((total - old)) -gt "$SLACK" ] && echo "$name" >> "$work/grew"
+    else
+      delta=new
+    fi
+  fi
+  printf '%-14s %8d %8d %8d %8d %8s\n' "$name" "$text" "$data" "$bss" "$total" "$delta"
+
+  if [ $buffers = 1 ]; then
+    members > "$work/members.c"
+    # shellcheck disable=SC2086
+    $CC $CFLAGS $flags -I"$root/src" -I"$root/bench" \
+      -c "$work/members.c" -o "$work/members.o"
+    {
+      $NM -S --size-sort "$work/members.o" | grep ' ulog_config_' |
+        sed 's/ ulog_config_/ ulog_config./'
+      # shellcheck disable=SC2086
+      $NM -S --size-sort $objects | grep -v ' ulog_config$'
+    } | while read -r _ size type symbol; do
+      case $type in
+        b|B|d|D|C) ;;
+        *) continue ;;
+      esac
+      bytes=$(printf '%d' "0x$size")
+      [ "$bytes" -ge 16 ] || continue
+      printf '    %-28s %6d  %s\n' "$symbol" "$bytes" "$(setting "$symbol")"
+    done
+  fi
+done
+
+if [ $update = 1 ]; then
+  {
+    echo "# tools/footprint.sh --update, CFLAGS=$CFLAGS"
+    echo "# $($CC --version | head -1)"
+    echo "# config text data bss"
+    cat "$report"
+  } > "$baseline"
+  echo "baseline written to $baseline"
+elif [ -f "$work/grew" ]; then
+  echo "grew beyond SLACK=$SLACK bytes: $(tr '\n' ' ' < "$work/grew")"
+  failed=1
+fi
+exit $failed
@@ -0,0 +1,1313 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog-columnar.c
+ *
+ * \brief turn binary logs into a columnar archive, and query the archive
+ *
+ * Build:
+ *
+ *     cc -O2 -DULOG_BINARY_LOG=1 -Isrc tools/ulog-columnar.c src/ulog_binlog.c \
+ *        src/ulog.c -o ulog-columnar
+ *
+ * Usage:
+ *
+ *     ulog-columnar convert [--fields F[,F...]] <binary log> <archive>
+ *     ulog-columnar query <archive> [--since T] [--until T] [--level L]
+ *         [--file S] [--thread N] [--grep S] [--word W] [--field F=V]
+ *         [--by K[,K...]] [--print]
+ *
+ * convert reads what ulog_binlog_logger() wrote (see ulog_binlog.h).  query
+ * counts the messages that pass every filter given, counts them per group
+ * with --by, or prints them with --print.  T is UTC, 2026-10-18 or
+ * 2026-10-18T13:05:00 (to any precision), or seconds since the epoch; --since
+ * is inclusive, --until is not.  --level keeps that level and above, --file
+ * the call sites whose file name contains S, --grep the messages that
+ * contain S, --word those with the word W (letters, digits, _ and -), and
+ * --field those where F=V appears, as in "request=8f3a tenant=acme";
+ * --word and --field may be repeated.  The group keys are hour, day, file,
+ * site, level and thread, at most three of them:
+ *
+ *     ulog-columnar query app.ulc --level error --by file,hour
+ *
+ * The archive holds chunks of up to CHUNK_ROWS messages.  Each column of a
+ * chunk is compressed on its own, so a query decodes only the columns its
+ * filters and keys use, and skips chunks outside --since and --until from
+ * the directory alone.  Filters run a column at a time over a selection
+ * vector of row numbers.
+ *
+ * Every chunk also has a bloom filter over the words of its messages and over
+ * the F=V pairs of the fields named with convert --fields.  A chunk whose
+ * filter lacks a --word, an indexed --field, or a whole word inside the
+ * --grep text is skipped without decoding it.  The filters cost
+ * BLOOM_BITS_PER_TOKEN bits per distinct token, at most BLOOM_MAX bytes a
+ * chunk, and are built by convert alone: logging does not pay for them.
+ * convert reports their size and the time spent building them.
+ *
+ *     file:    "ULOGCOL2", chunks, directory, u64 directory offset, "ULOGCOL2"
+ *     chunk:   the five columns, then the bloom filter
+ *     directory: sites (id, line, length, file name), indexed field names
+ *              (length, name) and chunks (offset, rows, first and last time,
+ *              size of each column, size of the bloom filter), in varints
+ *     time:    varint first time, then zigzag varint differences
+ *     level:   runs: u8 level, varint count
+ *     site:    varint id per row, 0 when no site record gave the id
+ *     thread:  runs: varint thread, varint count
+ *     text:    per row: varint bytes shared with the previous message of the
+ *              same site in the chunk, varint count of the rest, the rest
+ *     bloom:   BLOOM_HASHES bits set per token, by double hashing
+ *
+ * Times are microseconds since the epoch.  Everything stays in local files;
+ * there is no server.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ulog_binlog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include <time.h>
+
+#define MAGIC "ULOGCOL2"
+#define MAGIC_SIZE 8
+#define CHUNK_ROWS 8192
+#define PREFIX_SLOTS 256          // sites whose previous message is kept
+#define KEYS_MAX 3
+#define FIELDS_MAX 8              // fields indexed by convert
+#define TERMS_MAX 8               // --word and --field of a query
+#define BLOOM_BITS_PER_TOKEN 10   // about 1% false positives
+#define BLOOM_HASHES 7
+#define BLOOM_MAX 65536           // bytes, for a chunk of many distinct tokens
+
+enum { TIME, LEVEL, SITE, THREAD, TEXT, COLUMNS };
+
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+} buffer_t;
+
+typedef struct {
+  uint32_t id;
+  uint32_t line;
+  char *file;
+  int file_index;           // same for every site of one file
+} site_t;
+
+typedef struct {
+  uint64_t offset;
+  uint32_t rows;
+  uint64_t time_min;
+  uint64_t time_max;
+  uint32_t sizes[COLUMNS];
+  uint32_t bloom_size;      // bytes, after the columns
+} chunk_t;
+
+// the rows of one chunk, column by column
+typedef struct {
+  uint32_t count;
+  uint64_t time[CHUNK_ROWS];
+  uint8_t level[CHUNK_ROWS];
+  uint32_t site[CHUNK_ROWS];
+  uint32_t thread[CHUNK_ROWS];
+  uint32_t text[CHUNK_ROWS];      // offsets in texts
+  uint32_t length[CHUNK_ROWS];
+  buffer_t texts;
+} rows_t;
+
+// the previous message of a site, for the shared prefix of the text column
+typedef struct {
+  uint32_t site;
+  uint32_t text;
+  uint32_t length;
+} prefix_t;
+
+typedef enum { TOKEN_WORD, TOKEN_FIELD } token_kind_t;
+
+typedef void (*token_fn_t)(token_kind_t kind, const char *token, size_t len, void *arg);
+
+// a --word or --field of a query
+typedef struct {
+  token_kind_t kind;
+  const char *text;
+} term_t;
+
+typedef enum { KEY_HOUR, KEY_DAY, KEY_FILE, KEY_SITE, KEY_LEVEL, KEY_THREAD } group_key_t;
+
+typedef struct {
+  uint64_t keys[KEYS_MAX];
+  uint64_t count;
+  bool used;
+} group_t;
+
+static const char *key_names[] = { "hour", "day", "file", "site", "level", "thread" };
+
+static struct {
+  site_t *sites;
+  int site_count;
+  uint32_t max_site;
+  chunk_t *chunks;
+  int chunk_count;
+  char *fields[FIELDS_MAX];
+  int field_count;
+  uint8_t *data;            // the archive, when querying
+  size_t size;
+} archive;
+
+// the token hashes of the chunk being written, and what indexing them cost
+static struct {
+  uint64_t *hashes;
+  size_t count;
+  size_t capacity;
+  uint64_t bytes;
+  uint64_t ns;
+} bloom;
+
+static rows_t rows;
+
+// =============================================================================
+// encoding
+
+static void *grow(void *p, size_t size) {
+  p = realloc(p, size);
+  if (p == NULL) {
+    fprintf(stderr, "ulog-columnar: out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+static void append(buffer_t *b, const void *data, size_t len) {
+  if (b->size + len > b->capacity) {
+    b->capacity = (b->size + len) * 2;
+    b->data = grow(b->data, b->capacity);
+  }
+  memcpy(&b->data[b->size], data, len);
+  b->size += len;
+}
+
+static void put_varint(buffer_t *b, uint64_t value) {
+  uint8_t bytes[10];
+  int n = 0;
+  while (value >= 0x80) {
+    bytes[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  bytes[n++] = (uint8_t)value;
+  append(b, bytes, n);
+}
+
+static bool get_varint(const uint8_t **p, const uint8_t *end, uint64_t *value) {
+  *value = 0;
+  for (int shift = 0; *p < end && shift < 64; shift += 7) {
+    uint8_t byte = *(*p)++;
+    *value |= (uint64_t)(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint64_t zigzag(int64_t value) {
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static bool word_char(char c) {
+  return isalnum((unsigned char)c) || c == '_' || c == '-';
+}
+
+static bool value_char(char c) {
+  return !isspace((unsigned char)c) && c != ',' && c != ';' && c != '\0';
+}
+
+// call fn for every word of text, and for every F=V where F is a word and V
+// a run of characters other than blanks, commas and semicolons.  The words
+// of V count as words too.
+static void tokenize(const char *text, size_t len, token_fn_t fn, void *arg) {
+  size_t i = 0;
+  while (i < len) {
+    if (!word_char(text[i])) {
+      i++;
+      continue;
+    }
+    size_t start = i;
+    while (i < len && word_char(text[i])) {
+      i++;
+    }
+    fn(TOKEN_WORD, &text[start], i - start, arg);
+    if (i < len && text[i] == '=') {
+      size_t end = i + 1;
+      while (end < len && value_char(text[end])) {
+        end++;
+      }
+      if (end > i + 1) {
+        fn(TOKEN_FIELD, &text[start], end - start, arg);
+      }
+      i++;
+    }
+  }
+}
+
+// FNV-1a, then the splitmix64 finalizer for well mixed high bits
+static uint64_t hash_token(const char *token, size_t len) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (size_t i=0; i<len; i++) {
+    h = (h ^ (uint8_t)token[i]) * 0x100000001b3ull;
+  }
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+  return h ^ (h >> 31);
+}
+
+// the field name of an F=V token, if convert --fields named it
+static bool indexed_field(const char *token, size_t len) {
+  const char *equals = memchr(token, '=', len);
+  size_t name = (size_t)(equals - token);
+  for (int i=0; i<archive.field_count; i++) {
+    if (strlen(archive.fields[i]) == name && memcmp(archive.fields[i], token, name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void collect_token(token_kind_t kind, const char *token, size_t len, void *arg) {
+  (void)arg;
+  if (kind == TOKEN_FIELD && !indexed_field(token, len)) {
+    return;
+  }
+  if (bloom.count == bloom.capacity) {
+    bloom.capacity = bloom.capacity ? 2 * bloom.capacity : 65536;
+    bloom.hashes = grow(bloom.hashes, bloom.capacity * sizeof(uint64_t));
+  }
+  bloom.hashes[bloom.count++] = hash_token(token, len);
+}
+
+static void bloom_bits(uint64_t hash, uint64_t bits, uint64_t *positions) {
+  uint64_t step = (hash >> 32) | 1;
+  for (int i=0; i<BLOOM_HASHES; i++) {
+    positions[i] = (hash + i * step) % bits;
+  }
+}
+
+static bool bloom_has(const uint8_t *filter, uint32_t size, uint64_t hash) {
+  uint64_t positions[BLOOM_HASHES];
+  bloom_bits(hash, (uint64_t)size * 8, positions);
+  for (int i=0; i<BLOOM_HASHES; i++) {
+    if (!(filter[positions[i] / 8] & (1 << (positions[i] % 8)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static int compare_hashes(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+// the filter over the tokens collected for the chunk, sized to the distinct ones
+static void build_bloom(buffer_t *filter) {
+  qsort(bloom.hashes, bloom.count, sizeof(uint64_t), compare_hashes);
+  size_t distinct = 0;
+  for (size_t i=0; i<bloom.count; i++) {
+    distinct += (i == 0 || bloom.hashes[i] != bloom.hashes[i - 1]);
+  }
+  size_t size = (distinct * BLOOM_BITS_PER_TOKEN + 63) / 64 * 8;
+  size = (size < 8) ? 8 : (size > BLOOM_MAX) ? BLOOM_MAX : size;
+  filter->data = grow(NULL, size);
+  filter->size = filter->capacity = size;
+  memset(filter->data, 0, size);
+  for (size_t i=0; i<bloom.count; i++) {
+    uint64_t positions[BLOOM_HASHES];
+    bloom_bits(bloom.hashes[i], (uint64_t)size * 8, positions);
+    for (int j=0; j<BLOOM_HASHES; j++) {
+      filter->data[positions[j] / 8] |= (uint8_t)(1 << (positions[j] % 8));
+    }
+  }
+  bloom.count = 0;
+}
+
+static uint64_t now_ns() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// bytes a and b have in common at their start
+static uint32_t common(const uint8_t *a, uint32_t a_len, const uint8_t *b, uint32_t b_len) {
+  uint32_t n = 0;
+  while (n < a_len && n < b_len && a[n] == b[n]) {
+    n++;
+  }
+  return n;
+}
+
+static void encode(buffer_t *columns) {
+  static prefix_t prefixes[PREFIX_SLOTS];
+  memset(prefixes, 0, sizeof(prefixes));
+
+  for (uint32_t i=0; i<rows.count; i++) {
+    if (i == 0) {
+      put_varint(&columns[TIME], rows.time[0]);
+    } else {
+      put_varint(&columns[TIME], zigzag((int64_t)(rows.time[i] - rows.time[i - 1])));
+    }
+    put_varint(&columns[SITE], rows.site[i]);
+
+    const uint8_t *text = &rows.texts.data[rows.text[i]];
+    prefix_t *prefix = &prefixes[rows.site[i] % PREFIX_SLOTS];
+    uint32_t shared = 0;
+    if (prefix->site == rows.site[i] && prefix->length > 0) {
+      shared = common(&rows.texts.data[prefix->text], prefix->length, text, rows.length[i]);
+    }
+    put_varint(&columns[TEXT], shared);
+    put_varint(&columns[TEXT], rows.length[i] - shared);
+    append(&columns[TEXT], &text[shared], rows.length[i] - shared);
+    prefix->site = rows.site[i];
+    prefix->text = rows.text[i];
+    prefix->length = rows.length[i];
+  }
+  for (uint32_t i=0; i<rows.count; ) {
+    uint32_t run = 1;
+    while (i + run < rows.count && rows.level[i + run] == rows.level[i]) {
+      run++;
+    }
+    append(&columns[LEVEL], &rows.level[i], 1);
+    put_varint(&columns[LEVEL], run);
+    i += run;
+  }
+  for (uint32_t i=0; i<rows.count; ) {
+    uint32_t run = 1;
+    while (i + run < rows.count && rows.thread[i + run] == rows.thread[i]) {
+      run++;
+    }
+    put_varint(&columns[THREAD], rows.thread[i]);
+    put_varint(&columns[THREAD], run);
+    i += run;
+  }
+}
+
+static void write_chunk(FILE *out, uint64_t *offset) {
+  buffer_t columns[COLUMNS];
+  chunk_t chunk;
+
+  memset(columns, 0, sizeof(columns));
+  encode(columns);
+  chunk.offset = *offset;
+  chunk.rows = rows.count;
+  chunk.time_min = chunk.time_max = rows.time[0];
+  for (uint32_t i=1; i<rows.count; i++) {
+    chunk.time_min = (rows.time[i] < chunk.time_min) ? rows.time[i] : chunk.time_min;
+    chunk.time_max = (rows.time[i] > chunk.time_max) ? rows.time[i] : chunk.time_max;
+  }
+  for (int c=0; c<COLUMNS; c++) {
+    fwrite(columns[c].data, 1, columns[c].size, out);
+    chunk.sizes[c] = (uint32_t)columns[c].size;
+    *offset += columns[c].size;
+    free(columns[c].data);
+  }
+  buffer_t filter;
+  uint64_t start = now_ns();
+  build_bloom(&filter);
+  bloom.ns += now_ns() - start;
+  fwrite(filter.data, 1, filter.size, out);
+  chunk.bloom_size = (uint32_t)filter.size;
+  *offset += filter.size;
+  bloom.bytes += filter.size;
+  free(filter.data);
+  archive.chunks = grow(archive.chunks, (archive.chunk_count + 1) * sizeof(chunk_t));
+  archive.chunks[archive.chunk_count++] = chunk;
+  rows.count = 0;
+  rows.texts.size = 0;
+}
+
+static void write_directory(FILE *out, uint64_t offset) {
+  buffer_t b = { NULL, 0, 0 };
+  uint8_t tail[8];
+
+  put_varint(&b, archive.site_count);
+  for (int i=0; i<archive.site_count; i++) {
+    const site_t *site = &archive.sites[i];
+    size_t length = strlen(site->file);
+    put_varint(&b, site->id);
+    put_varint(&b, site->line);
+    put_varint(&b, length);
+    append(&b, site->file, length);
+  }
+  put_varint(&b, archive.field_count);
+  for (int i=0; i<archive.field_count; i++) {
+    size_t length = strlen(archive.fields[i]);
+    put_varint(&b, length);
+    append(&b, archive.fields[i], length);
+  }
+  put_varint(&b, archive.chunk_count);
+  for (int i=0; i<archive.chunk_count; i++) {
+    const chunk_t *chunk = &archive.chunks[i];
+    put_varint(&b, chunk->offset);
+    put_varint(&b, chunk->rows);
+    put_varint(&b, chunk->time_min);
+    put_varint(&b, chunk->time_max);
+    for (int c=0; c<COLUMNS; c++) {
+      put_varint(&b, chunk->sizes[c]);
+    }
+    put_varint(&b, chunk->bloom_size);
+  }
+  for (int i=0; i<8; i++) {
+    tail[i] = (uint8_t)(offset >> (8 * i));
+  }
+  append(&b, tail, sizeof(tail));
+  append(&b, MAGIC, MAGIC_SIZE);
+  fwrite(b.data, 1, b.size, out);
+  free(b.data);
+}
+
+static int convert(const char *in_path, const char *out_path) {
+  static ulog_binlog_record_t record;
+  static uint8_t seen[ULOG_BINLOG_SITES / 8 + 1];  // by id: site record kept
+  uint64_t messages = 0;
+  uint64_t unknown = 0;
+  int status;
+
+  FILE *in = fopen(in_path, "rb");
+  if (in == NULL) {
+    perror(in_path);
+    return 1;
+  }
+  if (!ulog_binlog_check(in)) {
+    fprintf(stderr, "ulog-columnar: %s is not a uLog binary log\n", in_path);
+    return 1;
+  }
+  FILE *out = fopen(out_path, "wb");
+  if (out == NULL) {
+    perror(out_path);
+    return 1;
+  }
+  fwrite(MAGIC, 1, MAGIC_SIZE, out);
+  uint64_t offset = MAGIC_SIZE;
+
+  while ((status = ulog_binlog_read(in, &record)) == 1) {
+    bool known = (record.site > 0 && record.site <= ULOG_BINLOG_SITES &&
+                  (seen[record.site / 8] & (1u << (record.site % 8))) != 0);
+    if (record.type == ULOG_BINLOG_CHUNK ||
+        (record.type == ULOG_BINLOG_SITE && (known || record.site == 0 ||
+                                             record.site > ULOG_BINLOG_SITES))) {
+      continue;             // a new chunk, a site repeated in it, or a bad id
+    }
+    if (record.type == ULOG_BINLOG_SITE) {
+      seen[record.site / 8] |= (uint8_t)(1u << (record.site % 8));
+      archive.sites = grow(archive.sites, (archive.site_count + 1) * sizeof(site_t));
+      site_t *site = &archive.sites[archive.site_count++];
+      site->id = record.site;
+      site->line = record.line;
+      site->file = strdup(record.text);
+      continue;
+    }
+    uint32_t i = rows.count++;
+    rows.time[i] = record.time_us;
+    rows.level[i] = (uint8_t)record.level;
+    rows.site[i] = known ? record.site : 0;   // 0: no site record seen
+    unknown += (record.site != 0 && !known);
+    rows.thread[i] = record.thread;
+    rows.text[i] = (uint32_t)rows.texts.size;
+    rows.length[i] = (uint32_t)record.length;
+    append(&rows.texts, record.text, record.length);
+    uint64_t start = now_ns();
+    tokenize(record.text, record.length, collect_token, NULL);
+    bloom.ns += now_ns() - start;
+    messages++;
+    if (rows.count == CHUNK_ROWS) {
+      write_chunk(out, &offset);
+    }
+  }
+  if (status < 0) {
+    fprintf(stderr, "ulog-columnar: %s is cut short or damaged after %llu messages\n",
+            in_path, (unsigned long long)messages);
+  }
+  if (unknown > 0) {
+    fprintf(stderr, "ulog-columnar: %llu messages name a site never described, "
+            "stored without one\n", (unsigned long long)unknown);
+  }
+  if (rows.count > 0) {
+    write_chunk(out, &offset);
+  }
+  write_directory(out, offset);
+  long in_size = ftell(in);
+  long out_size = ftell(out);
+  fclose(in);
+  if (fclose(out) != 0) {
+    perror(out_path);
+    return 1;
+  }
+  fprintf(stderr, "%llu messages, %d sites, %d chunks: %ld bytes to %ld\n",
+          (unsigned long long)messages, archive.site_count, archive.chunk_count,
+          in_size, out_size);
+  fprintf(stderr, "bloom filters: %llu bytes, built in %.1f ms\n",
+          (unsigned long long)bloom.bytes, bloom.ns / 1e6);
+  return 0;
+}
+
+// =============================================================================
+// decoding
+
+static bool load(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    perror(path);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  archive.size = (size_t)ftell(file);
+  fseek(file, 0, SEEK_SET);
+  archive.data = grow(NULL, archive.size + 1);
+  bool ok = fread(archive.data, 1, archive.size, file) == archive.size;
+  fclose(file);
+
+  const uint8_t *end = archive.data + archive.size;
+  uint64_t offset = 0;
+  if (ok && archive.size >= 2 * MAGIC_SIZE + 8 &&
+      memcmp(archive.data, MAGIC, MAGIC_SIZE) == 0 &&
+      memcmp(end - MAGIC_SIZE, MAGIC, MAGIC_SIZE) == 0) {
+    for (int i=0; i<8; i++) {
+      offset |= (uint64_t)end[-MAGIC_SIZE - 8 + i] << (8 * i);
+    }
+  }
+  if (offset < MAGIC_SIZE || offset > archive.size - MAGIC_SIZE - 8) {
+    fprintf(stderr, "ulog-columnar: %s is not a uLog columnar archive\n", path);
+    return false;
+  }
+
+  const uint8_t *p = archive.data + offset;
+  end -= MAGIC_SIZE + 8;
+  uint64_t count, v[4];
+  ok = get_varint(&p, end, &count) && count <= ULOG_BINLOG_SITES;
+  archive.sites = grow(NULL, (count + 1) * sizeof(site_t));
+  for (uint64_t i=0; ok && i<count; i++) {
+    ok = get_varint(&p, end, &v[0]) && get_varint(&p, end, &v[1]) &&
+         get_varint(&p, end, &v[2]) && v[2] <= (uint64_t)(end - p) &&
+         v[0] > 0 && v[0] <= ULOG_BINLOG_SITES;
+    if (ok) {
+      site_t *site = &archive.sites[archive.site_count++];
+      site->id = (uint32_t)v[0];
+      site->line = (uint32_t)v[1];
+      site->file = grow(NULL, v[2] + 1);
+      memcpy(site->file, p, v[2]);
+      site->file[v[2]] = '\0';
+      site->file_index = archive.site_count - 1;
+      for (int j=0; j<archive.site_count - 1; j++) {
+        if (strcmp(archive.sites[j].file, site->file) == 0) {
+          site->file_index = archive.sites[j].file_index;
+          break;
+        }
+      }
+      archive.max_site = (site->id > archive.max_site) ? site->id : archive.max_site;
+      p += v[2];
+    }
+  }
+  ok = ok && get_varint(&p, end, &count) && count <= FIELDS_MAX;
+  for (uint64_t i=0; ok && i<count; i++) {
+    ok = get_varint(&p, end, &v[0]) && v[0] <= (uint64_t)(end - p);
+    if (ok) {
+      char *field = grow(NULL, v[0] + 1);
+      memcpy(field, p, v[0]);
+      field[v[0]] = '\0';
+      archive.fields[archive.field_count++] = field;
+      p += v[0];
+    }
+  }
+  ok = ok && get_varint(&p, end, &count);
+  archive.chunks = grow(NULL, (count + 1) * sizeof(chunk_t));
+  for (uint64_t i=0; ok && i<count; i++) {
+    chunk_t *chunk = &archive.chunks[archive.chunk_count++];
+    ok = get_varint(&p, end, &v[0]) && get_varint(&p, end, &v[1]) &&
+         get_varint(&p, end, &v[2]) && get_varint(&p, end, &v[3]) &&
+         v[1] <= CHUNK_ROWS;
+    chunk->offset = v[0];
+    chunk->rows = (uint32_t)v[1];
+    chunk->time_min = v[2];
+    chunk->time_max = v[3];
+    uint64_t total = 0;
+    for (int c=0; ok && c<COLUMNS; c++) {
+      ok = get_varint(&p, end, &v[0]);
+      chunk->sizes[c] = (uint32_t)v[0];
+      total += v[0];
+    }
+    ok = ok && get_varint(&p, end, &v[0]) && v[0] >= 8 && v[0] <= BLOOM_MAX;
+    chunk->bloom_size = (uint32_t)v[0];
+    total += v[0];
+    ok = ok && chunk->offset + total <= offset;
+  }
+  if (!ok) {
+    fprintf(stderr, "ulog-columnar: the directory of %s is damaged\n", path);
+  }
+  return ok;
+}
+
+// where column c of chunk starts and ends in the archive
+static const uint8_t *column(const chunk_t *chunk, int c, const uint8_t **end) {
+  const uint8_t *p = archive.data + chunk->offset;
+  for (int i=0; i<c; i++) {
+    p += chunk->sizes[i];
+  }
+  *end = p + chunk->sizes[c];
+  return p;
+}
+
+static bool decode_time(const chunk_t *chunk) {
+  const uint8_t *end;
+  const uint8_t *p = column(chunk, TIME, &end);
+  uint64_t v;
+  for (uint32_t i=0; i<chunk->rows; i++) {
+    if (!get_varint(&p, end, &v)) {
+      return false;
+    }
+    rows.time[i] = (i == 0) ? v : rows.time[i - 1] + (uint64_t)unzigzag(v);
+  }
+  return true;
+}
+
+static bool decode_site(const chunk_t *chunk) {
+  const uint8_t *end;
+  const uint8_t *p = column(chunk, SITE, &end);
+  uint64_t v;
+  for (uint32_t i=0; i<chunk->rows; i++) {
+    if (!get_varint(&p, end, &v) || v > archive.max_site) {
+      return false;
+    }
+    rows.site[i] = (uint32_t)v;
+  }
+  return true;
+}
+
+static bool decode_level(const chunk_t *chunk) {
+  const uint8_t *end;
+  const uint8_t *p = column(chunk, LEVEL, &end);
+  uint64_t run;
+  for (uint32_t i=0; i<chunk->rows; ) {
+    if (p >= end) {
+      return false;
+    }
+    uint8_t level = *p++;
+    if (!get_varint(&p, end, &run) || run == 0 || run > chunk->rows - i) {
+      return false;
+    }
+    memset(&rows.level[i], level, run);
+    i += (uint32_t)run;
+  }
+  return true;
+}
+
+static bool decode_thread(const chunk_t *chunk) {
+  const uint8_t *end;
+  const uint8_t *p = column(chunk, THREAD, &end);
+  uint64_t thread, run;
+  for (uint32_t i=0; i<chunk->rows; ) {
+    if (!get_varint(&p, end, &thread) || !get_varint(&p, end, &run) ||
+        run == 0 || run > chunk->rows - i) {
+      return false;
+    }
+    for (uint64_t j=0; j<run; j++) {
+      rows.thread[i++] = (uint32_t)thread;
+    }
+  }
+  return true;
+}
+
+// needs the site column.  Every text is stored NUL terminated.
+static bool decode_text(const chunk_t *chunk) {
+  static prefix_t prefixes[PREFIX_SLOTS];
+  const uint8_t *end;
+  const uint8_t *p = column(chunk, TEXT, &end);
+  uint64_t shared, rest;
+
+  memset(prefixes, 0, sizeof(prefixes));
+  rows.texts.size = 0;
+  for (uint32_t i=0; i<chunk->rows; i++) {
+    prefix_t *prefix = &prefixes[rows.site[i] % PREFIX_SLOTS];
+    if (!get_varint(&p, end, &shared) || !get_varint(&p, end, &rest) ||
+        rest > (uint64_t)(end - p) ||
+        (shared > 0 && (prefix->site != rows.site[i] || shared > prefix->length))) {
+      return false;
+    }
+    uint32_t at = (uint32_t)rows.texts.size;
+    if (shared > 0) {
+      // copied through a buffer: append() may move the data
+      char head[UINT16_MAX];
+      memcpy(head, &rows.texts.data[prefix->text], shared);
+      append(&rows.texts, head, shared);
+    }
+    append(&rows.texts, p, rest);
+    append(&rows.texts, "", 1);
+    p += rest;
+    rows.text[i] = at;
+    rows.length[i] = (uint32_t)(shared + rest);
+    prefix->site = rows.site[i];
+    prefix->text = at;
+    prefix->length = rows.length[i];
+  }
+  return true;
+}
+
+// =============================================================================
+// query
+
+typedef struct {
+  uint64_t since;
+  uint64_t until;
+  int level;                // -1: any
+  const char *file;
+  int64_t thread;           // -1: any
+  const char *grep;
+  term_t terms[TERMS_MAX];
+  int term_count;
+  group_key_t keys[KEYS_MAX];
+  int key_count;
+  bool print;
+} query_t;
+
+// the token hashes a chunk must have to hold a match
+typedef struct {
+  uint64_t hashes[TERMS_MAX + 64];
+  int count;
+} required_t;
+
+// days since 1970-01-01 of a date of the proleptic Gregorian calendar
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  unsigned yoe = (unsigned)(y - era * 400);
+  unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int64_t)doe - 719468;
+}
+
+static bool parse_time(const char *text, uint64_t *us) {
+  int y, mo, d, h = 0, mi = 0, s = 0;
+  char *end;
+  if (sscanf(text, "%d-%d-%d", &y, &mo, &d) == 3) {
+    const char *t = strchr(text, 'T');
+    if (t != NULL) {
+      sscanf(t + 1, "%d:%d:%d", &h, &mi, &s);
+    }
+    int64_t seconds = days_from_civil(y, mo, d) * 86400 + h * 3600 + mi * 60 + s;
+    *us = (uint64_t)seconds * 1000000;
+    return mo >= 1 && mo <= 12 && d >= 1 && d <= 31;
+  }
+  unsigned long long seconds = strtoull(text, &end, 10);
+  *us = seconds * 1000000;
+  return *end == '\0' && end != text;
+}
+
+static void format_time(char *buf, size_t size, uint64_t us, int fields) {
+  time_t seconds = (time_t)(us / 1000000);
+  struct tm tm;
+  gmtime_r(&seconds, &tm);
+  if (fields == 3) {
+    strftime(buf, size, "%Y-%m-%d", &tm);
+  } else if (fields == 4) {
+    strftime(buf, size, "%Y-%m-%dT%H", &tm);
+  } else {
+    int n = (int)strftime(buf, size, "%Y-%m-%dT%H:%M:%S", &tm);
+    snprintf(&buf[n], size - n, ".%06u", (unsigned)(us % 1000000));
+  }
+}
+
+static const site_t *find_site(uint32_t id) {
+  for (int i=0; i<archive.site_count; i++) {
+    if (archive.sites[i].id == id) {
+      return &archive.sites[i];
+    }
+  }
+  return NULL;
+}
+
+// the filters keep the rows of sel[0..n) that pass, in order, and return how
+// many.  No branch depends on the data.
+
+static uint32_t filter_time(uint32_t *sel, uint32_t n, uint64_t since, uint64_t until) {
+  uint32_t k = 0;
+  for (uint32_t i=0; i<n; i++) {
+    uint64_t t = rows.time[sel[i]];
+    sel[k] = sel[i];
+    k += (t >= since) & (t < until);
+  }
+  return k;
+}
+
+static uint32_t filter_level(uint32_t *sel, uint32_t n, uint8_t level) {
+  uint32_t k = 0;
+  for (uint32_t i=0; i<n; i++) {
+    sel[k] = sel[i];
+    k += rows.level[sel[i]] >= level;
+  }
+  return k;
+}
+
+static uint32_t filter_site(uint32_t *sel, uint32_t n, const uint8_t *wanted) {
+  uint32_t k = 0;
+  for (uint32_t i=0; i<n; i++) {
+    sel[k] = sel[i];
+    k += wanted[rows.site[sel[i]]];
+  }
+  return k;
+}
+
+static uint32_t filter_thread(uint32_t *sel, uint32_t n, uint32_t thread) {
+  uint32_t k = 0;
+  for (uint32_t i=0; i<n; i++) {
+    sel[k] = sel[i];
+    k += rows.thread[sel[i]] == thread;
+  }
+  return k;
+}
+
+static uint32_t filter_text(uint32_t *sel, uint32_t n, const char *grep) {
+  uint32_t k = 0;
+  for (uint32_t i=0; i<n; i++) {
+    sel[k] = sel[i];
+    k += strstr((const char *)&rows.texts.data[rows.text[sel[i]]], grep) != NULL;
+  }
+  return k;
+}
+
+// the terms found so far in one message
+typedef struct {
+  const query_t *q;
+  uint32_t found;           // bit per term
+} match_t;
+
+static void match_token(token_kind_t kind, const char *token, size_t len, void *arg) {
+  match_t *match = arg;
+  for (int t=0; t<match->q->term_count; t++) {
+    const term_t *term = &match->q->terms[t];
+    if (term->kind == kind && strlen(term->text) == len && memcmp(term->text, token, len) == 0) {
+      match->found |= 1u << t;
+    }
+  }
+}
+
+static uint32_t filter_terms(uint32_t *sel, uint32_t n, const query_t *q) {
+  uint32_t all = (1u << q->term_count) - 1;
+  uint32_t k = 0;
+  for (uint32_t i=0; i<n; i++) {
+    match_t match = { q, 0 };
+    tokenize((const char *)&rows.texts.data[rows.text[sel[i]]], rows.length[sel[i]],
+             match_token, &match);
+    sel[k] = sel[i];
+    k += match.found == all;
+  }
+  return k;
+}
+
+static void require_word(token_kind_t kind, const char *token, size_t len, void *arg) {
+  required_t *required = arg;
+  if (kind == TOKEN_WORD && required->count < (int)(sizeof(required->hashes) / sizeof(uint64_t))) {
+    required->hashes[required->count++] = hash_token(token, len);
+  }
+}
+
+// the hashes of the words and indexed fields, and of the words of grep
+// that are whole: with something other than a word character on both sides,
+// so that they are words of any message containing grep as well
+static void required_tokens(const query_t *q, required_t *required) {
+  required->count = 0;
+  for (int t=0; t<q->term_count; t++) {
+    const term_t *term = &q->terms[t];
+    size_t len = strlen(term->text);
+    if (term->kind == TOKEN_WORD || indexed_field(term->text, len)) {
+      required->hashes[required->count++] = hash_token(term->text, len);
+    }
+  }
+  if (q->grep != NULL) {
+    size_t len = strlen(q->grep);
+    size_t start = 0;
+    size_t end = len;
+    while (start < len && word_char(q->grep[start])) {
+      start++;
+    }
+    while (end > start && word_char(q->grep[end - 1])) {
+      end--;
+    }
+    tokenize(&q->grep[start], end - start, require_word, required);
+  }
+}
+
+static bool may_match(const chunk_t *chunk, const required_t *required) {
+  const uint8_t *filter = archive.data + chunk->offset;
+  for (int c=0; c<COLUMNS; c++) {
+    filter += chunk->sizes[c];
+  }
+  for (int i=0; i<required->count; i++) {
+    if (!bloom_has(filter, chunk->bloom_size, required->hashes[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static uint64_t key_of(group_key_t key, uint32_t row) {
+  switch (key) {
+  case KEY_HOUR: return rows.time[row] / 3600000000ull;
+  case KEY_DAY: return rows.time[row] / 86400000000ull;
+  case KEY_FILE: {
+    const site_t *site = find_site(rows.site[row]);
+    return (site != NULL) ? (uint64_t)site->file_index + 1 : 0;
+  }
+  case KEY_SITE: return rows.site[row];
+  case KEY_LEVEL: return rows.level[row];
+  case KEY_THREAD: return rows.thread[row];
+  }
+  return 0;
+}
+
+static void print_key(group_key_t key, uint64_t value) {
+  char buf[64];
+  const site_t *site;
+  switch (key) {
+  case KEY_HOUR: format_time(buf, sizeof(buf), value * 3600000000ull, 4); printf("%s", buf); break;
+  case KEY_DAY: format_time(buf, sizeof(buf), value * 86400000000ull, 3); printf("%s", buf); break;
+  case KEY_FILE:
+    printf("%s", (value > 0) ? archive.sites[value - 1].file : "?");
+    break;
+  case KEY_SITE:
+    site = find_site((uint32_t)value);
+    if (site != NULL) {
+      printf("%s:%u", site->file, site->line);
+    } else {
+      printf("?");
+    }
+    break;
+  case KEY_LEVEL: printf("%s", ulog_level_name((ulog_level_t)value)); break;
+  case KEY_THREAD: printf("%llu", (unsigned long long)value); break;
+  }
+}
+
+static struct {
+  group_t *slots;
+  size_t capacity;
+  size_t count;
+} groups;
+
+static group_t *find_group(const uint64_t *keys, int key_count) {
+  if (2 * (groups.count + 1) > groups.capacity) {
+    group_t *old = groups.slots;
+    size_t old_capacity = groups.capacity;
+    groups.capacity = old_capacity ? 2 * old_capacity : 1024;
+    groups.slots = calloc(groups.capacity, sizeof(group_t));
+    if (groups.slots == NULL) {
+      grow(NULL, SIZE_MAX);     // reports and exits
+    }
+    groups.count = 0;
+    for (size_t i=0; i<old_capacity; i++) {
+      if (old[i].used) {
+        group_t *group = find_group(old[i].keys, key_count);
+        group->count = old[i].count;
+      }
+    }
+    free(old);
+  }
+  uint64_t hash = 0;
+  for (int k=0; k<key_count; k++) {
+    hash = (hash ^ keys[k]) * 0x9e3779b97f4a7c15ull;
+  }
+  for (size_t i = hash >> 32; ; i++) {
+    group_t *group = &groups.slots[i % groups.capacity];
+    if (!group->used) {
+      group->used = true;
+      memcpy(group->keys, keys, sizeof(group->keys));
+      groups.count++;
+      return group;
+    }
+    if (memcmp(group->keys, keys, sizeof(group->keys)) == 0) {
+      return group;
+    }
+  }
+}
+
+static int compare_groups(const void *a, const void *b) {
+  const group_t *x = a;
+  const group_t *y = b;
+  for (int k=0; k<KEYS_MAX; k++) {
+    if (x->keys[k] != y->keys[k]) {
+      return (x->keys[k] < y->keys[k]) ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+static void print_row(uint32_t row) {
+  char when[40];
+  const site_t *site = find_site(rows.site[row]);
+  format_time(when, sizeof(when), rows.time[row], 6);
+  printf("%s %s %s:%u [%u] %s\n", when, ulog_level_name((ulog_level_t)rows.level[row]),
+         site ? site->file : "?", site ? site->line : 0, rows.thread[row],
+         (const char *)&rows.texts.data[rows.text[row]]);
+}
+
+static bool uses(const query_t *q, group_key_t key) {
+  for (int k=0; k<q->key_count; k++) {
+    if (q->keys[k] == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static int run(const query_t *q) {
+  static uint32_t sel[CHUNK_ROWS];
+  uint8_t *wanted = NULL;
+  uint64_t matched = 0;
+  int skipped = 0;
+  int filtered = 0;
+  required_t required;
+
+  required_tokens(q, &required);
+  if (q->file != NULL) {
+    wanted = calloc((size_t)archive.max_site + 1, 1);
+    for (int i=0; wanted != NULL && i<archive.site_count; i++) {
+      wanted[archive.sites[i].id] = strstr(archive.sites[i].file, q->file) != NULL;
+    }
+  }
+  bool need_time = q->since > 0 || q->until < UINT64_MAX || uses(q, KEY_HOUR) ||
+                   uses(q, KEY_DAY) || q->print;
+  bool need_level = q->level >= 0 || uses(q, KEY_LEVEL) || q->print;
+  bool need_text = q->grep != NULL || q->term_count > 0 || q->print;
+  bool need_site = q->file != NULL || uses(q, KEY_FILE) || uses(q, KEY_SITE) || need_text;
+  bool need_thread = q->thread >= 0 || uses(q, KEY_THREAD) || q->print;
+
+  for (int c=0; c<archive.chunk_count; c++) {
+    const chunk_t *chunk = &archive.chunks[c];
+    if (chunk->time_max < q->since || chunk->time_min >= q->until) {
+      skipped++;
+      continue;
+    }
+    if (!may_match(chunk, &required)) {
+      filtered++;
+      continue;
+    }
+    uint32_t n = chunk->rows;
+    for (uint32_t i=0; i<n; i++) {
+      sel[i] = i;
+    }
+    bool ok = true;
+    if (need_time) {
+      ok = decode_time(chunk);
+      n = filter_time(sel, n, q->since, q->until);
+    }
+    if (ok && need_level) {
+      ok = decode_level(chunk);
+      n = (q->level >= 0) ? filter_level(sel, n, (uint8_t)q->level) : n;
+    }
+    if (ok && need_site) {
+      ok = decode_site(chunk);
+      n = (wanted != NULL) ? filter_site(sel, n, wanted) : n;
+    }
+    if (ok && need_thread) {
+      ok = decode_thread(chunk);
+      n = (q->thread >= 0) ? filter_thread(sel, n, (uint32_t)q->thread) : n;
+    }
+    if (ok && need_text) {
+      ok = decode_text(chunk);
+      n = (q->grep != NULL) ? filter_text(sel, n, q->grep) : n;
+      n = (q->term_count > 0) ? filter_terms(sel, n, q) : n;
+    }
+    if (!ok) {
+      fprintf(stderr, "ulog-columnar: chunk %d is damaged\n", c);
+      continue;
+    }
+    matched += n;
+    for (uint32_t i=0; i<n && (q->print || q->key_count > 0); i++) {
+      if (q->print) {
+        print_row(sel[i]);
+        continue;
+      }
+      uint64_t keys[KEYS_MAX] = { 0 };
+      for (int k=0; k<q->key_count; k++) {
+        keys[k] = key_of(q->keys[k], sel[i]);
+      }
+      find_group(keys, q->key_count)->count++;
+    }
+  }
+  free(wanted);
+
+  if (q->key_count > 0 && !q->print) {
+    group_t *list = grow(NULL, (groups.count + 1) * sizeof(group_t));
+    size_t count = 0;
+    for (size_t i=0; i<groups.capacity; i++) {
+      if (groups.slots[i].used) {
+        list[count++] = groups.slots[i];
+      }
+    }
+    qsort(list, count, sizeof(group_t), compare_groups);
+    for (int k=0; k<q->key_count; k++) {
+      printf("%s\t", key_names[q->keys[k]]);
+    }
+    printf("count\n");
+    for (size_t i=0; i<count; i++) {
+      for (int k=0; k<q->key_count; k++) {
+        print_key(q->keys[k], list[i].keys[k]);
+        printf("\t");
+      }
+      printf("%llu\n", (unsigned long long)list[i].count);
+    }
+    free(list);
+  } else if (!q->print) {
+    printf("%llu\n", (unsigned long long)matched);
+  }
+  fprintf(stderr, "%d of %d chunks read (%d skipped by time, %d by bloom filter), "
+          "%llu messages matched\n", archive.chunk_count - skipped - filtered,
+          archive.chunk_count, skipped, filtered, (unsigned long long)matched);
+  return 0;
+}
+
+static bool parse_keys(const char *list, query_t *q) {
+  char copy[128];
+  snprintf(copy, sizeof(copy), "%s", list);
+  for (char *name = strtok(copy, ","); name != NULL; name = strtok(NULL, ",")) {
+    int k = 0;
+    while (k < (int)(sizeof(key_names) / sizeof(key_names[0])) && strcmp(name, key_names[k]) != 0) {
+      k++;
+    }
+    if (k == (int)(sizeof(key_names) / sizeof(key_names[0])) || q->key_count == KEYS_MAX) {
+      return false;
+    }
+    q->keys[q->key_count++] = (group_key_t)k;
+  }
+  return true;
+}
+
+// a --word W, or a --field F=V, which must read back as that one token
+static bool add_term(query_t *q, bool word, const char *text) {
+  size_t len = strlen(text);
+  size_t i = 0;
+  while (i < len && word_char(text[i])) {
+    i++;
+  }
+  term_t *term = &q->terms[q->term_count];
+  term->kind = word ? TOKEN_WORD : TOKEN_FIELD;
+  term->text = text;
+  if (word ? (i == 0 || i != len) : (i == 0 || text[i] != '=' || i + 1 == len)) {
+    return false;
+  }
+  for (size_t j=i+1; !word && j<len; j++) {
+    if (!value_char(text[j])) {
+      return false;
+    }
+  }
+  q->term_count++;
+  return true;
+}
+
+static int query(int argc, char **argv) {
+  query_t q;
+  memset(&q, 0, sizeof(q));
+  q.until = UINT64_MAX;
+  q.level = -1;
+  q.thread = -1;
+
+  for (int i=1; i<argc; i++) {
+    const char *arg = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    bool ok = true;
+    if (strcmp(arg, "--print") == 0) {
+      q.print = true;
+      continue;
+    } else if (value == NULL) {
+      ok = false;
+    } else if (strcmp(arg, "--since") == 0) {
+      ok = parse_time(value, &q.since);
+    } else if (strcmp(arg, "--until") == 0) {
+      ok = parse_time(value, &q.until);
+    } else if (strcmp(arg, "--level") == 0) {
+      q.level = (int)ulog_level_parse(value);
+      ok = q.level < ULOG_LEVEL_N;
+    } else if (strcmp(arg, "--file") == 0) {
+      q.file = value;
+    } else if (strcmp(arg, "--thread") == 0) {
+      q.thread = atoll(value);
+    } else if (strcmp(arg, "--grep") == 0) {
+      q.grep = value;
+    } else if (strcmp(arg, "--word") == 0 || strcmp(arg, "--field") == 0) {
+      ok = q.term_count < TERMS_MAX && add_term(&q, arg[2] == 'w', value);
+    } else if (strcmp(arg, "--by") == 0) {
+      ok = parse_keys(value, &q);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      fprintf(stderr, "ulog-columnar: bad option %s %s\n", arg, value ? value : "");
+      return 2;
+    }
+    i++;
+  }
+  if (!load(argv[0])) {
+    return 1;
+  }
+  return run(&q);
+}
+
+// the comma separated field names of convert --fields
+static bool parse_fields(char *list) {
+  for (char *name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+    size_t i = 0;
+    while (word_char(name[i])) {
+      i++;
+    }
+    if (i == 0 || name[i] != '\0' || archive.field_count == FIELDS_MAX) {
+      return false;
+    }
+    archive.fields[archive.field_count++] = name;
+  }
+  return archive.field_count > 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc == 4 && strcmp(argv[1], "convert") == 0) {
+    return convert(argv[2], argv[3]);
+  }
+  if (argc == 6 && strcmp(argv[1], "convert") == 0 && strcmp(argv[2], "--fields") == 0) {
+    if (!parse_fields(argv[3])) {
+      fprintf(stderr, "ulog-columnar: bad --fields %s (at most %d names)\n", argv[3], FIELDS_MAX);
+      return 2;
+    }
+    return convert(argv[4], argv[5]);
+  }
+  if (argc >= 3 && strcmp(argv[1], "query") == 0) {
+    return query(argc - 2, &argv[2]);
+  }
+  fprintf(stderr, "usage: %s convert [--fields F[,F...]] <binary log> <archive>\n"
+                  "       %s query <archive> [--since T] [--until T] [--level L]\n"
+                  "           [--file S] [--thread N] [--grep S] [--word W] [--field F=V]\n"
+                  "           [--by K[,K...]] [--print]\n",
+          argv[0], argv[0]);
+  return 2;
+}
@@ -0,0 +1,482 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog-core.c
+ *
+ * \brief print the messages a crashed process still held, from its core file
+ *
+ * The process must be built with ULOG_CORE_REGISTRY (see ulog_core.h).  Build
+ * the tool with the same ulog_config.h settings, for the same ABI:
+ *
+ *     cc -O2 -DULOG_CORE_REGISTRY=1 -DULOG_DEFERRED=1 -Isrc \
+ *        tools/ulog-core.c src/ulog.c src/ulog_capture.c -o ulog-core
+ *
+ * Usage:
+ *
+ *     ulog-core <core> [executable]
+ *
+ * Printed in order: the messages queued for each demoted subscriber, the
+ * deferred ring from oldest to newest record, and the last message uLog
+ * formatted.  Deferred records are rendered here from their captured
+ * arguments.  Formats, file names and static strings live in the read-only
+ * segments of the program, which a core file usually leaves out; they are
+ * read from the files the core says were mapped there, or from executable
+ * when it is given (a copy of the program, or one with its symbols).
+ */
+
+#include "ulog_core.h"
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (ULOG_DEFERRED == 1)
+#include "ulog_capture.h"
+#endif
+
+#if UINTPTR_MAX > 0xffffffffu
+#define ELF_CLASS ELFCLASS64
+typedef Elf64_Ehdr ehdr_t;
+typedef Elf64_Phdr phdr_t;
+typedef Elf64_Nhdr nhdr_t;
+#else
+#define ELF_CLASS ELFCLASS32
+typedef Elf32_Ehdr ehdr_t;
+typedef Elf32_Phdr phdr_t;
+typedef Elf32_Nhdr nhdr_t;
+#endif
+
+#define STRING_MAX 1024
+
+// a file mapped into the process, from the NT_FILE note
+typedef struct {
+  uintptr_t start;
+  uintptr_t end;
+  unsigned long offset;     // in the file
+  const char *path;
+  FILE *file;               // opened on first use
+} mapping_t;
+
+// a string of the process, copied out once
+typedef struct string {
+  uintptr_t address;
+  char *text;
+  struct string *next;
+} string_t;
+
+static struct {
+  uint8_t *data;            // the whole core file
+  size_t size;
+  const phdr_t *segments;
+  int segment_count;
+  mapping_t *mappings;
+  int mapping_count;
+  const char *executable;
+  string_t *strings;
+} core;
+
+static const char *base_name(const char *path) {
+  const char *slash = strrchr(path, '/');
+  return (slash != NULL) ? slash + 1 : path;
+}
+
+static bool load(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    perror(path);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  core.size = (size_t)ftell(file);
+  fseek(file, 0, SEEK_SET);
+  core.data = malloc(core.size);
+  bool ok = core.data != NULL && fread(core.data, 1, core.size, file) == core.size;
+  fclose(file);
+  if (!ok) {
+    fprintf(stderr, "ulog-core: cannot read %s\n", path);
+    return false;
+  }
+
+  const ehdr_t *ehdr = (const ehdr_t *)core.data;
+  if (core.size < sizeof(*ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+      ehdr->e_ident[EI_CLASS] != ELF_CLASS || ehdr->e_type != ET_CORE ||
+      ehdr->e_phoff > core.size ||
+      (size_t)ehdr->e_phnum * sizeof(phdr_t) > core.size - ehdr->e_phoff) {
+    fprintf(stderr, "ulog-core: %s is not a core file of this ABI\n", path);
+    return false;
+  }
+  core.segments = (const phdr_t *)(core.data + ehdr->e_phoff);
+  core.segment_count = ehdr->e_phnum;
+  return true;
+}
+
+// true if the bytes of the segment are all in the core file
+static bool in_core(const phdr_t *phdr) {
+  return phdr->p_offset <= core.size && phdr->p_filesz <= core.size - phdr->p_offset;
+}
+
+// word i of the note description at desc, which may not be aligned
+static unsigned long note_word(size_t desc, unsigned long i) {
+  unsigned long word;
+  memcpy(&word, core.data + desc + i * sizeof(word), sizeof(word));
+  return word;
+}
+
+// find the NT_FILE note: count, page size, count (start, end, page) triples,
+// then count file names.  A count or a name that runs past the note ends the
+// list there.
+static void load_mappings() {
+  for (int i=0; i<core.segment_count; i++) {
+    const phdr_t *phdr = &core.segments[i];
+    if (phdr->p_type != PT_NOTE || !in_core(phdr)) {
+      continue;
+    }
+    size_t pos = phdr->p_offset;
+    size_t end = phdr->p_offset + phdr->p_filesz;
+    while (pos + sizeof(nhdr_t) <= end) {
+      nhdr_t note;
+      memcpy(&note, core.data + pos, sizeof(note));
+      size_t desc = pos + sizeof(nhdr_t) + (((size_t)note.n_namesz + 3) & ~(size_t)3);
+      pos = desc + (((size_t)note.n_descsz + 3) & ~(size_t)3);
+      size_t words = note.n_descsz / sizeof(unsigned long);
+      if (note.n_type != NT_FILE || pos > end || words < 2) {
+        continue;
+      }
+      unsigned long count = note_word(desc, 0);
+      unsigned long page_size = note_word(desc, 1);
+      if (count > (words - 2) / 3) {
+        fprintf(stderr, "ulog-core: NT_FILE note lists more files than it holds\n");
+        return;
+      }
+      const char *name = (const char *)core.data + desc + (2 + 3 * count) * sizeof(unsigned long);
+      const char *names_end = (const char *)core.data + desc + note.n_descsz;
+      core.mappings = calloc(count, sizeof(mapping_t));
+      for (unsigned long j=0; core.mappings != NULL && j<count; j++) {
+        const char *nul = memchr(name, '\0', (size_t)(names_end - name));
+        if (nul == NULL) {
+          fprintf(stderr, "ulog-core: NT_FILE note cut after %lu files\n", j);
+          return;
+        }
+        mapping_t *mapping = &core.mappings[j];
+        mapping->start = note_word(desc, 2 + 3 * j);
+        mapping->end = note_word(desc, 3 + 3 * j);
+        mapping->offset = note_word(desc, 4 + 3 * j) * page_size;
+        mapping->path = name;
+        name = nul + 1;
+        core.mapping_count++;
+      }
+      return;
+    }
+  }
+}
+
+static bool read_mapped(uintptr_t address, void *buf, size_t len) {
+  for (int i=0; i<core.mapping_count; i++) {
+    mapping_t *mapping = &core.mappings[i];
+    if (address < mapping->start || address + len > mapping->end) {
+      continue;
+    }
+    if (mapping->file == NULL) {
+      const char *path = mapping->path;
+      if (core.executable != NULL &&
+          strcmp(base_name(path), base_name(core.executable)) == 0) {
+        path = core.executable;
+      }
+      mapping->file = fopen(path, "rb");
+      if (mapping->file == NULL) {
+        return false;
+      }
+    }
+    return fseek(mapping->file, (long)(mapping->offset + (address - mapping->start)),
+                 SEEK_SET) == 0 &&
+           fread(buf, 1, len, mapping->file) == len;
+  }
+  return false;
+}
+
+// copy len bytes at address in the crashed process into buf.  They may span
+// segments, as ulog_config spans .data and .bss.
+static bool read_memory(uintptr_t address, void *buf, size_t len) {
+  uint8_t *out = buf;
+  while (len > 0) {
+    size_t n = 0;
+    for (int i=0; i<core.segment_count && n == 0; i++) {
+      const phdr_t *phdr = &core.segments[i];
+      if (phdr->p_type == PT_LOAD && address >= phdr->p_vaddr &&
+          address < phdr->p_vaddr + phdr->p_filesz && in_core(phdr)) {
+        n = phdr->p_vaddr + phdr->p_filesz - address;
+        n = (n < len) ? n : len;
+        memcpy(out, core.data + phdr->p_offset + (address - phdr->p_vaddr), n);
+      }
+    }
+    if (n == 0) {
+      return read_mapped(address, out, len);
+    }
+    address += n;
+    out += n;
+    len -= n;
+  }
+  return true;
+}
+
+// the NUL terminated string at address, or NULL if it cannot be read
+static const char *read_string(const void *address) {
+  uintptr_t at = (uintptr_t)address;
+  for (string_t *s = core.strings; s != NULL; s = s->next) {
+    if (s->address == at) {
+      return s->text;
+    }
+  }
+  char text[STRING_MAX];
+  int len = 0;
+  for (;;) {
+    if (at == 0 || !read_memory(at + len, &text[len], 1)) {
+      return NULL;
+    }
+    if (text[len] == '\0') {
+      break;
+    }
+    if (++len == STRING_MAX - 1) {
+      text[len] = '\0';        // cut
+      break;
+    }
+  }
+  string_t *s = malloc(sizeof(string_t));
+  if (s == NULL || (s->text = strdup(text)) == NULL) {
+    free(s);
+    return NULL;
+  }
+  s->address = at;
+  s->next = core.strings;
+  core.strings = s;
+  return s->text;
+}
+
+static void print_message(ulog_level_t severity, const void *file, int line, const char *msg) {
+  const char *name = read_string(file);
+  printf("%s %s:%d: %s\n", ulog_level_name(severity), name ? name : "?", line, msg);
+}
+
+static bool valid_header(const ulog_core_header_t *header) {
+  switch (header->kind) {
+  case ULOG_CORE_MESSAGE:
+    return header->size == ULOG_MAX_MESSAGE_LENGTH;
+  case ULOG_CORE_DEFERRED:
+    return header->size == sizeof(ulog_core_ring_t);
+  case ULOG_CORE_QUEUE:
+    return header->size == sizeof(ulog_core_queue_t);
+  default:
+    return false;
+  }
+}
+
+// the headers listed by the registry, or -1 if there is none that holds up
+static int find_registry(ulog_core_header_t *headers) {
+  for (int i=0; i<core.segment_count; i++) {
+    const phdr_t *phdr = &core.segments[i];
+    if (phdr->p_type != PT_LOAD || !in_core(phdr)) {
+      continue;
+    }
+    for (size_t at = 0; at + sizeof(ulog_core_registry_t) <= phdr->p_filesz; at += 4) {
+      ulog_core_registry_t registry;
+      memcpy(&registry, core.data + phdr->p_offset + at, sizeof(registry));
+      if (registry.magic != ULOG_CORE_MAGIC || registry.version != ULOG_CORE_VERSION ||
+          registry.pointer_size != sizeof(void *) || registry.count == 0 ||
+          registry.count > ULOG_CORE_BUFFERS) {
+        continue;
+      }
+      int n = 0;
+      while (n < (int)registry.count &&
+             read_memory((uintptr_t)registry.headers[n], &headers[n], sizeof(headers[n])) &&
+             headers[n].magic == ULOG_CORE_HEADER_MAGIC && valid_header(&headers[n])) {
+        n++;
+      }
+      if (n == (int)registry.count) {
+        return n;
+      }
+    }
+  }
+  return -1;
+}
+
+// without a registry, the first ULOG_CORE_BUFFERS headers found in the core
+static int scan_headers(ulog_core_header_t *headers) {
+  int n = 0;
+  for (int i=0; i<core.segment_count; i++) {
+    const phdr_t *phdr = &core.segments[i];
+    if (phdr->p_type != PT_LOAD || !in_core(phdr)) {
+      continue;
+    }
+    for (size_t at = 0; at + sizeof(ulog_core_header_t) <= phdr->p_filesz; at += 4) {
+      ulog_core_header_t header;
+      memcpy(&header, core.data + phdr->p_offset + at, sizeof(header));
+      if (header.magic == ULOG_CORE_HEADER_MAGIC && valid_header(&header)) {
+        if (n == ULOG_CORE_BUFFERS) {
+          fprintf(stderr, "ulog-core: more than %d buffer headers, ignoring the rest\n",
+                  ULOG_CORE_BUFFERS);
+          return n;
+        }
+        headers[n++] = header;
+      }
+    }
+  }
+  return n;
+}
+
+static void print_queue(const ulog_core_header_t *header) {
+  ulog_core_queue_t queue;
+  if (!read_memory((uintptr_t)header->data, &queue, sizeof(queue))) {
+    printf("# queue of subscriber %d: unreadable\n", header->index);
+    return;
+  }
+  if (queue.count == 0) {
+    return;
+  }
+  if (queue.count < 0 || queue.count > ULOG_ASYNC_QUEUE_DEPTH ||
+      queue.head < 0 || queue.head >= ULOG_ASYNC_QUEUE_DEPTH) {
+    printf("# queue of subscriber %d: damaged\n", header->index);
+    return;
+  }
+  printf("# queue of subscriber %d: %d messages\n", header->index, queue.count);
+  for (int i=0; i<queue.count; i++) {
+    ulog_core_message_t *entry = &queue.entries[(queue.head + i) % ULOG_ASYNC_QUEUE_DEPTH];
+    entry->msg[ULOG_MAX_MESSAGE_LENGTH - 1] = '\0';
+    print_message(entry->severity, entry->file, entry->line, entry->msg);
+  }
+}
+
+#if (ULOG_DEFERRED == 1)
+
+static const char *relocate(const char *p, void *arg) {
+  (void)arg;
+  const char *s = read_string(p);
+  return (s != NULL) ? s : "(unreadable)";
+}
+
+// render a record as ulog_deferred_flush() would have
+static void render(const ulog_core_record_t *header, const uint8_t *args, int len,
+                   char *msg, int size) {
+  if (header->text) {
+    len = (len < size) ? len : size - 1;
+    memcpy(msg, args, len);
+    msg[len] = '\0';
+    return;
+  }
+  uint8_t record[ULOG_DEFERRED_RECORD_SIZE];
+  const char *fmt = read_string(header->fmt);
+  if (fmt == NULL || len > (int)sizeof(record)) {
+    snprintf(msg, size, "(format at %p unreadable)", (const void *)header->fmt);
+    return;
+  }
+  memcpy(record, args, len);
+  if (ulog_capture_relocate(record, len, fmt, relocate, NULL) < 0) {
+    snprintf(msg, size, "(record does not match \"%s\")", fmt);
+    return;
+  }
+  ulog_capture_render(msg, size, fmt, record, len);
+}
+
+static void print_ring(const ulog_core_header_t *header) {
+  static ulog_core_ring_t ring;
+  if (!read_memory((uintptr_t)header->data, &ring, sizeof(ring))) {
+    printf("# deferred ring: unreadable\n");
+    return;
+  }
+  printf("# deferred ring: %lu bytes pending\n", (unsigned long)ring.used);
+  uint32_t tail = ring.tail;
+  uint32_t wrap = ring.wrap;
+  uint32_t used = ring.used;
+  while (used > 0) {
+    ulog_core_record_t record;
+    if (tail >= wrap) {
+      tail = 0;
+      wrap = ULOG_DEFERRED_BUFFER_SIZE;
+    }
+    if (tail + sizeof(record) > ULOG_DEFERRED_BUFFER_SIZE) {
+      break;
+    }
+    memcpy(&record, &ring.data[tail], sizeof(record));
+    if (record.size < sizeof(record) || record.size > used ||
+        tail + record.size > ULOG_DEFERRED_BUFFER_SIZE) {
+      printf("# deferred ring: damaged record at %lu\n", (unsigned long)tail);
+      return;
+    }
+    char msg[ULOG_MAX_MESSAGE_LENGTH];
+    render(&record, &ring.data[tail + sizeof(record)], record.size - (int)sizeof(record),
+           msg, sizeof(msg));
+    print_message((ulog_level_t)record.severity, record.file, record.line, msg);
+    tail += record.size;
+    used -= record.size;
+  }
+}
+
+#endif
+
+static void print_last(const ulog_core_header_t *header) {
+  char msg[ULOG_MAX_MESSAGE_LENGTH];
+  if (read_memory((uintptr_t)header->data, msg, sizeof(msg))) {
+    msg[sizeof(msg) - 1] = '\0';
+    printf("# last message formatted\n%s\n", msg);
+  }
+}
+
+int main(int argc, char **argv) {
+  ulog_core_header_t headers[ULOG_CORE_BUFFERS];
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <core> [executable]\n", argv[0]);
+    return 2;
+  }
+  core.executable = (argc > 2) ? argv[2] : NULL;
+  if (!load(argv[1])) {
+    return 1;
+  }
+  load_mappings();
+  int n = find_registry(headers);
+  if (n < 0) {
+    n = scan_headers(headers);
+    fprintf(stderr, "ulog-core: no registry, %d buffer headers found\n", n);
+  }
+
+  for (int i=0; i<n; i++) {
+    if (headers[i].kind == ULOG_CORE_QUEUE) {
+      print_queue(&headers[i]);
+    }
+  }
+  for (int i=0; i<n; i++) {
+    if (headers[i].kind == ULOG_CORE_DEFERRED) {
+#if (ULOG_DEFERRED == 1)
+      print_ring(&headers[i]);
+#else
+      fprintf(stderr, "ulog-core: build with ULOG_DEFERRED to read the deferred ring\n");
+#endif
+    }
+  }
+  for (int i=0; i<n; i++) {
+    if (headers[i].kind == ULOG_CORE_MESSAGE) {
+      print_last(&headers[i]);
+    }
+  }
+  return (n > 0) ? 0 : 1;
+}
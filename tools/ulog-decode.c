@@ -0,0 +1,417 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog-decode.c
+ *
+ * \brief print binary logs as text, decoding their chunks on every core
+ *
+ * Build:
+ *
+ *     cc -O2 -pthread -Isrc tools/ulog-decode.c src/ulog.c -o ulog-decode
+ *
+ * Usage:
+ *
+ *     ulog-decode [-j N] <binary log>...
+ *
+ * Prints every message of what ulog_binlog_logger() wrote (see
+ * ulog_binlog.h), in file order, one line each as ulog-columnar query
+ * --print does.  The file is mapped and cut into spans of SPAN_SIZE bytes;
+ * N threads (one per core by default) each take a span, decode the chunks
+ * that start in it into a buffer of their own, and take the next span.  The
+ * main thread writes the buffers out in span order.  At most WINDOW_PER_THREAD
+ * spans per thread are in flight, so memory stays bounded whatever the size
+ * of the log.
+ *
+ * A chunk carries the site records of its own messages, so no thread needs
+ * another's.  A damaged record costs the rest of its chunk: decoding resumes
+ * at the next chunk record.  A site id above ULOG_BINLOG_SITES counts as
+ * damage, so build with the setting of the writer.  The time taken, and the records decoded per
+ * second and per second of each thread, go to stderr.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ulog_binlog.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SPAN_SIZE (1 << 20)
+#define WINDOW_PER_THREAD 2
+#define THREADS_MAX 256
+#define MAGIC_SIZE (sizeof(ULOG_BINLOG_MAGIC) - 1)
+#define SYNC_SIZE (sizeof(ULOG_BINLOG_SYNC) - 1)
+#define CHUNK_RECORD_SIZE (1 + SYNC_SIZE + 8)
+#define SITE_HEADER_SIZE (1 + 4 + 4 + 2)
+#define MESSAGE_HEADER_SIZE (1 + 8 + 4 + 4 + 1 + 2)
+
+typedef struct {
+  char *data;
+  size_t size;
+  size_t capacity;
+} buffer_t;
+
+// a site record of the current chunk, pointing into the mapped file
+typedef struct {
+  uint64_t chunk;           // offset of the chunk it was read in
+  uint32_t line;
+  uint16_t length;
+  const char *file;
+} site_t;
+
+// the text of one span, handed from a thread to the writer
+typedef struct {
+  buffer_t text;
+  uint64_t records;
+  uint64_t chunks;
+  uint64_t damaged;         // offset of the first damaged record, or 0
+  int damages;
+  bool done;
+} span_t;
+
+// what one thread keeps from span to span
+typedef struct {
+  site_t *sites;            // by id
+  uint32_t site_capacity;
+  time_t second;            // of the time text below
+  char second_text[24];     // 2026-10-18T13:05:00
+  uint64_t ns;              // spent decoding
+} worker_t;
+
+static struct {
+  const uint8_t *data;
+  size_t size;
+  size_t span_count;
+  size_t next;              // next span to decode
+  size_t written;           // next span to write
+  span_t *spans;            // window of spans, by span number modulo window
+  size_t window;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+} decode = { .lock = PTHREAD_MUTEX_INITIALIZER, .changed = PTHREAD_COND_INITIALIZER };
+
+static uint64_t now_ns() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static uint64_t get(const uint8_t *p, int bytes) {
+  uint64_t value = 0;
+  for (int i=0; i<bytes; i++) {
+    value |= (uint64_t)p[i] << (8 * i);
+  }
+  return value;
+}
+
+static void reserve(buffer_t *b, size_t more) {
+  if (b->size + more > b->capacity) {
+    b->capacity = (b->size + more) * 2;
+    b->data = realloc(b->data, b->capacity);
+    if (b->data == NULL) {
+      fprintf(stderr, "ulog-decode: out of memory\n");
+      exit(1);
+    }
+  }
+}
+
+static void append(buffer_t *b, const void *data, size_t len) {
+  memcpy(&b->data[b->size], data, len);
+  b->size += len;
+}
+
+// the decimal digits of value, at least width of them
+static void append_uint(buffer_t *b, uint64_t value, int width) {
+  char digits[20];
+  int n = 0;
+  do {
+    digits[n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value != 0 || n < width);
+  while (n > 0) {
+    b->data[b->size++] = digits[--n];
+  }
+}
+
+// whether a chunk record starts at offset
+static bool chunk_at(size_t offset) {
+  return offset + CHUNK_RECORD_SIZE <= decode.size &&
+         decode.data[offset] == ULOG_BINLOG_CHUNK &&
+         memcmp(&decode.data[offset + 1], ULOG_BINLOG_SYNC, SYNC_SIZE) == 0 &&
+         get(&decode.data[offset + 1 + SYNC_SIZE], 8) == offset;
+}
+
+// the offset of the first chunk record at or after from, or the file size
+static size_t find_chunk(size_t from) {
+  // the sync starts with a NUL, one byte into the record
+  const uint8_t *p = &decode.data[from];
+  const uint8_t *end = &decode.data[decode.size];
+  while (p + 1 < end && (p = memchr(p + 1, '\0', end - p - 1)) != NULL) {
+    if (chunk_at(p - 1 - decode.data)) {
+      return p - 1 - decode.data;
+    }
+  }
+  return decode.size;
+}
+
+// the slot of site id, or NULL if no writer numbers a site so: the record is
+// damaged
+static site_t *site_slot(worker_t *w, uint32_t id) {
+  if (id == 0 || id > ULOG_BINLOG_SITES) {
+    return NULL;
+  }
+  if (id >= w->site_capacity) {
+    size_t capacity = ((size_t)id + 1) * 2;
+    w->sites = realloc(w->sites, capacity * sizeof(site_t));
+    if (w->sites == NULL) {
+      fprintf(stderr, "ulog-decode: out of memory\n");
+      exit(1);
+    }
+    memset(&w->sites[w->site_capacity], 0, (capacity - w->site_capacity) * sizeof(site_t));
+    w->site_capacity = (uint32_t)capacity;
+  }
+  return &w->sites[id];
+}
+
+static void append_message(worker_t *w, buffer_t *b, const uint8_t *p, uint64_t chunk) {
+  uint64_t time_us = get(&p[1], 8);
+  uint32_t id = (uint32_t)get(&p[9], 4);
+  uint32_t thread = (uint32_t)get(&p[13], 4);
+  const char *level = ulog_level_name((ulog_level_t)p[17]);
+  uint16_t length = (uint16_t)get(&p[18], 2);
+  const site_t *site = (id < w->site_capacity && w->sites[id].chunk == chunk) ? &w->sites[id] : NULL;
+  time_t second = (time_t)(time_us / 1000000);
+
+  if (second != w->second) {
+    struct tm tm;
+    gmtime_r(&second, &tm);
+    strftime(w->second_text, sizeof(w->second_text), "%Y-%m-%dT%H:%M:%S", &tm);
+    w->second = second;
+  }
+  // the time, level, file, line, thread and text, with room for the numbers
+  reserve(b, 24 + 8 + 16 + strlen(level) + (site ? site->length : 1) + 3 * 20 + length);
+  append(b, w->second_text, strlen(w->second_text));
+  b->data[b->size++] = '.';
+  append_uint(b, time_us % 1000000, 6);
+  b->data[b->size++] = ' ';
+  append(b, level, strlen(level));
+  b->data[b->size++] = ' ';
+  append(b, site ? site->file : "?", site ? site->length : 1);
+  b->data[b->size++] = ':';
+  append_uint(b, site ? site->line : 0, 1);
+  append(b, " [", 2);
+  append_uint(b, thread, 1);
+  append(b, "] ", 2);
+  append(b, &p[MESSAGE_HEADER_SIZE], length);
+  b->data[b->size++] = '\n';
+}
+
+// decodes the chunks that start in span number index
+static void decode_span(worker_t *w, size_t index, span_t *span) {
+  size_t start = index * SPAN_SIZE;
+  size_t end = (start + SPAN_SIZE < decode.size) ? start + SPAN_SIZE : decode.size;
+  size_t p = find_chunk(start);
+  uint64_t chunk = 0;
+
+  while (p < decode.size) {
+    const uint8_t *r = &decode.data[p];
+    size_t left = decode.size - p;
+    size_t size = 0;
+    if (r[0] == ULOG_BINLOG_CHUNK && chunk_at(p)) {
+      if (p >= end) {
+        break;              // the next span's
+      }
+      chunk = p;
+      size = CHUNK_RECORD_SIZE;
+      span->chunks++;
+    } else if (r[0] == ULOG_BINLOG_SITE && left >= SITE_HEADER_SIZE) {
+      size = SITE_HEADER_SIZE + get(&r[9], 2);
+      site_t *site = (size <= left) ? site_slot(w, (uint32_t)get(&r[1], 4)) : NULL;
+      if (site == NULL) {
+        size = 0;
+      } else {
+        site->chunk = chunk;
+        site->line = (uint32_t)get(&r[5], 4);
+        site->length = (uint16_t)get(&r[9], 2);
+        site->file = (const char *)&r[SITE_HEADER_SIZE];
+      }
+    } else if (r[0] == ULOG_BINLOG_MESSAGE && left >= MESSAGE_HEADER_SIZE &&
+               r[17] < ULOG_LEVEL_N) {
+      size = MESSAGE_HEADER_SIZE + get(&r[18], 2);
+      if (size <= left) {
+        append_message(w, &span->text, r, chunk);
+        span->records++;
+      }
+    }
+    if (size == 0 || size > left) {
+      span->damaged = (span->damages++ == 0) ? p : span->damaged;
+      size = find_chunk(p) - p;
+    }
+    p += size;
+  }
+}
+
+static void *decode_thread(void *arg) {
+  worker_t *w = arg;
+
+  pthread_mutex_lock(&decode.lock);
+  for (;;) {
+    while (decode.next < decode.span_count && decode.next >= decode.written + decode.window) {
+      pthread_cond_wait(&decode.changed, &decode.lock);
+    }
+    if (decode.next == decode.span_count) {
+      break;
+    }
+    size_t index = decode.next++;
+    span_t *span = &decode.spans[index % decode.window];
+    pthread_mutex_unlock(&decode.lock);
+
+    uint64_t start = now_ns();
+    decode_span(w, index, span);
+    w->ns += now_ns() - start;
+
+    pthread_mutex_lock(&decode.lock);
+    span->done = true;
+    pthread_cond_broadcast(&decode.changed);
+  }
+  pthread_mutex_unlock(&decode.lock);
+  return NULL;
+}
+
+// decodes path to stdout; adds up the records and chunks in totals
+static int decode_file(const char *path, worker_t *workers, int threads, uint64_t totals[2]) {
+  pthread_t ids[THREADS_MAX];
+  struct stat st;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    perror(path);
+    return 1;
+  }
+  decode.size = (size_t)st.st_size;
+  decode.data = (decode.size > 0) ? mmap(NULL, decode.size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+  close(fd);
+  if (decode.size > 0 && decode.data == MAP_FAILED) {
+    perror(path);
+    return 1;
+  }
+  if (decode.size < MAGIC_SIZE || memcmp(decode.data, ULOG_BINLOG_MAGIC, MAGIC_SIZE) != 0) {
+    fprintf(stderr, "ulog-decode: %s is not a uLog binary log\n", path);
+    if (decode.size > 0) {
+      munmap((void *)decode.data, decode.size);
+    }
+    return 1;
+  }
+  decode.span_count = (decode.size + SPAN_SIZE - 1) / SPAN_SIZE;
+  decode.next = 0;
+  decode.written = 0;
+  for (int t=0; t<threads; t++) {
+    pthread_create(&ids[t], NULL, decode_thread, &workers[t]);
+  }
+
+  int status = 0;
+  for (size_t index=0; index<decode.span_count; index++) {
+    span_t *span = &decode.spans[index % decode.window];
+    pthread_mutex_lock(&decode.lock);
+    while (!span->done) {
+      pthread_cond_wait(&decode.changed, &decode.lock);
+    }
+    pthread_mutex_unlock(&decode.lock);
+
+    if (fwrite(span->text.data, 1, span->text.size, stdout) != span->text.size) {
+      status = 1;
+    }
+    if (span->damages > 0) {
+      fprintf(stderr, "ulog-decode: %s: %d damaged records, the first at offset %llu\n",
+              path, span->damages, (unsigned long long)span->damaged);
+      status = 1;
+    }
+    totals[0] += span->records;
+    totals[1] += span->chunks;
+
+    pthread_mutex_lock(&decode.lock);
+    span->text.size = 0;
+    span->records = span->chunks = span->damaged = 0;
+    span->damages = 0;
+    span->done = false;
+    decode.written++;
+    pthread_cond_broadcast(&decode.changed);
+    pthread_mutex_unlock(&decode.lock);
+  }
+  for (int t=0; t<threads; t++) {
+    pthread_join(ids[t], NULL);
+  }
+  munmap((void *)decode.data, decode.size);
+  return status;
+}
+
+int main(int argc, char **argv) {
+  static worker_t workers[THREADS_MAX];
+  uint64_t totals[2] = { 0, 0 };   // records, chunks
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int first = 1;
+  int status = 0;
+
+  if (argc > 2 && strcmp(argv[1], "-j") == 0) {
+    threads = atol(argv[2]);
+    first = 3;
+  }
+  if (first >= argc || threads < 1 || threads > THREADS_MAX) {
+    fprintf(stderr, "usage: %s [-j N] <binary log>...  (N from 1 to %d)\n",
+            argv[0], THREADS_MAX);
+    return 2;
+  }
+  decode.window = (size_t)threads * WINDOW_PER_THREAD;
+  decode.spans = calloc(decode.window, sizeof(span_t));
+  if (decode.spans == NULL) {
+    fprintf(stderr, "ulog-decode: out of memory\n");
+    return 1;
+  }
+
+  uint64_t start = now_ns();
+  for (int i=first; i<argc; i++) {
+    status |= decode_file(argv[i], workers, (int)threads, totals);
+  }
+  if (fflush(stdout) != 0) {
+    perror("ulog-decode");
+    status = 1;
+  }
+  double seconds = (now_ns() - start) / 1e9;
+  uint64_t busy = 0;
+  for (int t=0; t<threads; t++) {
+    busy += workers[t].ns;
+  }
+  fprintf(stderr, "%llu records, %llu chunks in %.3f s on %ld threads: "
+          "%.0f records/s, %.0f records/s per core\n",
+          (unsigned long long)totals[0], (unsigned long long)totals[1], seconds, threads,
+          totals[0] / (seconds > 0 ? seconds : 1e-9),
+          totals[0] / (busy > 0 ? busy / 1e9 : 1e-9));
+  return status;
+}
@@ -0,0 +1,98 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog-flash.c
+ *
+ * \brief print the messages in a dump of the ulog_flash log area
+ *
+ * Build with the same ULOG_FLASH_ALIGN as the device:
+ *
+ *     cc -O2 -DULOG_FLASH_SINK=1 -Isrc tools/ulog-flash.c src/ulog_flash.c \
+ *        src/ulog.c -o ulog-flash
+ *
+ * Usage:
+ *
+ *     ulog-flash <dump> <sector_size> [--wear]
+ *
+ * The dump is the raw log area, read off the part with a programmer or the
+ * debugger; its size must be a multiple of sector_size.  Messages are printed
+ * oldest first.  With --wear, the lowest and highest sector erase counts are
+ * printed too.
+ */
+
+#include "ulog_flash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static ulog_err_t dump_read(void *ctx, uint32_t address, void *data, uint32_t len) {
+  FILE *file = ctx;
+  if (fseek(file, (long)address, SEEK_SET) != 0 || fread(data, 1, len, file) != len) {
+    return ULOG_ERR_SYSTEM;
+  }
+  return ULOG_ERR_NONE;
+}
+
+static void print_message(ulog_level_t severity, const char *msg, int len, void *arg) {
+  (void)arg;
+  printf("%s: %.*s\n", ulog_level_name(severity), len, msg);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <dump> <sector_size> [--wear]\n", argv[0]);
+    return 2;
+  }
+  FILE *file = fopen(argv[1], "rb");
+  if (file == NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+  long sector_size = atol(argv[2]);
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  if (sector_size <= 0 || size < 2 * sector_size || size % sector_size != 0) {
+    fprintf(stderr, "ulog-flash: %ld bytes is not 2 or more sectors of %ld\n",
+            size, sector_size);
+    return 1;
+  }
+
+  // a read-only driver: replay and wear never write or erase
+  ulog_flash_driver_t flash = {
+    .read = dump_read,
+    .ctx = file,
+    .sector_size = (uint32_t)sector_size,
+    .sector_count = (uint32_t)(size / sector_size),
+  };
+  int n = ulog_flash_replay(&flash, print_message, NULL);
+  fprintf(stderr, "%d messages\n", n);
+  if (argc > 3 && strcmp(argv[3], "--wear") == 0) {
+    uint32_t min, max;
+    if (ulog_flash_wear(&flash, &min, &max) == ULOG_ERR_NONE) {
+      fprintf(stderr, "erase counts %lu..%lu\n", (unsigned long)min, (unsigned long)max);
+    }
+  }
+  fclose(file);
+  return 0;
+}
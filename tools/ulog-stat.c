@@ -0,0 +1,157 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog-stat.c
+ *
+ * \brief print the statistics a process publishes with ulog_shm_open()
+ *
+ * Build with the same ulog_config.h settings as the logging process:
+ *
+ *     cc -O2 -DULOG_STATS=1 -DULOG_SHM_STATS=1 -Isrc tools/ulog-stat.c \
+ *        -o ulog-stat
+ *
+ * Usage:
+ *
+ *     ulog-stat <pid | /shm-name> [interval_ms [count]]
+ *
+ * With an interval, a line of per-second message rates is printed every
+ * interval until count lines have been printed (forever if count is 0).
+ * Reading the page takes no lock and makes no system call in the logging
+ * process.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ulog_shm.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *level_names[ULOG_LEVEL_N] = {
+  "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "CRIT"
+};
+
+static void print_snapshot(const ulog_shm_page_t *page) {
+  const ulog_stats_t *stats = &page->stats;
+
+  printf("pid %lu, %lu updates\n",
+         (unsigned long)page->pid, (unsigned long)page->updates);
+  printf("messages:");
+  for (int i=0; i<ULOG_LEVEL_N; i++) {
+    printf(" %s=%lu", level_names[i], (unsigned long)stats->messages[i]);
+  }
+  printf(" quieted=%lu\n", (unsigned long)stats->quieted);
+  printf("async queues: queued=%lu dropped=%lu\n",
+         (unsigned long)stats->queued, (unsigned long)stats->dropped);
+  for (int i=0; i<ULOG_MAX_SUBSCRIBERS; i++) {
+    const ulog_subscriber_info_t *info = &stats->subscribers[i];
+    if (info->fn == NULL) {
+      continue;
+    }
+    printf("subscriber %d (%p): threshold=%s calls=%lu slow=%lu "
+           "avg=%luus max=%luus%s\n",
+           i, (void *)info->fn, level_names[info->threshold],
+           (unsigned long)info->timing.calls,
+           (unsigned long)info->timing.slow_calls,
+           (unsigned long)(info->timing.calls ?
+                           info->timing.total_us / info->timing.calls : 0),
+           (unsigned long)info->timing.max_us,
+           info->timing.demoted ? " DEMOTED" : "");
+  }
+  printf("lock: wait max=%luus hold max=%luus\n",
+         (unsigned long)stats->lock.wait.max_us,
+         (unsigned long)stats->lock.hold.max_us);
+}
+
+static uint32_t total_messages(const ulog_stats_t *stats) {
+  uint32_t total = 0;
+  for (int i=0; i<ULOG_LEVEL_N; i++) {
+    total += stats->messages[i];
+  }
+  return total;
+}
+
+static bool snapshot(const ulog_shm_page_t *page, ulog_shm_page_t *copy) {
+  if (!ulog_shm_read(page, copy)) {
+    fprintf(stderr, "ulog-stat: no consistent uLog page (layout mismatch?)\n");
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  char name[64];
+  ulog_shm_page_t previous, current;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <pid | /shm-name> [interval_ms [count]]\n", argv[0]);
+    return 2;
+  }
+  if (argv[1][0] == '/') {
+    snprintf(name, sizeof(name), "%s", argv[1]);
+  } else {
+    snprintf(name, sizeof(name), "/ulog.%s", argv[1]);
+  }
+  int interval_ms = (argc > 2) ? atoi(argv[2]) : 0;
+  int count = (argc > 3) ? atoi(argv[3]) : 0;
+
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) {
+    perror(name);
+    return 1;
+  }
+  const ulog_shm_page_t *page =
+    mmap(NULL, sizeof(ulog_shm_page_t), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (page == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+  if (!snapshot(page, &previous)) {
+    return 1;
+  }
+  print_snapshot(&previous);
+  if (interval_ms <= 0) {
+    return 0;
+  }
+
+  struct timespec delay = { interval_ms / 1000, (interval_ms % 1000) * 1000000L };
+  for (int n=0; count == 0 || n < count; n++) {
+    nanosleep(&delay, NULL);
+    if (!snapshot(page, &current)) {
+      return 1;
+    }
+    uint32_t delta = total_messages(&current.stats) - total_messages(&previous.stats);
+    printf("%10.0f msg/s  queued=%lu dropped=%lu\n",
+           delta * 1000.0 / interval_ms,
+           (unsigned long)current.stats.queued,
+           (unsigned long)current.stats.dropped);
+    fflush(stdout);
+    previous = current;
+  }
+  return 0;
+}
@@ -0,0 +1,383 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulog-tail.c
+ *
+ * \brief print a binary log as it grows (Linux)
+ *
+ * Build:
+ *
+ *     cc -O2 -DULOG_BINARY_LOG=1 -Isrc tools/ulog-tail.c src/ulog.c -o ulog-tail
+ *
+ * Usage:
+ *
+ *     ulog-tail [--follow] [--all] [--level L] [--site S] <binary log>
+ *
+ * Prints the messages of what ulog_binlog_logger() wrote (see ulog_binlog.h)
+ * as ulog-decode does.  With --follow, ulog-tail starts at the end of the
+ * file, sleeps in read() on an inotify watch, and prints each message as soon
+ * as the kernel has it: build the writer with ULOG_BINLOG_FLUSH=1 so that
+ * messages do not wait in its stdio buffer.  --all prints what the file
+ * already holds first.  A file truncated by a new ulog_binlog_open() is
+ * followed from its start again.  A damaged record, such as a site id above
+ * ULOG_BINLOG_SITES, is reported and skipped up to the next chunk.
+ *
+ * --level keeps that level and above, and --site the call sites whose file
+ * name contains S, or the one at S given as FILE:LINE.  Both are decided from
+ * the record header and the site record, so the messages they drop are never
+ * formatted: following a busy log for its errors costs little more than
+ * reading it.  To keep messages out of the file in the first place, raise the
+ * level of the subscriber, or turn call sites off with ulogctl.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ulog_binlog.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAGIC_SIZE (sizeof(ULOG_BINLOG_MAGIC) - 1)
+#define SYNC_SIZE (sizeof(ULOG_BINLOG_SYNC) - 1)
+#define CHUNK_RECORD_SIZE (1 + SYNC_SIZE + 8)
+#define SITE_HEADER_SIZE (1 + 4 + 4 + 2)
+#define MESSAGE_HEADER_SIZE (1 + 8 + 4 + 4 + 1 + 2)
+#define READ_SIZE 65536
+
+typedef struct {
+  char *file;               // NULL: no site record seen
+  uint32_t line;
+  bool wanted;              // passes --site
+} site_t;
+
+static struct {
+  ulog_level_t level;
+  const char *site;         // --site, or NULL
+  const char *colon;        // the ':' of a --site FILE:LINE
+  uint32_t line;
+} filter;
+
+static struct {
+  uint8_t *data;            // bytes read and not yet parsed
+  size_t size;
+  size_t capacity;
+  uint64_t offset;          // file offset of data[0]
+  uint64_t quiet;           // print nothing before this offset
+  bool resync;              // looking for a chunk record after damage
+  site_t *sites;            // by id
+  uint32_t site_count;
+} tail;
+
+static uint64_t get(const uint8_t *p, int bytes) {
+  uint64_t value = 0;
+  for (int i=0; i<bytes; i++) {
+    value |= (uint64_t)p[i] << (8 * i);
+  }
+  return value;
+}
+
+static void *grow(void *data, size_t size) {
+  data = realloc(data, size);
+  if (data == NULL) {
+    fprintf(stderr, "ulog-tail: out of memory\n");
+    exit(1);
+  }
+  return data;
+}
+
+// whether a chunk record starts at p, offset bytes into the file
+static bool chunk_at(const uint8_t *p, uint64_t offset) {
+  return p[0] == ULOG_BINLOG_CHUNK && memcmp(&p[1], ULOG_BINLOG_SYNC, SYNC_SIZE) == 0 &&
+         get(&p[1 + SYNC_SIZE], 8) == offset;
+}
+
+static bool site_wanted(const char *file, uint32_t line) {
+  if (filter.site == NULL) {
+    return true;
+  }
+  if (filter.colon == NULL) {
+    return strstr(file, filter.site) != NULL;
+  }
+  // FILE:LINE: the file name ends in FILE
+  size_t length = (size_t)(filter.colon - filter.site);
+  size_t file_length = strlen(file);
+  return line == filter.line && file_length >= length &&
+         memcmp(&file[file_length - length], filter.site, length) == 0;
+}
+
+static void add_site(const uint8_t *p) {
+  uint32_t id = (uint32_t)get(&p[1], 4);
+  uint32_t length = (uint32_t)get(&p[9], 2);
+  if (id >= tail.site_count) {
+    size_t count = ((size_t)id + 1) * 2;
+    tail.sites = grow(tail.sites, count * sizeof(site_t));
+    memset(&tail.sites[tail.site_count], 0, (count - tail.site_count) * sizeof(site_t));
+    tail.site_count = (uint32_t)count;
+  }
+  site_t *site = &tail.sites[id];
+  if (site->file == NULL) {   // repeated in every chunk that uses it
+    site->file = grow(NULL, length + 1);
+    memcpy(site->file, &p[SITE_HEADER_SIZE], length);
+    site->file[length] = '\0';
+    site->line = (uint32_t)get(&p[5], 4);
+    site->wanted = site_wanted(site->file, site->line);
+  }
+}
+
+static void print_message(const uint8_t *p) {
+  uint64_t time_us = get(&p[1], 8);
+  uint32_t id = (uint32_t)get(&p[9], 4);
+  ulog_level_t level = (ulog_level_t)p[17];
+  const site_t *site = (id < tail.site_count && tail.sites[id].file) ? &tail.sites[id] : NULL;
+
+  if (level < filter.level || (site ? !site->wanted : filter.site != NULL)) {
+    return;
+  }
+  char when[40];
+  time_t seconds = (time_t)(time_us / 1000000);
+  struct tm tm;
+  gmtime_r(&seconds, &tm);
+  int n = (int)strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", &tm);
+  snprintf(&when[n], sizeof(when) - n, ".%06u", (unsigned)(time_us % 1000000));
+  printf("%s %s %s:%u [%u] %.*s\n", when, ulog_level_name(level),
+         site ? site->file : "?", site ? site->line : 0, (unsigned)get(&p[13], 4),
+         (int)get(&p[18], 2), (const char *)&p[MESSAGE_HEADER_SIZE]);
+}
+
+// the size of the complete record at p, 0 if it is not all there yet, or -1
+// if it is damaged
+static long record_size(const uint8_t *p, size_t left, uint64_t offset) {
+  size_t size;
+  if (p[0] == ULOG_BINLOG_CHUNK) {
+    size = CHUNK_RECORD_SIZE;
+  } else if (p[0] == ULOG_BINLOG_SITE) {
+    if (left >= SITE_HEADER_SIZE && (get(&p[1], 4) == 0 || get(&p[1], 4) > ULOG_BINLOG_SITES)) {
+      return -1;            // no writer numbers a site so
+    }
+    size = (left < SITE_HEADER_SIZE) ? SITE_HEADER_SIZE : SITE_HEADER_SIZE + get(&p[9], 2);
+  } else if (p[0] == ULOG_BINLOG_MESSAGE) {
+    if (left >= MESSAGE_HEADER_SIZE && p[17] >= ULOG_LEVEL_N) {
+      return -1;
+    }
+    size = (left < MESSAGE_HEADER_SIZE) ? MESSAGE_HEADER_SIZE : MESSAGE_HEADER_SIZE + get(&p[18], 2);
+  } else {
+    return -1;
+  }
+  if (size > left) {
+    return 0;
+  }
+  return (p[0] == ULOG_BINLOG_CHUNK && !chunk_at(p, offset)) ? -1 : (long)size;
+}
+
+// prints the complete records read, and keeps the rest for the next read
+static void parse() {
+  size_t p = 0;
+  while (p < tail.size) {
+    uint64_t offset = tail.offset + p;
+    if (tail.resync) {
+      if (tail.size - p < CHUNK_RECORD_SIZE) {
+        break;
+      }
+      if (chunk_at(&tail.data[p], offset)) {
+        tail.resync = false;
+      } else {
+        p++;
+        continue;
+      }
+    }
+    long size = record_size(&tail.data[p], tail.size - p, offset);
+    if (size == 0) {
+      break;
+    }
+    if (size < 0) {
+      fprintf(stderr, "ulog-tail: damaged record at offset %llu, skipped to the next chunk\n",
+              (unsigned long long)offset);
+      tail.resync = true;
+      p++;
+      continue;
+    }
+    if (tail.data[p] == ULOG_BINLOG_SITE) {
+      add_site(&tail.data[p]);
+    } else if (tail.data[p] == ULOG_BINLOG_MESSAGE && offset >= tail.quiet) {
+      print_message(&tail.data[p]);
+    }
+    p += size;
+  }
+  memmove(tail.data, &tail.data[p], tail.size - p);
+  tail.size -= p;
+  tail.offset += p;
+}
+
+// reads what the file holds past what was read; false on a read error
+static bool read_more(int fd) {
+  for (;;) {
+    if (tail.capacity - tail.size < READ_SIZE) {
+      tail.capacity = tail.size + READ_SIZE;
+      tail.data = grow(tail.data, tail.capacity);
+    }
+    ssize_t n = read(fd, &tail.data[tail.size], tail.capacity - tail.size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return n == 0;
+    }
+    tail.size += (size_t)n;
+    parse();
+  }
+}
+
+// the offset of the last chunk record in the file, where --follow starts
+// reading so that it has the site records of the messages that follow
+static uint64_t last_chunk(int fd, uint64_t size) {
+  uint64_t window = READ_SIZE;
+  uint8_t *data = NULL;
+  for (;;) {
+    uint64_t start = (size > window) ? size - window : 0;
+    data = grow(data, size - start);
+    if (pread(fd, data, size - start, (off_t)start) != (ssize_t)(size - start)) {
+      break;
+    }
+    for (uint64_t p = size - start; p-- > 0; ) {
+      if (p + CHUNK_RECORD_SIZE <= size - start && chunk_at(&data[p], start + p)) {
+        free(data);
+        return start + p;
+      }
+    }
+    if (start == 0) {
+      break;
+    }
+    window *= 2;
+  }
+  free(data);
+  return MAGIC_SIZE;
+}
+
+// starts over at offset, checking the magic when that is the start
+static bool restart(int fd, uint64_t offset) {
+  char magic[MAGIC_SIZE];
+  if (pread(fd, magic, MAGIC_SIZE, 0) != (ssize_t)MAGIC_SIZE ||
+      memcmp(magic, ULOG_BINLOG_MAGIC, MAGIC_SIZE) != 0 ||
+      lseek(fd, (off_t)offset, SEEK_SET) < 0) {
+    return false;
+  }
+  tail.size = 0;
+  tail.offset = offset;
+  tail.resync = false;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  bool follow = false;
+  bool all = false;
+  const char *path = NULL;
+  bool ok = true;
+
+  filter.level = ULOG_TRACE_LEVEL;
+  for (int i=1; ok && i<argc; i++) {
+    if (strcmp(argv[i], "--follow") == 0 || strcmp(argv[i], "-f") == 0) {
+      follow = true;
+    } else if (strcmp(argv[i], "--all") == 0) {
+      all = true;
+    } else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+      filter.level = ulog_level_parse(argv[++i]);
+      ok = filter.level < ULOG_LEVEL_N;
+    } else if (strcmp(argv[i], "--site") == 0 && i + 1 < argc) {
+      filter.site = argv[++i];
+      filter.colon = strrchr(filter.site, ':');
+      if (filter.colon != NULL) {
+        char *end;
+        filter.line = (uint32_t)strtoul(&filter.colon[1], &end, 10);
+        ok = *end == '\0' && end != &filter.colon[1];
+      }
+    } else {
+      ok = path == NULL && argv[i][0] != '-';
+      path = argv[i];
+    }
+  }
+  if (!ok || path == NULL) {
+    fprintf(stderr, "usage: %s [--follow] [--all] [--level L] [--site S] <binary log>\n",
+            argv[0]);
+    return 2;
+  }
+
+  int fd = open(path, O_RDONLY);
+  int watch = follow ? inotify_init1(IN_CLOEXEC) : -1;
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 ||
+      (follow && (watch < 0 || inotify_add_watch(watch, path, IN_MODIFY) < 0))) {
+    perror(path);
+    return 1;
+  }
+  // the watch is in place before the first read: nothing written after it
+  // goes unnoticed
+  uint64_t start = MAGIC_SIZE;
+  if (follow && !all) {
+    start = last_chunk(fd, (uint64_t)st.st_size);
+    tail.quiet = (uint64_t)st.st_size;
+  }
+  if (!restart(fd, start)) {
+    fprintf(stderr, "ulog-tail: %s is not a uLog binary log\n", path);
+    return 1;
+  }
+
+  for (;;) {
+    if (!read_more(fd)) {
+      perror(path);
+      return 1;
+    }
+    fflush(stdout);
+    if (!follow) {
+      break;
+    }
+    char events[sizeof(struct inotify_event) + NAME_MAX + 1]
+      __attribute__((aligned(__alignof__(struct inotify_event))));
+    if (read(watch, events, sizeof(events)) < 0 && errno != EINTR) {
+      perror(path);
+      return 1;
+    }
+    if (fstat(fd, &st) == 0 && (uint64_t)st.st_size < tail.offset + tail.size) {
+      fprintf(stderr, "ulog-tail: %s was truncated, following it from the start\n", path);
+      tail.quiet = 0;
+      while (!restart(fd, MAGIC_SIZE)) {
+        // the writer has not put the magic back yet
+        if (read(watch, events, sizeof(events)) < 0 && errno != EINTR) {
+          perror(path);
+          return 1;
+        }
+      }
+    }
+  }
+  if (tail.size > 0 && !tail.resync) {
+    fprintf(stderr, "ulog-tail: %s ends in the middle of a record\n", path);
+  }
+  return 0;
+}
@@ -0,0 +1,87 @@
+/**
+MIT License
+
+Copyright (c) 2019 R. Dunbar Poor <rdpoor@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * \file ulogctl.c
+ *
+ * \brief send a command to a process serving ulog_ctl_open()
+ *
+ * Build:
+ *
+ *     cc -O2 tools/ulogctl.c -o ulogctl
+ *
+ * Usage:
+ *
+ *     ulogctl <pid | /path/to/socket> <command> [args...]
+ *
+ * e.g. "ulogctl 1234 level 0 DEBUG" or "ulogctl 1234 site net.c:88 off".
+ * See src/ulog_ctl.h for the commands.  The exit status is 0 if the reply
+ * ends with "ok".
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+  struct sockaddr_un address;
+  char command[256] = "";
+  char reply[512];
+  int ok = 0;
+
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <pid | /path/to/socket> <command> [args...]\n", argv[0]);
+    return 2;
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (argv[1][0] == '/') {
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", argv[1]);
+  } else {
+    snprintf(address.sun_path, sizeof(address.sun_path), "/tmp/ulog.%s.sock", argv[1]);
+  }
+  for (int i=2; i<argc; i++) {
+    size_t n = strlen(command);
+    snprintf(&command[n], sizeof(command) - n, "%s%s", (i > 2) ? " " : "", argv[i]);
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+    perror(address.sun_path);
+    return 1;
+  }
+  FILE *stream = fdopen(fd, "r+");
+  fprintf(stream, "%s\n", command);
+  fflush(stream);
+  shutdown(fd, SHUT_WR);
+  while (fgets(reply, sizeof(reply), stream) != NULL) {
+    fputs(reply, stdout);
+    ok = (strcmp(reply, "ok\n") == 0);
+  }
+  fclose(stream);
+  return ok ? 0 : 1;
+}